@@ -0,0 +1,244 @@
+// Raw CPU dispatch throughput, with and without the MMU.
+//
+// Runs the same instruction stream for a fixed number of Step() calls on
+// BasicCpu<FlatBus> (plain RAM, accesses inline), on CPU over a full
+// MMU (mapper dispatch, I/O and scheduler ticks), on the MMU computing
+// every flag, and where supported on the MMU through FastmemBus, and
+// prints millions of Step() calls per second, ns per call and emulated
+// MHz for each. Fused pairs and skipped flags let one call run several
+// instructions, so emulated MHz is the figure to compare.
+//
+//   gameboy-emu-bench-cpu [rom.gb] [--steps N]
+//
+// Without a ROM two built-in loops are timed: ALU ops, and BIT/RES/SET
+// and CB rotates. A ROM's first 32 KiB are copied into the flat bus so
+// both runs start from the same code.
+//
+// The copy/fill section runs a ROM-to-VRAM copy loop and a WRAM fill loop
+// on the MMU for the same emulated time with bulk loops off and on.
+//
+// Finally the per-instruction interrupt check is timed on its own: IE and
+// IF read through the MMU (what the CPU did before the MMU cached them)
+// against MMU::pending_interrupts().
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gb/cpu.h"
+#include "gb/fastmem.h"
+#include "gb/flat_bus.h"
+#include "gb/mmu.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<uint8_t> MakeRom(const std::vector<uint8_t>& code) {
+  std::vector<uint8_t> rom(2 * gb::kBankSize, 0x00);
+  std::copy(code.begin(), code.end(), rom.begin() + 0x0100);
+  return rom;
+}
+
+std::vector<uint8_t> AluRom() {
+  return MakeRom({
+      0x0E, 0x00, // LD C,0
+      0x80,       // loop: ADD A,B
+      0xA9,       // XOR C
+      0x04,       // INC B
+      0xD6, 0x03, // SUB 3
+      0x57,       // LD D,A
+      0xE6, 0x7F, // AND 0x7F
+      0xB3,       // OR E
+      0xB8,       // CP B
+      0x0D,       // DEC C
+      0x20, 0xF3, // JR NZ,loop
+      0x1C,       // INC E
+      0x18, 0xEE, // JR 0x0100
+  });
+}
+
+std::vector<uint8_t> BitOpsRom() {
+  return MakeRom({
+      0x21, 0x00, 0xC0, // LD HL,0xC000
+      0xCB, 0xD8,       // loop: SET 3,B
+      0xCB, 0x58,       // BIT 3,B
+      0xCB, 0x98,       // RES 3,B
+      0xCB, 0x7F,       // BIT 7,A
+      0xCB, 0x31,       // SWAP C
+      0xCB, 0x12,       // RL D
+      0xCB, 0x3B,       // SRL E
+      0xCB, 0xCE,       // SET 1,(HL)
+      0xCB, 0x46,       // BIT 0,(HL)
+      0xCB, 0x8E,       // RES 1,(HL)
+      0x3D,             // DEC A
+      0x20, 0xE9,       // JR NZ,loop
+      0x18, 0xE7,       // JR loop
+  });
+}
+
+std::vector<uint8_t> CopyFillRom() {
+  return MakeRom({
+      0x21, 0x00, 0x40, // LD HL,0x4000
+      0x11, 0x00, 0x80, // LD DE,0x8000
+      0x01, 0x00, 0x20, // LD BC,0x2000
+      0x2A,             // copy: LD A,(HL+)
+      0x12,             // LD (DE),A
+      0x13,             // INC DE
+      0x0B,             // DEC BC
+      0x78,             // LD A,B
+      0xB1,             // OR C
+      0x20, 0xF8,       // JR NZ,copy
+      0x21, 0x00, 0xC0, // LD HL,0xC000
+      0xAF,             // XOR A
+      0x06, 0x00,       // LD B,0
+      0x22,             // fill: LD (HL+),A
+      0x05,             // DEC B
+      0x20, 0xFC,       // JR NZ,fill
+      0x18, 0xE3,       // JR 0x0100
+  });
+}
+
+template <typename Bus>
+void Time(const char* label, gb::BasicCpu<Bus>& cpu, uint64_t steps) {
+  cpu.Reset();
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < steps; ++i) cpu.Step();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << label << ": " << steps / seconds / 1e6 << " MIPS, "
+            << seconds * 1e9 / steps << " ns/instruction, "
+            << cpu.cycles() / seconds / 1e6 << " emulated MHz\n";
+}
+
+// An MMU running `rom`. Like Emulator::RunFrame, let the CPU see the next
+// event, or fused pairs and flag skipping never get a window.
+std::unique_ptr<gb::MMU> MakeMmu(const std::vector<uint8_t>& rom) {
+  auto mmu = std::make_unique<gb::MMU>();
+  mmu->LoadROM(rom);
+  mmu->set_idle_limit(std::numeric_limits<uint64_t>::max());
+  return mmu;
+}
+
+void Run(const std::vector<uint8_t>& rom, uint64_t steps) {
+  auto flat = std::make_unique<gb::FlatBus>();
+  std::copy_n(rom.begin(), std::min<size_t>(rom.size(), 0x8000),
+              flat->memory().begin());
+  gb::BasicCpu<gb::FlatBus> flat_cpu(*flat);
+  Time("  flat bus", flat_cpu, steps);
+
+  auto mmu = MakeMmu(rom);
+  gb::CPU mmu_cpu(*mmu);
+  Time("  MMU     ", mmu_cpu, steps);
+
+  // The same without dead-flag skipping, for the cost of flags nothing
+  // reads
+  auto flags_mmu = MakeMmu(rom);
+  gb::CPU flags_cpu(*flags_mmu);
+  flags_cpu.set_skip_dead_flags(false);
+  Time("  MMU, all flags", flags_cpu, steps);
+
+  if (!gb::FastmemBus::Supported()) return;
+  auto fast_mmu = MakeMmu(rom);
+  gb::FastmemBus fastmem(*fast_mmu);
+  if (!fastmem.ok()) return;
+  gb::BasicCpu<gb::FastmemBus> fast_cpu(fastmem);
+  Time("  fastmem ", fast_cpu, steps);
+}
+
+// Cost of one pending-interrupt check, in ns, measured over `steps`
+// checks. The IE bit is toggled per iteration so the reads cannot be
+// hoisted out of the loop.
+template <typename Check>
+double TimeCheck(gb::MMU& mmu, uint64_t steps, Check check) {
+  unsigned sink = 0;
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < steps; ++i) {
+    mmu.Write(gb::kIeAddress, static_cast<uint8_t>(i & 1));
+    sink += check(mmu);
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  volatile unsigned keep = sink;
+  (void)keep;
+  return seconds * 1e9 / steps;
+}
+
+void RunInterruptCheck(uint64_t steps) {
+  auto mmu = std::make_unique<gb::MMU>();
+  mmu->LoadROM(AluRom());
+  double base = TimeCheck(*mmu, steps, [](gb::MMU&) { return 0; });
+  double reads = TimeCheck(*mmu, steps, [](gb::MMU& m) {
+    return m.Read(gb::kIeAddress) & m.Read(gb::kIfAddress) & 0x1F;
+  });
+  double cached = TimeCheck(
+      *mmu, steps, [](gb::MMU& m) { return m.pending_interrupts(); });
+  std::cout << "  IE/IF reads: " << reads - base << " ns/check\n"
+            << "  cached mask: " << cached - base << " ns/check\n";
+}
+
+// Run the copy/fill ROM on the MMU until `cycles` have passed; returns
+// the wall time and stores the Step() calls taken
+double TimeCopyFill(bool bulk, uint64_t cycles, uint64_t* steps) {
+  auto mmu = MakeMmu(CopyFillRom());
+  gb::CPU cpu(*mmu);
+  cpu.Reset();
+  cpu.set_bulk_loops(bulk);
+  *steps = 0;
+  auto start = Clock::now();
+  for (; cpu.cycles() < cycles; ++*steps) cpu.Step();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void RunCopyFill(uint64_t steps) {
+  // Emulated time the interpreter covers in `steps` instructions
+  uint64_t cycles = steps * 12;
+  uint64_t plain_steps, bulk_steps;
+  double plain = TimeCopyFill(false, cycles, &plain_steps);
+  double bulk = TimeCopyFill(true, cycles, &bulk_steps);
+  std::cout << "  interpreted: " << cycles / plain / 1e6
+            << " emulated MHz, " << plain_steps << " steps\n"
+            << "  bulk loops:  " << cycles / bulk / 1e6 << " emulated MHz, "
+            << bulk_steps << " steps (" << plain / bulk << "x)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<uint8_t> rom;
+  uint64_t steps = 50'000'000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--steps" && i + 1 < argc) {
+      steps = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::ifstream file(arg, std::ios::binary);
+      if (!file) {
+        std::cerr << "cannot open " << arg << "\n";
+        return 1;
+      }
+      rom.assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+    }
+  }
+  if (!rom.empty()) {
+    std::cout << "ROM\n";
+    Run(rom, steps);
+    return 0;
+  }
+  std::cout << "ALU loop\n";
+  Run(AluRom(), steps);
+  std::cout << "BIT/RES/SET loop\n";
+  Run(BitOpsRom(), steps);
+  std::cout << "Copy/fill loops\n";
+  RunCopyFill(steps);
+  std::cout << "Interrupt check\n";
+  RunInterruptCheck(steps);
+  return 0;
+}
@@ -0,0 +1,152 @@
+// Throughput of the lockstep SoA engine against independent interpreters.
+//
+// Runs N copies of one ROM for a number of frames three ways on a single
+// thread: N independent Emulator::RunFrame() loops, the lockstep engine
+// with per-lane kernels, and the lockstep engine with AVX2 kernels. Prints
+// aggregate emulated MHz (sum of all lanes' T-cycles per wall second) and
+// the share of lane instructions that ran in lockstep.
+//
+//   gameboy-emu-bench-lockstep [rom.gb] [--lanes N] [--frames F]
+//
+// Without a ROM a built-in ALU loop is used; each lane gets a different
+// seed at 0xC000 so lanes diverge on branch trip counts.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gb/lockstep.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<uint8_t> BuiltinRom() {
+  std::vector<uint8_t> rom(2 * gb::kBankSize, 0x00);
+  const uint8_t code[] = {
+      0xFA, 0x00, 0xC0, // LD A,(0xC000)
+      0x47,             // LD B,A
+      0x0E, 0x40,       // LD C,0x40
+      0x80,             // loop: ADD A,B
+      0xA9,             // XOR C
+      0x04,             // INC B
+      0xD6, 0x03,       // SUB 3
+      0x57,             // LD D,A
+      0xE6, 0x7F,       // AND 0x7F
+      0xB3,             // OR E
+      0xB8,             // CP B
+      0x0D,             // DEC C
+      0x20, 0xF3,       // JR NZ,loop
+      0x1C,             // INC E
+      0xEA, 0x01, 0xC0, // LD (0xC001),A
+      0x7A,             // LD A,D
+      0xE6, 0x03,       // AND 0x03
+      0xF6, 0x40,       // OR 0x40
+      0x4F,             // LD C,A
+      0x18, 0xE7,       // JR loop
+  };
+  std::copy(std::begin(code), std::end(code), rom.begin() + 0x0100);
+  return rom;
+}
+
+std::vector<std::unique_ptr<gb::Emulator>> MakeLanes(
+    const std::vector<uint8_t>& rom, size_t count) {
+  std::vector<std::unique_ptr<gb::Emulator>> lanes;
+  for (size_t i = 0; i < count; ++i) {
+    lanes.push_back(std::make_unique<gb::Emulator>());
+    lanes.back()->LoadROM(rom);
+    lanes.back()->mmu().Write(0xC000, static_cast<uint8_t>(i));
+  }
+  return lanes;
+}
+
+uint64_t TotalCycles(const std::vector<std::unique_ptr<gb::Emulator>>& lanes) {
+  uint64_t total = 0;
+  for (const auto& lane : lanes) total += lane->mmu().cycles();
+  return total;
+}
+
+void Report(const char* label, uint64_t cycles, double seconds) {
+  std::cout << label << ": " << cycles / seconds / 1e6 << " emulated MHz ("
+            << seconds << " s)\n";
+}
+
+double Independent(const std::vector<uint8_t>& rom, size_t count,
+                   int frames) {
+  auto lanes = MakeLanes(rom, count);
+  uint64_t start_cycles = TotalCycles(lanes);
+  auto start = Clock::now();
+  for (auto& lane : lanes) {
+    for (int f = 0; f < frames; ++f) lane->RunFrame();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  Report("independent      ", TotalCycles(lanes) - start_cycles, seconds);
+  return seconds;
+}
+
+double Lockstep(const std::vector<uint8_t>& rom, size_t count, int frames,
+                bool simd) {
+  auto lanes = MakeLanes(rom, count);
+  std::vector<gb::Emulator*> raw;
+  for (auto& lane : lanes) raw.push_back(lane.get());
+  gb::LockstepEngine engine(raw, simd);
+  uint64_t start_cycles = TotalCycles(lanes);
+  auto start = Clock::now();
+  for (int f = 0; f < frames; ++f) engine.RunFrame();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  Report(simd ? "lockstep (AVX2)  " : "lockstep (scalar)",
+         TotalCycles(lanes) - start_cycles, seconds);
+
+  const auto& stats = engine.stats();
+  uint64_t total = stats.vector_instructions + stats.scalar_instructions;
+  std::cout << "  lockstep share " << 100.0 * stats.vector_instructions / total
+            << "%, mean group "
+            << static_cast<double>(stats.vector_instructions) /
+                   static_cast<double>(stats.vector_steps ? stats.vector_steps
+                                                          : 1)
+            << " lanes\n";
+  return seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<uint8_t> rom;
+  size_t count = 256;
+  int frames = 60;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--lanes" && i + 1 < argc) {
+      count = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--frames" && i + 1 < argc) {
+      frames = std::atoi(argv[++i]);
+    } else {
+      std::ifstream file(arg, std::ios::binary);
+      if (!file) {
+        std::cerr << "cannot open " << arg << "\n";
+        return 1;
+      }
+      rom.assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+    }
+  }
+  if (rom.empty()) rom = BuiltinRom();
+
+  std::cout << count << " lanes x " << frames << " frames\n";
+  double base = Independent(rom, count, frames);
+  double scalar = Lockstep(rom, count, frames, false);
+  std::cout << "  speedup " << base / scalar << "x\n";
+  if (gb::LockstepEngine::SimdSupported()) {
+    double simd = Lockstep(rom, count, frames, true);
+    std::cout << "  speedup " << base / simd << "x\n";
+  } else {
+    std::cout << "AVX2 not available on this host\n";
+  }
+  return 0;
+}
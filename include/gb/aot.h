@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gb/mbc.h"
+
+namespace gb {
+
+// Ahead-of-time compiled code. gameboy-emu-recompile turns a ROM into C++
+// with one function per straight-line run of instructions; built as a
+// shared library, it is loaded for the ROM whose hash it was made from
+// and BasicCpu runs its blocks instead of interpreting. Everything that
+// crosses the library boundary is plain C.
+
+// Bumped whenever GbAotMachine, GbAotModule or the block contract change
+inline constexpr uint32_t kAotAbiVersion = 1;
+
+extern "C" {
+
+// CPU state a block runs on. The block may not touch memory except
+// through read/write, and adds the T-cycles and instructions it ran to
+// `cycles` and `instructions`.
+struct GbAotMachine {
+  uint8_t a, f, b, c, d, e, h, l;
+  uint16_t sp, pc;
+  // The first instruction always runs; each later one only while
+  // `cycles` is below `budget` (the cycles to the bus's next event)
+  uint32_t budget;
+  uint32_t cycles;
+  uint32_t instructions;
+  void* context;
+  uint8_t (*read)(void* context, uint16_t address);
+  void (*write)(void* context, uint16_t address, uint8_t value);
+};
+
+// Runs the instructions from m->pc up to the first that writes memory,
+// transfers control or exhausts the budget, leaving m->pc after the last
+// one run. An instruction it has no code for (HALT, STOP, EI, DI, RETI,
+// LD B,B, undefined opcodes) ends it before running, so a block that
+// returns with `cycles` still 0 asks for the interpreter.
+typedef void (*GbAotBlock)(GbAotMachine* m);
+
+// Block to call when PC is at `address` with ROM bank `bank` mapped
+// there (0 below 0x4000, the switchable bank at 0x4000-0x7FFF)
+struct GbAotEntry {
+  uint16_t bank;
+  uint16_t address;
+  GbAotBlock block;
+};
+
+// What a plugin's gb_aot_module() returns: an entry for every compiled
+// instruction
+struct GbAotModule {
+  uint32_t abi_version;
+  uint64_t rom_hash; // RomHash() of the ROM it was compiled from
+  uint32_t count;
+  const GbAotEntry* entries;
+};
+
+typedef const GbAotModule* (*GbAotModuleFn)();
+
+} // extern "C"
+
+// A loaded module, with its blocks indexed by address
+class AotPlugin {
+ public:
+  // dlopen() `path` and take its module. Null, with `error` set, if it
+  // cannot be loaded or was built against another ABI version.
+  static std::unique_ptr<AotPlugin> Load(const std::string& path,
+                                         std::string* error);
+  // Wrap a module linked into the program (no library to unload)
+  static std::unique_ptr<AotPlugin> FromModule(const GbAotModule& module);
+  ~AotPlugin();
+
+  AotPlugin(const AotPlugin&) = delete;
+  AotPlugin& operator=(const AotPlugin&) = delete;
+
+  // Block compiled for `pc` with ROM bank `romx_bank` switched in at
+  // 0x4000, or null. Bank 0 switched in there (MBC5) has no code.
+  GbAotBlock Find(uint16_t pc, uint32_t romx_bank) const {
+    if (pc < kBankSize) return banks_[0][pc];
+    if (pc >= 2 * kBankSize || romx_bank == 0 || romx_bank >= banks_.size()) {
+      return nullptr;
+    }
+    const std::unique_ptr<GbAotBlock[]>& bank = banks_[romx_bank];
+    return bank ? bank[pc - kBankSize] : nullptr;
+  }
+  uint64_t rom_hash() const { return rom_hash_; }
+  // Compiled instruction addresses, over all banks
+  uint32_t entry_count() const { return count_; }
+
+  // File name a plugin for the ROM with `rom_hash` goes by
+  static std::string FileName(uint64_t rom_hash);
+
+ private:
+  AotPlugin() = default;
+  bool Index(const GbAotModule& module);
+
+  void* handle_ = nullptr;
+  uint64_t rom_hash_ = 0;
+  uint32_t count_ = 0;
+  // Per ROM bank, a block pointer per address in its window; null for
+  // banks without code
+  std::vector<std::unique_ptr<GbAotBlock[]>> banks_;
+};
+
+} // namespace gb
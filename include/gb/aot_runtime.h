@@ -0,0 +1,187 @@
+#pragma once
+
+// What the C++ gameboy-emu-recompile emits is written against: machine
+// access and one helper per instruction family, each computing exactly
+// what the BasicCpu handler it stands in for does (cpu.cpp), flags
+// included. The generated code adds only the sequencing and the
+// constant operands. aot_runtime_test.cpp holds each helper to its
+// handler over every operand and flag state.
+
+#include <cstdint>
+
+#include "gb/aot.h"
+
+#if defined(_WIN32)
+#define GB_AOT_EXPORT extern "C" __declspec(dllexport)
+#else
+#define GB_AOT_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace gb::aot {
+
+constexpr uint8_t kZ = 0x80;
+constexpr uint8_t kN = 0x40;
+constexpr uint8_t kH = 0x20;
+constexpr uint8_t kC = 0x10;
+
+inline uint8_t Read(GbAotMachine* m, uint16_t address) {
+  return m->read(m->context, address);
+}
+inline void Write(GbAotMachine* m, uint16_t address, uint8_t value) {
+  m->write(m->context, address, value);
+}
+
+inline uint16_t Pair(uint8_t high, uint8_t low) {
+  return static_cast<uint16_t>(high << 8 | low);
+}
+inline void SetPair(uint8_t& high, uint8_t& low, uint16_t value) {
+  high = static_cast<uint8_t>(value >> 8);
+  low = static_cast<uint8_t>(value);
+}
+
+// PUSH writes the high byte first
+inline void Push(GbAotMachine* m, uint16_t word) {
+  Write(m, --m->sp, static_cast<uint8_t>(word >> 8));
+  Write(m, --m->sp, static_cast<uint8_t>(word));
+}
+inline uint16_t Pop(GbAotMachine* m) {
+  uint8_t low = Read(m, m->sp++);
+  uint8_t high = Read(m, m->sp++);
+  return Pair(high, low);
+}
+
+// ADD/ADC and SUB/SBC/CP
+inline void Add(GbAotMachine* m, uint8_t value, bool use_carry) {
+  uint8_t carry = use_carry && (m->f & kC) ? 1 : 0;
+  unsigned result = m->a + value + carry;
+  uint8_t half = ((m->a & 0x0F) + (value & 0x0F) + carry) > 0x0F ? kH : 0;
+  m->a = static_cast<uint8_t>(result);
+  m->f = (m->a == 0 ? kZ : 0) | half | (result > 0xFF ? kC : 0);
+}
+inline uint8_t Subtract(GbAotMachine* m, uint8_t value, bool use_carry) {
+  uint8_t carry = use_carry && (m->f & kC) ? 1 : 0;
+  uint16_t result = static_cast<uint16_t>(m->a - value - carry);
+  uint8_t half = (m->a & 0x0F) < (value & 0x0F) + carry ? kH : 0;
+  m->f = (static_cast<uint8_t>(result) == 0 ? kZ : 0) | kN | half |
+         (result > 0xFF ? kC : 0);
+  return static_cast<uint8_t>(result);
+}
+inline void Sub(GbAotMachine* m, uint8_t value, bool use_carry) {
+  m->a = Subtract(m, value, use_carry);
+}
+inline void Cp(GbAotMachine* m, uint8_t value) { Subtract(m, value, false); }
+
+inline void And(GbAotMachine* m, uint8_t value) {
+  m->a &= value;
+  m->f = (m->a == 0 ? kZ : 0) | kH;
+}
+inline void Or(GbAotMachine* m, uint8_t value) {
+  m->a |= value;
+  m->f = m->a == 0 ? kZ : 0;
+}
+inline void Xor(GbAotMachine* m, uint8_t value) {
+  m->a ^= value;
+  m->f = m->a == 0 ? kZ : 0;
+}
+
+// 8-bit INC/DEC keep C
+inline uint8_t Inc(GbAotMachine* m, uint8_t value) {
+  auto result = static_cast<uint8_t>(value + 1);
+  m->f = (m->f & kC) | (result == 0 ? kZ : 0) |
+         ((value & 0x0F) == 0x0F ? kH : 0);
+  return result;
+}
+inline uint8_t Dec(GbAotMachine* m, uint8_t value) {
+  auto result = static_cast<uint8_t>(value - 1);
+  m->f = (m->f & kC) | (result == 0 ? kZ : 0) | kN |
+         ((value & 0x0F) == 0x00 ? kH : 0);
+  return result;
+}
+
+// ADD HL,rr keeps Z
+inline void AddHl(GbAotMachine* m, uint16_t value) {
+  uint16_t hl = Pair(m->h, m->l);
+  unsigned result = hl + value;
+  m->f = (m->f & kZ) | (((hl & 0x0FFF) + (value & 0x0FFF)) > 0x0FFF ? kH : 0) |
+         (result > 0xFFFF ? kC : 0);
+  SetPair(m->h, m->l, static_cast<uint16_t>(result));
+}
+// SP + r8 for ADD SP,r8 and LD HL,SP+r8: H and C from the low byte
+inline uint16_t AddSp(GbAotMachine* m, int8_t offset) {
+  auto result = static_cast<uint16_t>(m->sp + offset);
+  int carries = m->sp ^ offset ^ result;
+  m->f = ((carries & 0x10) ? kH : 0) | ((carries & 0x100) ? kC : 0);
+  return result;
+}
+
+inline void Daa(GbAotMachine* m) {
+  uint8_t correction = 0;
+  uint8_t carry = m->f & kC;
+  if (!(m->f & kN)) {
+    if (carry || m->a > 0x99) {
+      correction |= 0x60;
+      carry = kC;
+    }
+    if ((m->f & kH) || (m->a & 0x0F) > 0x09) correction |= 0x06;
+    m->a = static_cast<uint8_t>(m->a + correction);
+  } else {
+    if (carry) correction |= 0x60;
+    if (m->f & kH) correction |= 0x06;
+    m->a = static_cast<uint8_t>(m->a - correction);
+  }
+  m->f = (m->a == 0 ? kZ : 0) | (m->f & kN) | carry;
+}
+inline void Cpl(GbAotMachine* m) {
+  m->a = static_cast<uint8_t>(~m->a);
+  m->f = (m->f & (kZ | kC)) | kN | kH;
+}
+inline void Scf(GbAotMachine* m) { m->f = (m->f & kZ) | kC; }
+inline void Ccf(GbAotMachine* m) { m->f = (m->f & kZ) | ((m->f & kC) ^ kC); }
+
+// CB rotates and shifts, kOp being bits 5-3 of the opcode (RLC, RRC, RL,
+// RR, SLA, SRA, SWAP, SRL). They set all four flags; RLCA, RRCA, RLA and
+// RRA are the same with Z always clear.
+template <int kOp>
+inline uint8_t Shift(GbAotMachine* m, uint8_t value) {
+  uint8_t old_carry = (m->f & kC) ? 1 : 0;
+  uint8_t carry = 0;
+  uint8_t result = 0;
+  if constexpr (kOp == 0) {
+    carry = value >> 7;
+    result = static_cast<uint8_t>(value << 1 | carry);
+  } else if constexpr (kOp == 1) {
+    carry = value & 1;
+    result = static_cast<uint8_t>(value >> 1 | carry << 7);
+  } else if constexpr (kOp == 2) {
+    carry = value >> 7;
+    result = static_cast<uint8_t>(value << 1 | old_carry);
+  } else if constexpr (kOp == 3) {
+    carry = value & 1;
+    result = static_cast<uint8_t>(value >> 1 | old_carry << 7);
+  } else if constexpr (kOp == 4) {
+    carry = value >> 7;
+    result = static_cast<uint8_t>(value << 1);
+  } else if constexpr (kOp == 5) {
+    carry = value & 1;
+    result = static_cast<uint8_t>(value >> 1 | (value & 0x80));
+  } else if constexpr (kOp == 6) {
+    result = static_cast<uint8_t>(value << 4 | value >> 4);
+  } else {
+    static_assert(kOp == 7);
+    carry = value & 1;
+    result = value >> 1;
+  }
+  m->f = (result == 0 ? kZ : 0) | (carry ? kC : 0);
+  return result;
+}
+template <int kOp>
+inline void ShiftA(GbAotMachine* m) {
+  m->a = Shift<kOp>(m, m->a);
+  m->f &= kC;
+}
+// BIT n: Z from the bit, H set, C kept
+inline void Bit(GbAotMachine* m, uint8_t mask, uint8_t value) {
+  m->f = (m->f & kC) | kH | ((value & mask) ? 0 : kZ);
+}
+
+} // namespace gb::aot
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gb/emulator.h"
+
+namespace gb {
+
+// Bytes one instance contributes to a batch output tensor
+static constexpr size_t kFrameBytes = kScreenWidth * kScreenHeight;
+
+// Steps many emulators one frame in lockstep.
+//
+// Unlike ThreadPool there is no stealing: the instances are split into
+// contiguous shards, one per worker, so for a fixed batch the same
+// instance always runs on the same (optionally CPU-pinned) thread and its
+// state stays in that core's caches between frames. Frames of one game
+// take near-identical time, so static sharding loses little to imbalance.
+class BatchRunner {
+ public:
+  // `threads == 0` uses one worker per hardware thread. With `pin`, worker
+  // i is bound to CPU i (Linux only; elsewhere it is a no-op).
+  explicit BatchRunner(size_t threads = 0, bool pin = true);
+  ~BatchRunner();
+
+  BatchRunner(const BatchRunner&) = delete;
+  BatchRunner& operator=(const BatchRunner&) = delete;
+
+  // Advance every instance by one frame and return once all are done.
+  // Calls must not overlap; instances must be distinct.
+  // If `frames` is non-null, instance i's framebuffer is copied to
+  // frames + i * kFrameBytes, giving a contiguous N x 144 x 160 tensor.
+  void RunFrame(Emulator* const* emulators, size_t count, uint8_t* frames);
+
+  size_t size() const { return threads_.size(); }
+
+ private:
+  // Worker main loop
+  void Run(size_t index);
+  // Step this worker's shard of the current batch
+  void RunShard(size_t index);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  // Current batch, published under mutex_ and read by workers after they
+  // observe a new generation
+  Emulator* const* emulators_ = nullptr;
+  size_t count_ = 0;
+  uint8_t* frames_ = nullptr;
+  uint64_t generation_ = 0;
+  size_t running_ = 0; // Workers still busy with the current generation
+  bool stop_ = false;
+};
+
+} // namespace gb
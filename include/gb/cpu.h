@@ -1,7 +1,15 @@
 #pragma once
 
+#include <concepts>
 #include <cstdint>
 
+#include "gb/fastmem.h"
+#include "gb/flat_bus.h"
+#include "gb/interrupt.h"
+#include "gb/mapper_bus.h"
+#include "gb/mmu.h"
+#include "gb/state.h"
+
 namespace gb {
 
 // Flag definitions
@@ -15,23 +23,86 @@ constexpr uint8_t kSubtractFlagMask = 1 << kSubtractFlagBit;
 constexpr uint8_t kHalfCarryFlagMask = 1 << kHalfCarryFlagBit;
 constexpr uint8_t kCarryFlagMask = 1 << kCarryFlagBit;
 
-enum class Interrupt : uint8_t { VBlank = 0, LCDStat, Timer, Serial, Joypad };
+// Architectural register file, for engines that hold CPU state elsewhere
+struct Registers {
+  uint8_t a, f, b, c, d, e, h, l;
+  uint16_t sp, pc;
 
-class CPU {
- public:
-  CPU() = default;
-  ~CPU() = default;
+  bool operator==(const Registers&) const = default;
+};
+
+// Operation of a CB-prefixed opcode. Bits 7-6 select rotate/shift (with
+// bits 5-3 choosing which), BIT, RES or SET.
+enum class CbOp : uint8_t {
+  kRlc, kRrc, kRl, kRr, kSla, kSra, kSwap, kSrl, kBit, kRes, kSet,
+};
+
+// What the CPU needs from the memory it runs against: byte reads and
+// writes, and Tick() to let the rest of the system catch up after each
+// instruction
+template <typename T>
+concept MemoryBus = requires(T& bus, const T& const_bus, uint16_t address,
+                             uint8_t value, uint32_t cycles) {
+  { const_bus.Read(address) } -> std::same_as<uint8_t>;
+  bus.Write(address, value);
+  bus.Tick(cycles);
+};
+
+// A bus that knows how far ahead its next event is (an interrupt source,
+// a scheduled hardware event, or a limit set by its owner). Until then
+// its memory reads cannot change unless the CPU writes, which is what
+// lets BasicCpu fast-forward through idle loops on it.
+template <typename T>
+concept EventBus = MemoryBus<T> && requires(const T& bus) {
+  { bus.CyclesUntilEvent() } -> std::same_as<uint64_t>;
+};
 
+// A bus that keeps IE & IF (the five interrupt bits) cached, so checking
+// for a pending interrupt does not take two register reads
+template <typename T>
+concept InterruptBus = MemoryBus<T> && requires(const T& bus) {
+  { bus.pending_interrupts() } -> std::same_as<uint8_t>;
+};
+
+// A bus that can hand out host pointers to runs of plain memory (no side
+// effects on access), so BasicCpu can run copy and fill loops in bulk
+template <typename T>
+concept BulkBus = MemoryBus<T> && requires(T& bus, const T& const_bus,
+                                           uint16_t address, uint32_t length) {
+  { const_bus.ReadableRange(address, length) } -> std::same_as<const uint8_t*>;
+  { bus.WritableRange(address, length) } -> std::same_as<uint8_t*>;
+};
+
+// A bus that exposes its cartridge bank windows and OAM DMA state, so
+// BasicCpu can tell whether ahead-of-time compiled code at PC still
+// matches what the CPU would fetch there
+template <typename T>
+concept BankedBus = EventBus<T> && requires(const T& bus) {
+  { bus.banks() } -> std::same_as<const BankState&>;
+  { bus.dma_active() } -> std::same_as<bool>;
+};
+
+class AotPlugin;
+
+// Registers, execution state and speedup options of a BasicCpu: all of
+// it that does not depend on the bus, so an owner that only picks the
+// bus at run time (Emulator) can reach any instantiation through this
+class CpuState {
+ public:
   // Initialize registers and state
   void Reset();
 
-  // Advance the CPU by one instruction
-  void Step();
+  // Save-state snapshot of the registers and execution state
+  void SaveState(StateWriter& w) const;
+  void LoadState(StateReader& r);
 
   // Getters for test/inspection
   uint16_t pc() const { return pc_; }
   uint16_t sp() const { return sp_; }
   bool ime() const { return ime_; }
+  bool halted() const { return halted_; }
+  // EI executed; IME turns on after the next instruction
+  bool ei_pending() const { return ei_delay_; }
 
   uint8_t a() const { return a_; }
   uint8_t f() const { return f_; }
@@ -41,6 +112,146 @@ class CPU {
   uint8_t e() const { return e_; }
   uint8_t h() const { return h_; }
   uint8_t l() const { return l_; }
+  uint64_t cycles() const { return cycles_; }
+
+  Registers registers() const;
+  void set_registers(const Registers& regs);
+  void set_ime(bool ime) { ime_ = ime; }
+  // Account for instructions executed outside Step()
+  void AdvanceCycles(uint64_t cycles) { cycles_ += cycles; }
+
+  // Idle skipping (EventBus only, on by default). A short backward loop
+  // that writes nothing and comes back to the same registers is
+  // fast-forwarded in whole iterations to just before the bus's next
+  // event, and HALT waits out the time to the event in one step. Either
+  // way the machine ends up exactly where running it would.
+  void set_idle_skip(bool enabled) { idle_skip_ = enabled; }
+  bool idle_skip() const { return idle_skip_; }
+  // T-cycles fast-forwarded so far, beyond the M-cycle a halted Step()
+  // always takes (included in cycles())
+  uint64_t skipped_cycles() const { return skipped_cycles_; }
+
+  // Superinstructions (on by default): Step() runs the opcode pairs in
+  // superinstruction_list.h through one fused handler, with no interrupt
+  // check or bus tick in between. Pairs are only fused when no bus event
+  // falls between the two instructions, so timing is unchanged.
+  void set_superinstructions(bool enabled) { superinstructions_ = enabled; }
+  bool superinstructions() const { return superinstructions_; }
+  // Pairs executed fused (each saved one dispatch)
+  uint64_t fused_pairs() const { return fused_pairs_; }
+
+  // Dead-flag skipping (on by default). Step() runs a straight-line block
+  // of register-only ALU, INC/DEC, ADD HL and rotate instructions in one
+  // go, and each whose flags the next instruction overwrites unread
+  // (kOpcodeFlags in opcode_flags.h) through a variant that leaves the
+  // flags alone. As with superinstructions the block stops before any
+  // instruction a bus event would precede, so the skipped flag values
+  // can never be observed.
+  void set_skip_dead_flags(bool enabled) { skip_dead_flags_ = enabled; }
+  bool skip_dead_flags() const { return skip_dead_flags_; }
+  // Instructions run without computing their flags
+  uint64_t dead_flag_instructions() const { return dead_flag_instructions_; }
+
+  // Bulk loops (BulkBus only, on by default). The copy and fill loops
+  // listed in cpu.cpp are recognised at their loop head and, when source
+  // and destination are plain memory, run as one memmove/memset for all
+  // but the last iteration, charging the cycles and leaving the registers
+  // and flags the iterations would have. On an EventBus only iterations
+  // that end before the next event run in bulk, and none while an
+  // interrupt is waiting to be dispatched.
+  void set_bulk_loops(bool enabled) { bulk_loops_ = enabled; }
+  bool bulk_loops() const { return bulk_loops_; }
+  // Loop iterations run in bulk
+  uint64_t bulk_iterations() const { return bulk_iterations_; }
+
+  // Ahead-of-time compiled code (BankedBus only, off until a plugin is
+  // set; see aot.h). Step() calls the plugin's block for PC and the
+  // mapped ROM bank, when it has one, instead of interpreting: it runs
+  // the instructions up to the next memory write or taken branch,
+  // stopping short of the bus's next event as superinstructions do. The
+  // plugin must outlive its use here.
+  void set_aot(const AotPlugin* plugin) { aot_ = plugin; }
+  const AotPlugin* aot() const { return aot_; }
+  // Instructions run from compiled blocks
+  uint64_t aot_instructions() const { return aot_instructions_; }
+
+  // Set when LD B,B (0x40) executes; test ROMs use it as a breakpoint
+  bool breakpoint() const { return breakpoint_; }
+  void clear_breakpoint() { breakpoint_ = false; }
+
+ protected:
+  void ForgetIdleLoop() { idle_clean_ = false; }
+
+  // Cycle counter (T-cycles)
+  uint64_t cycles_ = 0;
+  // Delayed interrupt enable flag (for EI instruction)
+  bool ei_delay_ = false;
+  // CPU halted or stopped state
+  bool halted_ = false;
+  // LD B,B software breakpoint hit
+  bool breakpoint_ = false;
+
+  // 8-bit registers
+  uint8_t a_, f_, b_, c_, d_, e_, h_, l_;
+
+  // 16-bit special registers
+  uint16_t sp_, pc_;
+
+  // Interrupt master enable flag
+  bool ime_ = false;
+
+  // Idle-loop candidate: the loop head, the state and clock when it was
+  // last reached, and whether anything has been written since
+  bool idle_skip_ = true;
+  bool idle_clean_ = false;
+  uint16_t idle_pc_ = 0;
+  Registers idle_regs_{};
+  bool idle_ime_ = false;
+  bool idle_ei_delay_ = false;
+  uint64_t idle_start_ = 0;
+  uint64_t idle_until_event_ = 0;
+  uint64_t skipped_cycles_ = 0;
+
+  bool superinstructions_ = true;
+  uint64_t fused_pairs_ = 0;
+
+  bool skip_dead_flags_ = true;
+  uint64_t dead_flag_instructions_ = 0;
+
+  bool bulk_loops_ = true;
+  uint64_t bulk_iterations_ = 0;
+
+  const AotPlugin* aot_ = nullptr;
+  uint64_t aot_instructions_ = 0;
+};
+
+// SM83 interpreter, generic over its bus so memory accesses can inline.
+// The instantiations live in cpu.cpp: CPU on the MMU,
+// BasicCpu<MapperBus<...>> on the MMU with its mapper fixed (one per
+// mapper, which Emulator picks from at LoadROM()),
+// BasicCpu<FastmemBus> on the same MMU through host page mappings, and
+// BasicCpu<FlatBus> on plain 64 KiB of RAM for running the core in
+// isolation (tests, single-step vectors, dispatch benchmarks).
+template <MemoryBus Bus>
+class BasicCpu : public CpuState {
+ public:
+  // Run against a specific memory map (one per emulator instance)
+  explicit BasicCpu(Bus& bus);
+  ~BasicCpu() = default;
+
+  // Advance the CPU: the delayed EI and any interrupt dispatch, then one
+  // instruction, or with the speedups below on, as much as one of them
+  // covers at once (a fused pair, a dead-flag block, a compiled block, a
+  // HALT wait or skipped idle loop iterations up to the next event, the
+  // iterations of a bulk loop). The machine, bus included, always ends
+  // up where single-instruction Steps would have left it, but callers
+  // that count or inspect individual instructions must switch the
+  // speedups off (or use StepInstruction()).
+  void Step();
+  // Fetch and execute the instruction at PC and charge its cycles,
+  // skipping the EI, interrupt and HALT handling Step() does first
+  // (single-step test vectors)
+  void StepInstruction();
 
   // Helper to get HL register pair
   uint16_t hl() const { return (static_cast<uint16_t>(h_) << 8) | l_; }
@@ -81,34 +292,103 @@ class CPU {
   uint8_t FetchOpcode();
   uint8_t Fetch8();
   uint16_t Fetch16();
+  // Memory write from an instruction
+  void Write8(uint16_t address, uint8_t value);
 
   // Decode & execute
   void Execute(uint8_t opcode);
+  // Execute an already fetched opcode and charge its cycles
+  void ExecuteTimed(uint8_t opcode);
+  // Handler of a primary opcode, usable in constant expressions
+  using Handler = void (BasicCpu::*)();
+  static constexpr Handler HandlerFor(uint8_t opcode);
+  // Fused handler: kFirst, then kSecond if it follows and no event is due
+  // in between
+  template <uint8_t kFirst, uint8_t kSecond>
+  void OpPair();
+  // Execute an already fetched opcode along with the register-only
+  // instructions after it, skipping the flags their successors overwrite
+  void ExecuteSkippingDeadFlags(uint8_t opcode);
+  // Flag-free variant of kOpcode, or nullptr if it has none
+  template <uint8_t kOpcode>
+  static constexpr Handler FlagFreeHandlerFor();
+  template <uint8_t kOpcode>
+  void OpFlagFree();
 
   // Per-opcode handlers (256 total)
-#define OPCODE(name, code) void Op##name();
+#define OPCODE(name, code, cycles, taken) void Op##name();
 #include "gb/opcode_list.h"
 #undef OPCODE
 
+  // CB-prefixed handlers: one instantiation per (operation, operand)
+  // pair, where the operand is the 3-bit register field (B, C, D, E, H,
+  // L, (HL), A). BIT/RES/SET read their bit number from the opcode.
+  template <CbOp kOp, int kOperand>
+  void OpCb(uint8_t opcode);
+  template <int kOperand>
+  uint8_t ReadOperand();
+  template <int kOperand>
+  void WriteOperand(uint8_t value);
+  // Rotate/shift `value` and set Z/N/H/C
+  template <CbOp kOp>
+  uint8_t Shift(uint8_t value);
+
   // Handler for undefined opcodes
   void OpIllegal();
   // Check and service any pending interrupts
   void ServiceInterrupts();
-  // Cycle counter (machine cycles)
-  uint64_t cycles_ = 0;
-  // Delayed interrupt enable flag (for EI instruction)
-  bool ei_delay_ = false;
-  // CPU halted or stopped state
-  bool halted_ = false;
-
-  // 8-bit registers
-  uint8_t a_, f_, b_, c_, d_, e_, h_, l_;
+  // IE & IF over the five sources
+  uint8_t PendingInterrupts() const {
+    if constexpr (InterruptBus<Bus>) {
+      return bus_.pending_interrupts();
+    } else {
+      return bus_.Read(kIeAddress) & bus_.Read(kIfAddress) & 0x1F;
+    }
+  }
+  // Called after a jump back to pc_: confirm an idle loop there and skip
+  // ahead, or start watching pc_ as a candidate
+  void CheckIdleLoop();
+  // Called after a jump back to pc_: if a copy or fill loop starts there,
+  // run its remaining iterations in bulk. True if any ran.
+  bool RunBulkLoop();
+  // Run the compiled block for PC, if there is one that applies. True if
+  // it ran any instructions.
+  bool RunAotBlock();
+  // Memory access for compiled blocks, with an AotContext as context
+  struct AotContext;
+  static uint8_t AotRead(void* context, uint16_t address);
+  static void AotWrite(void* context, uint16_t address, uint8_t value);
+  // Tick the bus up to cycles_. A Step() running several instructions
+  // calls it before one that may write, so the write lands on the
+  // instruction's own cycle as if each had been a Step(): a write can
+  // start something timed (a serial transfer, OAM DMA, the RTC). The
+  // callers stop short of the next event, so this only moves the clock.
+  void SyncBus() {
+    if (cycles_ == bus_cycles_) return;
+    bus_.Tick(static_cast<uint32_t>(cycles_ - bus_cycles_));
+    bus_cycles_ = cycles_;
+  }
+  // Memory map this CPU executes against
+  Bus& bus_;
+  // How far the bus has been ticked along with cycles_ in the current
+  // Step()
+  uint64_t bus_cycles_ = 0;
+  // kOpcodeTiming entry of the instruction being executed (the CB
+  // prefix handler points it at the CB set), and whether a conditional
+  // branch in it was taken
+  uint16_t timing_index_ = 0;
+  bool branch_taken_ = false;
+};
 
-  // 16-bit special registers
-  uint16_t sp_, pc_;
+using CPU = BasicCpu<MMU>;
 
-  // Interrupt master enable flag
-  bool ime_ = false;
-};
+extern template class BasicCpu<MMU>;
+extern template class BasicCpu<MapperBus<NoMbc>>;
+extern template class BasicCpu<MapperBus<Mbc1>>;
+extern template class BasicCpu<MapperBus<Mbc2>>;
+extern template class BasicCpu<MapperBus<Mbc3>>;
+extern template class BasicCpu<MapperBus<Mbc5>>;
+extern template class BasicCpu<FastmemBus>;
+extern template class BasicCpu<FlatBus>;
 
 } // namespace gb
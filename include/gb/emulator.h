@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "gb/aot.h"
+#include "gb/cpu.h"
+#include "gb/mapper_bus.h"
+#include "gb/mmu.h"
+#include "gb/state.h"
+
+namespace gb {
+
+// LCD geometry and timing
+static constexpr int kScreenWidth = 160;
+static constexpr int kScreenHeight = 144;
+static constexpr uint32_t kCyclesPerLine = 456;
+static constexpr uint32_t kCyclesPerFrame = 154 * kCyclesPerLine;
+
+// A complete headless Game Boy: one memory map plus the CPU that runs on
+// it, compiled for the cartridge's mapper (BasicCpu<MapperBus<...>>,
+// picked in LoadROM()) so no memory access dispatches at run time.
+// Instances are independent, so many can run on different threads.
+class Emulator {
+ public:
+  Emulator();
+
+  // Non-copyable, non-movable (the CPU holds a reference to the MMU)
+  Emulator(const Emulator&) = delete;
+  Emulator& operator=(const Emulator&) = delete;
+
+  // Insert a cartridge and power-cycle the CPU
+  void LoadROM(const std::vector<uint8_t>& rom_data);
+
+  // Load the AOT plugin built for this ROM (AotPlugin::FileName of its
+  // RomHash) from `directory` and run its compiled blocks from now on.
+  // Returns false, with `error` set, if there is none or it does not
+  // load. LoadROM() drops it again.
+  bool LoadAotPlugin(const std::string& directory, std::string* error);
+  const AotPlugin* aot_plugin() const { return aot_.get(); }
+
+  // Run until the next frame boundary (kCyclesPerFrame T-cycles apart),
+  // or until Stop() is called from inside the frame
+  void RunFrame();
+  // RunFrame() for at most `max_steps` CPU Steps, for callers that must
+  // look at the wall clock inside a frame. True once the frame is done;
+  // otherwise calling it again carries on where it stopped.
+  bool RunFrameFor(uint64_t max_steps);
+  // One CPU Step() (BasicCpu::Step), for engines that step it themselves
+  void Step();
+
+  // Frame bookkeeping for engines that step the CPU themselves: the frame
+  // is done once the clock reaches its end, then EndFrame() starts the
+  // next one
+  bool frame_done() const { return mmu_.cycles() >= frame_end_; }
+  void EndFrame();
+
+  // Make RunFrame() return after the current instruction. Safe to call
+  // from callbacks such as a serial sink. Cleared by the next RunFrame().
+  void Stop() { stop_requested_ = true; }
+  bool stopped() const { return stop_requested_; }
+  // Also return from RunFrame() right after the Step() that hits an
+  // LD B,B breakpoint (CpuState::breakpoint()), so test harnesses see the
+  // registers it left. Off by default.
+  void set_stop_on_breakpoint(bool enabled) { stop_on_breakpoint_ = enabled; }
+
+  // Hold exactly the given JoypadButton bits from now on
+  void SetJoypad(uint8_t buttons) { mmu_.SetJoypad(buttons); }
+  // Hold them from emulated cycle `cycle` (see MMU::QueueInput)
+  void QueueInput(uint64_t cycle, uint8_t buttons) {
+    mmu_.QueueInput(cycle, buttons);
+  }
+
+  // Snapshot the whole machine except the cartridge ROM. LoadState()
+  // requires the same ROM to be loaded; it returns false and leaves the
+  // emulator untouched if the snapshot is malformed or for another cart.
+  std::vector<uint8_t> SaveState() const;
+  bool LoadState(const uint8_t* data, size_t size);
+  // Hash of every StateRegion, cheap enough to take every frame
+  StateHashes RegionHashes() const;
+  // All of RegionHashes() in one value; equal hashes mean equal machines
+  uint64_t StateHash() const;
+
+  // One byte per pixel, row-major, holding DMG shade indices 0-3. Stays
+  // blank until a PPU renders into it.
+  const uint8_t* framebuffer() const { return framebuffer_.data(); }
+  uint64_t frame_count() const { return frame_count_; }
+
+  MMU& mmu() { return mmu_; }
+  const MMU& mmu() const { return mmu_; }
+  CpuState& cpu() { return *cpu_state_; }
+  const CpuState& cpu() const { return *cpu_state_; }
+
+ private:
+  template <typename Mapper>
+  using MapperCpu = BasicCpu<MapperBus<Mapper>>;
+
+  // Read a snapshot written by SaveState(); false if it does not fit
+  bool Restore(StateReader& r);
+
+  // Switch cpu_ to the instantiation for the loaded cartridge's mapper,
+  // carrying its registers, options and counters over
+  void SelectCpu();
+  template <typename Mapper>
+  void UseCpu();
+
+  MMU mmu_;
+  std::tuple<MapperBus<NoMbc>, MapperBus<Mbc1>, MapperBus<Mbc2>,
+             MapperBus<Mbc3>, MapperBus<Mbc5>>
+      buses_;
+  std::variant<MapperCpu<NoMbc>, MapperCpu<Mbc1>, MapperCpu<Mbc2>,
+               MapperCpu<Mbc3>, MapperCpu<Mbc5>>
+      cpu_;
+  CpuState* cpu_state_; // The active cpu_ alternative
+  uint64_t rom_hash_ = 0;
+  std::unique_ptr<AotPlugin> aot_;
+  std::array<uint8_t, kScreenWidth * kScreenHeight> framebuffer_{};
+  uint64_t frame_end_ = kCyclesPerFrame; // MMU cycle the frame finishes
+  uint64_t frame_count_ = 0;
+  bool stop_requested_ = false;
+  bool stop_on_breakpoint_ = false;
+};
+
+} // namespace gb
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gb/mmu.h"
+
+// Fastmem needs memfd, SIGSEGV context access and a known load/store
+// encoding, so it is only built for x86-64 Linux
+#if defined(__x86_64__) && defined(__linux__)
+#define GB_FASTMEM 1
+#endif
+
+namespace gb {
+
+// "Fastmem" bus: the 64 KiB guest address space as one reserved host
+// region, so a CPU load or store is a single instruction on base + address
+// with no branches.
+//
+// A memfd holds the MMU's VRAM/WRAM block (moved there with UseRamBlock)
+// followed by a copy of the ROM. Both ROM windows map the current banks
+// read-only, VRAM and WRAM map read-write, and 0xE000-0xEFFF maps the same
+// pages as WRAM bank 0, so the echo needs no special case. The rest
+// (cartridge RAM, 0xF000-0xFFFF with OAM, I/O and HRAM) is not accessible.
+// While OAM DMA runs the whole region is, so its bus conflicts apply, and
+// while the MMU's PPU log is on VRAM is read-only so stores get logged.
+//
+// An access that hits a protected page faults into a SIGSEGV handler,
+// which performs it through the MMU, patches the result into the
+// interrupted load and resumes after it. A write that switches ROM banks
+// remaps the window before returning. Faulting is slow (a few µs), so
+// this pays off when almost all accesses are to ROM and RAM.
+//
+// The MMU stays the owner of all state; construct the bus after LoadROM()
+// and call Sync() after changing the MMU directly (LoadState, writes that
+// bypass this bus). Debuggers stop on the SIGSEGVs; in gdb use
+// `handle SIGSEGV nostop noprint`.
+class FastmemBus {
+ public:
+  // True if this build and host can run fastmem (x86-64 Linux, 4 KiB
+  // pages)
+  static bool Supported();
+
+  explicit FastmemBus(MMU& mmu);
+  ~FastmemBus();
+
+  FastmemBus(const FastmemBus&) = delete;
+  FastmemBus& operator=(const FastmemBus&) = delete;
+
+  // False if the region could not be set up; the bus must not be used
+  bool ok() const { return base_ != nullptr; }
+
+  uint8_t Read(uint16_t address) const {
+#ifdef GB_FASTMEM
+    // Fixed registers: the fault handler recognises exactly this
+    // instruction (movzbl (%rdx),%eax) and delivers the value in EAX
+    uint32_t value;
+    asm volatile("movzbl (%%rdx), %%eax"
+                 : "=a"(value)
+                 : "d"(base_ + address)
+                 : "memory");
+    return static_cast<uint8_t>(value);
+#else
+    return mmu_.Read(address);
+#endif
+  }
+
+  void Write(uint16_t address, uint8_t value) {
+#ifdef GB_FASTMEM
+    // movb %al,(%rdx), decoded the same way by the fault handler
+    asm volatile("movb %%al, (%%rdx)"
+                 :
+                 : "a"(value), "d"(base_ + address)
+                 : "memory");
+#else
+    mmu_.Write(address, value);
+#endif
+  }
+
+  void Tick(uint32_t cycles) {
+    mmu_.Tick(cycles);
+    // OAM DMA ends on a scheduled event
+    if (mmu_.dma_active() != dma_mapped_) [[unlikely]] Sync();
+  }
+
+  uint64_t CyclesUntilEvent() const { return mmu_.CyclesUntilEvent(); }
+  uint8_t pending_interrupts() const { return mmu_.pending_interrupts(); }
+  const uint8_t* ReadableRange(uint16_t address, uint32_t length) const {
+    return mmu_.ReadableRange(address, length);
+  }
+  uint8_t* WritableRange(uint16_t address, uint32_t length) {
+    return mmu_.WritableRange(address, length);
+  }
+
+  // Bring the mapping in line with the MMU's banks and DMA state
+  void Sync();
+
+  // Accesses that faulted and went through the MMU
+  uint64_t faults() const { return faults_; }
+  // Remaps that failed. The range is left inaccessible instead, so its
+  // accesses keep working through the MMU, only slower; a failure while
+  // constructing gives up on fastmem altogether (ok() is false).
+  uint64_t map_failures() const { return map_failures_; }
+
+  MMU& mmu() { return mmu_; }
+
+ private:
+  friend struct FastmemFaultHandler;
+
+  // Access through the MMU on behalf of a faulting instruction
+  uint8_t FaultRead(uint16_t address);
+  void FaultWrite(uint16_t address, uint8_t value);
+
+  // Map `size` bytes of the memfd at `offset` to guest `address`
+  void MapFile(uint16_t address, uint32_t size, uint32_t offset, int prot);
+  void MapNone(uint16_t address, uint32_t size);
+  // Fall back after a failed mmap() of the range
+  void MapFailed(uint16_t address, uint32_t size);
+  // Undo the setup: unregister, hand the RAM back to the MMU, unmap
+  void Release();
+
+  MMU& mmu_;
+  uint8_t* base_ = nullptr; // Guest address space
+  uint8_t* ram_ = nullptr;  // The RAM block, mapped for the MMU
+  int fd_ = -1;
+  int slot_ = -1;
+  uint32_t rom0_mapped_ = 0;
+  uint32_t romx_mapped_ = 0;
+  bool dma_mapped_ = false;
+  bool vram_logged_ = false; // VRAM mapped read-only for the PPU log
+  uint64_t faults_ = 0;
+  uint64_t map_failures_ = 0;
+};
+
+} // namespace gb
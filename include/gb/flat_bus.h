@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace gb {
+
+// 64 KiB of plain RAM: no cartridge, I/O registers, banking or timing.
+// Lets the CPU run in isolation, e.g. against single-step test vectors.
+class FlatBus {
+ public:
+  uint8_t Read(uint16_t address) const { return memory_[address]; }
+  void Write(uint16_t address, uint8_t value) { memory_[address] = value; }
+  void Tick(uint32_t) {}
+
+  std::array<uint8_t, 0x10000>& memory() { return memory_; }
+  const std::array<uint8_t, 0x10000>& memory() const { return memory_; }
+
+ private:
+  std::array<uint8_t, 0x10000> memory_{};
+};
+
+} // namespace gb
@@ -0,0 +1,100 @@
+/* C interface to the emulator core (libgbcore).
+ *
+ * Meant for embedding many headless instances in another process, e.g. a
+ * training loop, without going through the SDL front end. All functions
+ * are thread-compatible: distinct instances may be used from different
+ * threads concurrently, a single instance from one thread at a time. */
+#ifndef GB_GBCORE_H_
+#define GB_GBCORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(GB_BUILDING_CORE)
+#define GB_API __declspec(dllexport)
+#elif defined(GB_CORE_DLL)
+#define GB_API __declspec(dllimport)
+#else
+#define GB_API
+#endif
+#else
+#define GB_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Screen geometry of the buffer returned by gb_framebuffer() */
+#define GB_SCREEN_WIDTH 160
+#define GB_SCREEN_HEIGHT 144
+
+/* Joypad bits for gb_set_joypad() (1 = held) */
+enum {
+  GB_BUTTON_A = 1 << 0,
+  GB_BUTTON_B = 1 << 1,
+  GB_BUTTON_SELECT = 1 << 2,
+  GB_BUTTON_START = 1 << 3,
+  GB_BUTTON_RIGHT = 1 << 4,
+  GB_BUTTON_LEFT = 1 << 5,
+  GB_BUTTON_UP = 1 << 6,
+  GB_BUTTON_DOWN = 1 << 7
+};
+
+typedef struct gb_emulator gb_emulator;
+typedef struct gb_batch gb_batch;
+
+/* Create a powered-on instance with no cartridge; NULL on failure */
+GB_API gb_emulator* gb_create(void);
+GB_API void gb_destroy(gb_emulator* emu);
+
+/* Copy a ROM image in and reset. Returns 0 on success, -1 on failure. */
+GB_API int gb_load_rom(gb_emulator* emu, const uint8_t* data, size_t size);
+
+/* Set the buttons held from now on (GB_BUTTON_* bits) */
+GB_API void gb_set_joypad(gb_emulator* emu, uint8_t buttons);
+
+/* Run `frames` whole frames (70224 T-cycles each) */
+GB_API void gb_run_frames(gb_emulator* emu, uint32_t frames);
+GB_API uint64_t gb_frame_count(const gb_emulator* emu);
+
+/* GB_SCREEN_WIDTH x GB_SCREEN_HEIGHT bytes, row-major, shade 0-3. The
+ * pointer stays valid for the lifetime of the instance and is updated in
+ * place by gb_run_frames(). */
+GB_API const uint8_t* gb_framebuffer(const gb_emulator* emu);
+
+/* Copy `size` bytes starting at `address` through the CPU's memory map
+ * (wrapping at 0xFFFF). Mapper registers are written, not just RAM. */
+GB_API void gb_read_memory(const gb_emulator* emu, uint16_t address,
+                           uint8_t* out, size_t size);
+GB_API void gb_write_memory(gb_emulator* emu, uint16_t address,
+                            const uint8_t* data, size_t size);
+
+/* Save states. gb_save_state() returns the snapshot size and writes it to
+ * `out` only if `capacity` is large enough, so a NULL/0 call queries the
+ * size. gb_load_state() needs the same ROM loaded and returns 0 on
+ * success, -1 (instance unchanged) otherwise. */
+GB_API size_t gb_save_state(const gb_emulator* emu, uint8_t* out,
+                            size_t capacity);
+GB_API int gb_load_state(gb_emulator* emu, const uint8_t* data, size_t size);
+
+/* Lockstep stepping of many instances on a fixed set of worker threads.
+ * `threads` 0 means one per hardware thread; `pin` binds worker i to CPU
+ * i (Linux). Each instance is always stepped by the same worker for a
+ * given batch size. */
+GB_API gb_batch* gb_batch_create(uint32_t threads, int pin);
+GB_API void gb_batch_destroy(gb_batch* batch);
+
+/* Run every instance one frame; returns when all are done. If `frames` is
+ * non-NULL it receives count x GB_SCREEN_HEIGHT x GB_SCREEN_WIDTH bytes,
+ * instance i at offset i * GB_SCREEN_HEIGHT * GB_SCREEN_WIDTH. Returns 0,
+ * or -1 if nothing could be run (out of memory). */
+GB_API int gb_batch_run_frame(gb_batch* batch, gb_emulator* const* emus,
+                               size_t count, uint8_t* frames);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* GB_GBCORE_H_ */
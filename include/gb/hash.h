@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gb {
+
+// 64-bit FNV-1a. Simple and stable across platforms; used for ROM
+// identity and framebuffer checks.
+constexpr uint64_t kFnvOffsetBasis = 0xCBF29CE484222325ull;
+
+inline uint64_t Fnv1a64(const uint8_t* data, size_t size,
+                        uint64_t hash = kFnvOffsetBasis) {
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Fast 64-bit hash for large buffers, in the style of XXH3's long-input
+// loop: eight 64-bit lanes of 32x32->64 multiplies that the compiler
+// turns into SIMD, at several bytes per cycle. Reads words in host byte
+// order, so like save states its values are not portable across hosts.
+uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+} // namespace gb
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gb {
+
+// Interrupt sources, in priority order (bit index in IE/IF)
+enum class Interrupt : uint8_t { VBlank = 0, LCDStat, Timer, Serial, Joypad };
+
+// Interrupt register addresses
+static constexpr uint16_t kIfAddress = 0xFF0F;
+static constexpr uint16_t kIeAddress = 0xFFFF;
+
+constexpr uint8_t InterruptMask(Interrupt interrupt) {
+  return static_cast<uint8_t>(1u << static_cast<uint8_t>(interrupt));
+}
+
+} // namespace gb
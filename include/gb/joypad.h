@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gb/state.h"
+
+namespace gb {
+
+// Button bits used by Joypad::SetPressed() (1 = held down)
+enum JoypadButton : uint8_t {
+  kButtonA = 1 << 0,
+  kButtonB = 1 << 1,
+  kButtonSelect = 1 << 2,
+  kButtonStart = 1 << 3,
+  kButtonRight = 1 << 4,
+  kButtonLeft = 1 << 5,
+  kButtonUp = 1 << 6,
+  kButtonDown = 1 << 7,
+};
+
+// A host input change: the full button state from `cycle` onwards
+struct InputEvent {
+  uint64_t cycle;
+  uint8_t buttons;
+};
+
+// P1/JOYP (0xFF00). The game selects the d-pad (bit 4 low) and/or the
+// action buttons (bit 5 low) and reads the selected keys active-low in
+// bits 0-3.
+//
+// The Joypad interrupt fires when any of bits 0-3 goes from high to low,
+// whether because a button was pressed or because a group with a held
+// button was selected. Both mutators report that edge to the caller.
+class Joypad {
+ public:
+  uint8_t Read() const {
+    return static_cast<uint8_t>(0xC0 | select_ | (~Lines() & 0x0F));
+  }
+
+  // Returns true if the write pulls an input line low
+  bool WriteSelect(uint8_t value) {
+    uint8_t before = Lines();
+    select_ = value & 0x30;
+    return (Lines() & ~before) != 0;
+  }
+
+  uint8_t pressed() const { return pressed_; }
+  // Returns true if a newly pressed button is in a selected group
+  bool SetPressed(uint8_t buttons) {
+    uint8_t before = Lines();
+    pressed_ = buttons;
+    return (Lines() & ~before) != 0;
+  }
+
+  void Reset() {
+    select_ = 0x30;
+    pressed_ = 0;
+  }
+
+  void SaveState(StateWriter& w) const {
+    w.Write(select_);
+    w.Write(pressed_);
+  }
+  void LoadState(StateReader& r) {
+    r.Read(&select_);
+    r.Read(&pressed_);
+  }
+
+ private:
+  // Selected keys that are held, active-high in bits 0-3
+  uint8_t Lines() const {
+    uint8_t keys = 0;
+    if (!(select_ & 0x10)) keys |= pressed_ >> 4;   // d-pad
+    if (!(select_ & 0x20)) keys |= pressed_ & 0x0F; // buttons
+    return keys;
+  }
+
+  uint8_t select_ = 0x30; // P14/P15 select lines
+  uint8_t pressed_ = 0;
+};
+
+} // namespace gb
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gb/emulator.h"
+
+namespace gb {
+
+// Experimental structure-of-arrays interpreter for many instances of the
+// same ROM.
+//
+// The register files of all lanes are held column-wise (all A registers
+// together, all F registers together, ...). On every step the engine picks
+// a leader lane; each lane at the same PC about to run the same opcode
+// executes it together, 32 lanes per AVX2 instruction, when the opcode is
+// in the vectorized subset (register loads, INC/DEC, ALU ops on A and
+// relative jumps). Every other lane takes an ordinary scalar CPU::Step().
+//
+// Memory stays per lane: opcodes, immediates and the clock go through each
+// lane's own MMU, so results match independent emulators exactly.
+class LockstepEngine {
+ public:
+  struct Stats {
+    uint64_t vector_steps = 0;        // Lockstep steps issued
+    uint64_t vector_instructions = 0; // Lane instructions in those steps
+    uint64_t scalar_instructions = 0; // Fallback CPU::Step() calls
+  };
+
+  // Lanes are borrowed and must outlive the engine. `simd` selects the
+  // AVX2 kernels when the host supports them; otherwise (or when false)
+  // the same lockstep grouping runs with a per-lane loop.
+  explicit LockstepEngine(std::vector<Emulator*> lanes, bool simd = true);
+
+  // Run every lane to the end of its current frame
+  void RunFrame();
+
+  const Stats& stats() const { return stats_; }
+  bool simd() const { return simd_; }
+  size_t lanes() const { return lanes_.size(); }
+
+  // Whether this build and host can run the AVX2 kernels
+  static bool SimdSupported();
+
+ private:
+  // Copy registers between the lanes' CPUs and the SoA columns
+  void Gather(size_t lane);
+  void Scatter(size_t lane);
+
+  // Whether `lane` can take a lockstep step (no interrupt, HALT or EI
+  // bookkeeping due before its next instruction)
+  bool Eligible(size_t lane) const;
+
+  // Run one opcode on every lane with active_ set
+  void ExecuteGroup(uint8_t opcode);
+
+  std::vector<Emulator*> lanes_;
+  bool simd_;
+  Stats stats_;
+
+  // Register columns indexed by the SM83 operand encoding:
+  // B, C, D, E, H, L, (unused: (HL)), A
+  std::vector<uint8_t> regs_[8];
+  std::vector<uint8_t> f_;
+  std::vector<uint16_t> pc_;
+  std::vector<uint16_t> sp_;
+  // Per-step scratch: lane mask (0x00/0xFF) and immediate operand
+  std::vector<uint8_t> active_;
+  std::vector<uint8_t> imm_;
+};
+
+} // namespace gb
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gb/mbc.h"
+#include "gb/mmu.h"
+
+namespace gb {
+
+// The MMU as seen by a cartridge whose mapper is fixed at compile time:
+// Read() and Write() go straight to MMU::ReadFor/WriteFor<Mapper>
+// instead of through the pointers MMU::Read() dispatches on, so a CPU
+// built on this bus inlines its memory accesses down to the mapper's
+// bank logic. Only valid while the MMU holds a cartridge for `Mapper`;
+// Emulator picks the instantiation in LoadROM().
+template <typename Mapper>
+class MapperBus {
+ public:
+  explicit MapperBus(MMU& mmu) : mmu_(mmu) {}
+
+  uint8_t Read(uint16_t address) const {
+    return mmu_.ReadFor<Mapper>(address);
+  }
+  void Write(uint16_t address, uint8_t value) {
+    mmu_.WriteFor<Mapper>(address, value);
+  }
+  void Tick(uint32_t cycles) { mmu_.Tick(cycles); }
+
+  uint64_t CyclesUntilEvent() const { return mmu_.CyclesUntilEvent(); }
+  uint8_t pending_interrupts() const { return mmu_.pending_interrupts(); }
+  const uint8_t* ReadableRange(uint16_t address, uint32_t length) const {
+    return mmu_.ReadableRange(address, length);
+  }
+  uint8_t* WritableRange(uint16_t address, uint32_t length) {
+    return mmu_.WritableRange(address, length);
+  }
+  const BankState& banks() const { return mmu_.banks(); }
+  bool dma_active() const { return mmu_.dma_active(); }
+
+  MMU& mmu() { return mmu_; }
+
+ private:
+  MMU& mmu_;
+};
+
+} // namespace gb
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gb/rtc.h"
+
+namespace gb {
+
+// Cartridge-side sizes
+static constexpr uint16_t kBankSize = 0x4000;     // One ROM bank
+static constexpr uint16_t kExtRamSize = 0x2000;   // One SRAM bank
+static constexpr uint32_t kMaxSramSize = 0x20000; // 128 KiB (MBC5)
+static constexpr uint16_t kMbc2RamSize = 0x200;   // 512 x 4 bits
+
+// Memory bank controller families, decoded from header byte 0x0147
+enum class MbcType : uint8_t { kNone, kMbc1, kMbc2, kMbc3, kMbc5 };
+
+// Decode the cartridge type byte (0x0147). Unknown types map to kNone.
+MbcType MbcTypeFromHeader(uint8_t cartridge_type);
+
+// Decode the RAM size byte (0x0149) into bytes of battery/work SRAM
+size_t SramSizeFromHeader(MbcType type, uint8_t ram_size_code);
+
+// Whether the cartridge type includes the MBC3 clock (0x0F, 0x10)
+bool CartridgeHasRtc(uint8_t cartridge_type);
+
+// Banking state shared by every mapper. Mappers only touch this on
+// control-register writes; the MMU read path indexes ROM/RAM through the
+// precomputed window offsets, so it never calls back into the mapper.
+struct BankState {
+  uint32_t rom0_offset = 0;         // Window for 0x0000-0x3FFF
+  uint32_t romx_offset = kBankSize; // Window for 0x4000-0x7FFF
+  uint32_t ram_offset = 0;          // Window for 0xA000-0xBFFF
+  uint32_t rom_bank_mask = 1;       // ROM bank count - 1 (power of two)
+  uint32_t ram_bank_mask = 0;       // SRAM bank count - 1
+
+  // Raw mapper registers (meaning depends on the mapper)
+  bool ram_enable = false;
+  uint16_t rom_bank = 1; // Low ROM bank bits
+  uint8_t bank_hi = 0;   // MBC1 secondary bank / MBC5 ROM bit 8
+  uint8_t ram_bank = 0;  // RAM bank (or MBC3 RTC register select)
+  uint8_t mode = 0;      // MBC1 banking mode
+
+  // MBC3 clock
+  Rtc rtc;
+  uint8_t rtc_latch_last = 0xFF; // Last value written to 0x6000-0x7FFF
+};
+
+// CRTP base for mappers. Derived classes provide:
+//   static void WriteRegister(BankState&, uint16_t address, uint8_t value,
+//                             uint64_t now);
+//   static void UpdateWindows(BankState&);
+// and may shadow ReadRam/WriteRam when their cartridge RAM is not plain
+// banked SRAM. Everything is static so each MMU instantiation inlines it.
+// `now` is the emulated T-cycle count, used only by clocked mappers.
+template <typename Derived>
+struct Mbc {
+  // Handle a write to 0x0000-0x7FFF and refresh the window offsets
+  static void WriteControl(BankState& s, uint16_t address, uint8_t value,
+                           uint64_t now) {
+    Derived::WriteRegister(s, address, value, now);
+    Derived::UpdateWindows(s);
+  }
+
+  // Banked SRAM at 0xA000-0xBFFF, gated by the RAM enable register
+  static uint8_t ReadRam(const BankState& s, const std::vector<uint8_t>& sram,
+                         uint16_t address, uint64_t /*now*/) {
+    if (!s.ram_enable || sram.empty()) return 0xFF;
+    size_t off = s.ram_offset + (address & (kExtRamSize - 1));
+    return sram[off & (sram.size() - 1)];
+  }
+
+  static void WriteRam(BankState& s, std::vector<uint8_t>& sram,
+                       uint16_t address, uint8_t value, uint64_t /*now*/) {
+    if (!s.ram_enable || sram.empty()) return;
+    size_t off = s.ram_offset + (address & (kExtRamSize - 1));
+    sram[off & (sram.size() - 1)] = value;
+  }
+};
+
+// ROM only (plus optional unbanked RAM): writes to 0x0000-0x7FFF are ignored
+struct NoMbc : Mbc<NoMbc> {
+  static void WriteRegister(BankState&, uint16_t, uint8_t, uint64_t) {}
+  static void UpdateWindows(BankState&) {}
+
+  // No enable register on plain cartridges; RAM is always accessible
+  static uint8_t ReadRam(const BankState&, const std::vector<uint8_t>& sram,
+                         uint16_t address, uint64_t /*now*/) {
+    if (sram.empty()) return 0xFF;
+    return sram[(address - 0xA000) & (sram.size() - 1)];
+  }
+
+  static void WriteRam(BankState&, std::vector<uint8_t>& sram,
+                       uint16_t address, uint8_t value, uint64_t /*now*/) {
+    if (sram.empty()) return;
+    sram[(address - 0xA000) & (sram.size() - 1)] = value;
+  }
+};
+
+// MBC1: 5+2 bit ROM bank, 2-bit RAM bank, simple/advanced banking mode
+struct Mbc1 : Mbc<Mbc1> {
+  static void WriteRegister(BankState& s, uint16_t address, uint8_t value,
+                            uint64_t /*now*/) {
+    switch (address >> 13) {
+      case 0: // 0x0000-0x1FFF: RAM enable
+        s.ram_enable = ((value & 0x0F) == 0x0A);
+        break;
+      case 1: // 0x2000-0x3FFF: ROM bank low 5 bits (0 reads as 1)
+        s.rom_bank = value & 0x1F;
+        if (s.rom_bank == 0) s.rom_bank = 1;
+        break;
+      case 2: // 0x4000-0x5FFF: RAM bank / ROM bank high 2 bits
+        s.bank_hi = value & 0x03;
+        break;
+      default: // 0x6000-0x7FFF: banking mode select
+        s.mode = value & 0x01;
+        break;
+    }
+  }
+
+  static void UpdateWindows(BankState& s) {
+    uint32_t hi = static_cast<uint32_t>(s.bank_hi) << 5;
+    s.romx_offset = ((hi | s.rom_bank) & s.rom_bank_mask) * kBankSize;
+    // Mode 1 also applies the high bits to the 0x0000 window and SRAM
+    s.rom0_offset = s.mode ? (hi & s.rom_bank_mask) * kBankSize : 0;
+    s.ram_offset =
+        s.mode ? (s.bank_hi & s.ram_bank_mask) * uint32_t{kExtRamSize} : 0;
+  }
+};
+
+// MBC2: 4-bit ROM bank, 512 x 4-bit built-in RAM echoed over 0xA000-0xBFFF
+struct Mbc2 : Mbc<Mbc2> {
+  static void WriteRegister(BankState& s, uint16_t address, uint8_t value,
+                            uint64_t /*now*/) {
+    if (address >= 0x4000) return;
+    // Address bit 8 selects between RAM enable and ROM bank
+    if (address & 0x0100) {
+      s.rom_bank = value & 0x0F;
+      if (s.rom_bank == 0) s.rom_bank = 1;
+    } else {
+      s.ram_enable = ((value & 0x0F) == 0x0A);
+    }
+  }
+
+  static void UpdateWindows(BankState& s) {
+    s.romx_offset = (s.rom_bank & s.rom_bank_mask) * kBankSize;
+  }
+
+  static uint8_t ReadRam(const BankState& s, const std::vector<uint8_t>& sram,
+                         uint16_t address, uint64_t /*now*/) {
+    if (!s.ram_enable || sram.empty()) return 0xFF;
+    // Only the low nibble exists; the upper bits float high
+    return 0xF0 | (sram[address & (kMbc2RamSize - 1)] & 0x0F);
+  }
+
+  static void WriteRam(BankState& s, std::vector<uint8_t>& sram,
+                       uint16_t address, uint8_t value, uint64_t /*now*/) {
+    if (!s.ram_enable || sram.empty()) return;
+    sram[address & (kMbc2RamSize - 1)] = value & 0x0F;
+  }
+};
+
+// MBC3: 7-bit ROM bank, 4 RAM banks, RTC registers mapped via bank 0x08-0x0C
+struct Mbc3 : Mbc<Mbc3> {
+  static void WriteRegister(BankState& s, uint16_t address, uint8_t value,
+                            uint64_t now) {
+    switch (address >> 13) {
+      case 0: // 0x0000-0x1FFF: RAM and RTC enable
+        s.ram_enable = ((value & 0x0F) == 0x0A);
+        break;
+      case 1: // 0x2000-0x3FFF: ROM bank (0 reads as 1)
+        s.rom_bank = value & 0x7F;
+        if (s.rom_bank == 0) s.rom_bank = 1;
+        break;
+      case 2: // 0x4000-0x5FFF: RAM bank or RTC register select
+        s.ram_bank = value & 0x0F;
+        break;
+      default: // 0x6000-0x7FFF: latch clock data on a 0 -> 1 transition
+        if (s.rtc_latch_last == 0x00 && value == 0x01) s.rtc.Latch(now);
+        s.rtc_latch_last = value;
+        break;
+    }
+  }
+
+  static void UpdateWindows(BankState& s) {
+    s.romx_offset = (s.rom_bank & s.rom_bank_mask) * kBankSize;
+    s.ram_offset = (s.ram_bank & 0x03 & s.ram_bank_mask) * kExtRamSize;
+  }
+
+  static uint8_t ReadRam(const BankState& s, const std::vector<uint8_t>& sram,
+                         uint16_t address, uint64_t now) {
+    if (s.ram_bank >= 0x08) {
+      if (!s.ram_enable || s.ram_bank > 0x0C) return 0xFF;
+      return s.rtc.ReadLatched(s.ram_bank - 0x08);
+    }
+    return Mbc<Mbc3>::ReadRam(s, sram, address, now);
+  }
+
+  static void WriteRam(BankState& s, std::vector<uint8_t>& sram,
+                       uint16_t address, uint8_t value, uint64_t now) {
+    if (s.ram_bank >= 0x08) {
+      if (!s.ram_enable || s.ram_bank > 0x0C) return;
+      s.rtc.Write(s.ram_bank - 0x08, value, now);
+      return;
+    }
+    Mbc<Mbc3>::WriteRam(s, sram, address, value, now);
+  }
+};
+
+// MBC5: 9-bit ROM bank (bank 0 selectable), 4-bit RAM bank
+struct Mbc5 : Mbc<Mbc5> {
+  static void WriteRegister(BankState& s, uint16_t address, uint8_t value,
+                            uint64_t /*now*/) {
+    if (address < 0x2000) {
+      s.ram_enable = ((value & 0x0F) == 0x0A);
+    } else if (address < 0x3000) {
+      s.rom_bank = value;
+    } else if (address < 0x4000) {
+      s.bank_hi = value & 0x01;
+    } else if (address < 0x6000) {
+      s.ram_bank = value & 0x0F;
+    }
+  }
+
+  static void UpdateWindows(BankState& s) {
+    uint32_t bank = (static_cast<uint32_t>(s.bank_hi) << 8) | s.rom_bank;
+    s.romx_offset = (bank & s.rom_bank_mask) * kBankSize;
+    s.ram_offset = (s.ram_bank & s.ram_bank_mask) * uint32_t{kExtRamSize};
+  }
+};
+
+} // namespace gb
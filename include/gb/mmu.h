@@ -1,64 +1,412 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <deque>
+#include <span>
 #include <vector>
 
+#include "gb/interrupt.h"
+#include "gb/joypad.h"
+#include "gb/mbc.h"
+#include "gb/scheduler.h"
+#include "gb/serial.h"
+#include "gb/state.h"
+
 namespace gb {
 
-// Memory-map constants
-static constexpr uint16_t kBankSize = 0x4000;
+// Memory-map constants (cartridge bank sizes live in mbc.h)
 static constexpr uint16_t kVramSize = 0x2000;
-static constexpr uint16_t kExtRamSize = 0x2000;
 static constexpr uint16_t kWram0Size = 0x1000;
 static constexpr uint16_t kWram1Size = 0x1000;
 static constexpr uint16_t kOamSize = 0xA0;
 static constexpr uint16_t kIoSize = 0x80;
 static constexpr uint16_t kHramSize = 0x7F;
+// VRAM, WRAM bank 0 and WRAM bank 1, stored back to back in that order
+static constexpr uint16_t kRamBlockSize = kVramSize + kWram0Size + kWram1Size;
+
+// OAM DMA copies 160 bytes at one byte per M-cycle after a 1 M-cycle setup
+static constexpr uint32_t kOamDmaSetupCycles = 4;
+static constexpr uint32_t kOamDmaCycles = kOamSize * 4;
+
+// A write to something the PPU draws from: VRAM, OAM, or one of LCDC,
+// SCY, SCX, BGP, OBP0, OBP1, WY and WX. `cycle` is the MMU clock when it
+// landed, which for a CPU write is the start of the writing instruction
+// however many instructions its Step() ran (BasicCpu::SyncBus).
+struct PpuWrite {
+  uint64_t cycle;
+  uint16_t address;
+  uint8_t value;
+
+  bool operator==(const PpuWrite&) const = default;
+};
 
 class MMU {
  public:
-  // Get the singleton instance
+  MMU();
+  ~MMU() = default;
+
+  // Non-copyable, non-movable
+  MMU(const MMU&) = delete;
+  MMU& operator=(const MMU&) = delete;
+
+  // Shared default instance for code that does not own an MMU
   static MMU& Instance();
 
-  // Load the entire ROM into bank0 + bankN
+  // Load the entire ROM and select the mapper from header byte 0x0147
   void LoadROM(const std::vector<uint8_t>& rom_data);
 
-  // Read/write data from/to a specific address
-  uint8_t Read(uint16_t address) const;
-  void Write(uint16_t address, uint8_t value);
+  // Read/write data from/to a specific address. Dispatches straight into
+  // the access path instantiated for the cartridge's mapper.
+  uint8_t Read(uint16_t address) const { return (this->*read_)(address); }
+  void Write(uint16_t address, uint8_t value) {
+    (this->*write_)(address, value);
+  }
+  // The access path for `Mapper` itself, for callers that know the
+  // cartridge's mapper at compile time (MapperBus). Only valid while
+  // mbc_type() is the one `Mapper` implements.
+  template <typename Mapper>
+  uint8_t ReadFor(uint16_t address) const;
+  template <typename Mapper>
+  void WriteFor(uint16_t address, uint8_t value);
 
   // Reset all memory regions back to default values
   void Reset();
 
+  // Advance the emulated clock by the given number of T-cycles and run
+  // any scheduled events that became due
+  void Tick(uint32_t cycles) {
+    cycles_ += cycles;
+    if (cycles_ >= scheduler_.next()) RunEvents();
+  }
+  uint64_t cycles() const { return cycles_; }
+
+  // T-cycles until the next scheduled event or the idle limit, whichever
+  // comes first. The CPU may fast-forward an idle loop up to this point.
+  uint64_t CyclesUntilEvent() const {
+    uint64_t next = std::min(scheduler_.next(), idle_limit_);
+    return next > cycles_ ? next - cycles_ : 0;
+  }
+  // Cycle idle-loop skipping must stop short of (the end of the frame
+  // being run). Nothing is skipped until an owner sets one.
+  void set_idle_limit(uint64_t cycle) { idle_limit_ = cycle; }
+
+  // True while an OAM DMA transfer owns the bus
+  bool dma_active() const { return dma_active_; }
+
+  // Serial port (install a sink here to capture output)
+  Serial& serial() { return serial_; }
+  const Serial& serial() const { return serial_; }
+
+  // Joypad. SetJoypad() applies a button state immediately; QueueInput()
+  // applies it when the clock reaches `cycle` (at the next instruction
+  // boundary, or the next tick if `cycle` has already passed). Both raise
+  // the Joypad interrupt when a selected button goes down.
+  void SetJoypad(uint8_t buttons);
+  void QueueInput(uint64_t cycle, uint8_t buttons);
+  size_t pending_inputs() const { return inputs_.size(); }
+  const Joypad& joypad() const { return joypad_; }
+
+  // Set the interrupt's bit in IF
+  void RequestInterrupt(Interrupt interrupt) {
+    io_regs_[kIfAddress - 0xFF00] |= InterruptMask(interrupt);
+    UpdatePendingInterrupts();
+  }
+  // IE & IF over the five sources, kept current whenever either changes
+  // so the CPU's per-instruction check is a single load
+  uint8_t pending_interrupts() const { return pending_interrupts_; }
+
+  // Battery-backed cartridge RAM in .sav layout: raw SRAM, followed by the
+  // 48-byte RTC trailer on MBC3+TIMER carts. `unix_time` stamps the clock
+  // so it can catch up on load.
+  std::vector<uint8_t> SaveBattery(int64_t unix_time) const;
+  // Restore a .sav image. A missing or short RTC trailer leaves the clock
+  // untouched. Returns false if the SRAM part does not match the cartridge.
+  bool LoadBattery(const std::vector<uint8_t>& data, int64_t unix_time);
+
+  // Save-state snapshot of everything but the ROM image. LoadState()
+  // expects the same cartridge to be loaded and returns false (with state
+  // partially overwritten) if the snapshot does not fit it.
+  void SaveState(StateWriter& w) const;
+  bool LoadState(StateReader& r);
+
+  // Fill in the hashes of the memory regions and of kMmu
+  void HashRegions(StateHashes& hashes) const;
+
+  // Cartridge inspection
+  MbcType mbc_type() const { return mbc_type_; }
+  const std::vector<uint8_t>& sram() const { return sram_; }
+  // ROM image (padded to 2^n banks) and the current bank windows into it
+  const std::vector<uint8_t>& rom() const { return rom_; }
+  const BankState& banks() const { return banks_; }
+
+  // Host pointer to the `length` bytes at `address` if they all lie in one
+  // plain region (a ROM bank window, VRAM or WRAM; WritableRange() only
+  // the latter two, and VRAM not while the PPU log is on) and no OAM DMA
+  // is running, else nullptr. Accessing
+  // them directly is the same as Read()/Write() byte by byte.
+  const uint8_t* ReadableRange(uint16_t address, uint32_t length) const;
+  uint8_t* WritableRange(uint16_t address, uint32_t length);
+
+  // PPU write log, off by default. While it is on, every change to what
+  // the PPU reads is appended in order, so a renderer that copies the
+  // LCD registers, VRAM and OAM when it turns the log on can replay it
+  // and rasterise a whole frame later, or on another thread, with each
+  // line seeing the state it had. OAM DMA logs its 160 bytes when the
+  // transfer completes, and WritableRange() refuses VRAM so bulk loops
+  // write byte by byte. Reset(), LoadState() and stores straight into a
+  // UseRamBlock() block are not logged; copy the state again after them.
+  void set_ppu_log(bool enabled) { ppu_log_enabled_ = enabled; }
+  bool ppu_log_enabled() const { return ppu_log_enabled_; }
+  const std::vector<PpuWrite>& ppu_log() const { return ppu_log_; }
+  // Hand the writes logged so far (e.g. one frame's) to `out` and carry
+  // on into its old buffer, emptied
+  void TakePpuLog(std::vector<PpuWrite>* out) {
+    out->swap(ppu_log_);
+    ppu_log_.clear();
+  }
+
+  // Move VRAM and WRAM (kRamBlockSize bytes, laid out as VRAM, WRAM0,
+  // WRAM1) into `block`, e.g. shared memory that is also mapped elsewhere.
+  // The contents move along. nullptr moves them back into the MMU.
+  void UseRamBlock(uint8_t* block);
+
  private:
-  MMU();
-  ~MMU() = default;
+  // Raw bus access underneath the DMA bus-conflict check
+  template <typename Mapper>
+  uint8_t ReadBus(uint16_t address) const;
+  template <typename Mapper>
+  void WriteBus(uint16_t address, uint8_t value);
+  // CPU read while OAM DMA is running (address below 0xFF00)
+  template <typename Mapper>
+  uint8_t ReadDuringDma(uint16_t address) const;
 
-  // Non-copyable, non-movable
-  MMU(const MMU&) = delete;
-  MMU& operator=(const MMU&) = delete;
+  // I/O registers (0xFF00-0xFF7F). Each has an entry in kIoRegisters;
+  // registers without handlers are plain bytes in io_regs_ where reads
+  // OR in `read_ones` (unused or write-only bits) and writes only change
+  // the `writable` bits.
+  struct IoRegister {
+    uint8_t read_ones = 0x00;
+    uint8_t writable = 0xFF;
+    bool ppu = false; // Goes to the PPU write log
+    uint8_t (MMU::*read)(uint16_t) const = nullptr;
+    void (MMU::*write)(uint16_t, uint8_t) = nullptr;
+  };
+  static const std::array<IoRegister, kIoSize> kIoRegisters;
+  uint8_t ReadIo(uint16_t address) const;
+  void WriteIo(uint16_t address, uint8_t value);
+
+  // I/O register handlers
+  uint8_t ReadJoypad(uint16_t address) const;
+  void WriteJoypad(uint16_t address, uint8_t value);
+  uint8_t ReadSerialData(uint16_t address) const;
+  void WriteSerialData(uint16_t address, uint8_t value);
+  uint8_t ReadSerialControl(uint16_t address) const;
+  void WriteSerialControl(uint16_t address, uint8_t value);
+  void WriteInterruptFlags(uint16_t address, uint8_t value);
+  void WriteOamDma(uint16_t address, uint8_t value);
+
+  // Dispatch every event that is due at the current cycle
+  void RunEvents();
+
+  // Apply queued input events that are due and schedule the next one
+  void ApplyInputs();
+
+  // OAM DMA: start on a write to 0xFF46, copy the page when it completes
+  void StartOamDma(uint8_t page);
+  void FinishOamDma();
+  // True if `address` sits on the same bus the DMA is reading from
+  bool DmaConflicts(uint16_t address) const;
+  // Host pointer to a 256-byte source page, or nullptr if the page is not
+  // plain memory (mapper-controlled cartridge RAM)
+  const uint8_t* PagePointer(uint16_t address) const;
+
+  // The non-memory part of SaveState(), from IE onwards
+  void SaveControlState(StateWriter& w) const;
+
+  void LogPpuWrite(uint16_t address, uint8_t value) {
+    if (ppu_log_enabled_) [[unlikely]] {
+      ppu_log_.push_back(PpuWrite{cycles_, address, value});
+    }
+  }
 
-  // Helpers for current bank indices
-  uint8_t CurrentRomBank() const;
-  uint8_t CurrentRamBank() const;
+  void UpdatePendingInterrupts() {
+    pending_interrupts_ =
+        interrupt_enable_ & io_regs_[kIfAddress - 0xFF00] & 0x1F;
+  }
+
+  // Point read_/write_ at the instantiation for the given mapper
+  void SelectMapper(MbcType type);
+
+  using ReadFn = uint8_t (MMU::*)(uint16_t) const;
+  using WriteFn = void (MMU::*)(uint16_t, uint8_t);
+  ReadFn read_;
+  WriteFn write_;
 
   // Raw memory regions
-  std::vector<uint8_t> rom_; // Entire ROM image
-  std::array<uint8_t, kVramSize> vram_;
-  std::array<uint8_t, kExtRamSize> ext_ram_;
-  std::array<uint8_t, kWram0Size> wram0_;
-  std::array<uint8_t, kWram1Size> wram1_;
+  std::vector<uint8_t> rom_;  // Entire ROM image, padded to 2^n banks
+  std::vector<uint8_t> sram_; // Cartridge RAM (up to 128 KiB)
+  std::array<uint8_t, kRamBlockSize> ram_storage_;
+  std::span<uint8_t, kVramSize> vram_{ram_storage_.data(), kVramSize};
+  std::span<uint8_t, kWram0Size> wram0_{vram_.data() + kVramSize, kWram0Size};
+  std::span<uint8_t, kWram1Size> wram1_{wram0_.data() + kWram0Size,
+                                        kWram1Size};
   std::array<uint8_t, kOamSize> oam_;
   std::array<uint8_t, kIoSize> io_regs_;
   std::array<uint8_t, kHramSize> hram_;
   uint8_t interrupt_enable_ = 0;
+  uint8_t pending_interrupts_ = 0;
+
+  // Emulated time in T-cycles and pending hardware events
+  uint64_t cycles_ = 0;
+  Scheduler scheduler_;
+  uint64_t idle_limit_ = 0;
+
+  // OAM DMA state
+  bool dma_active_ = false;
+  uint16_t dma_source_ = 0; // Source address (page aligned)
+  uint64_t dma_start_ = 0;  // Cycle the first byte is transferred
+
+  // PPU write log
+  bool ppu_log_enabled_ = false;
+  std::vector<PpuWrite> ppu_log_;
+
+  // Serial port
+  Serial serial_;
 
-  // MBC1 registers
-  bool    ram_enable_        = false;  // 0x0000–0x1FFF
-  uint8_t rom_bank_low5_     = 1;      // 0x2000–0x3FFF (bits 0–4)
-  uint8_t rom_bank_high2_    = 0;      // 0x4000–0x5FFF (bits 5–6)
-  uint8_t banking_mode_      = 0;      // 0x6000–0x7FFF (0=ROM, 1=RAM)
+  // Joypad and host input events not yet applied, in cycle order
+  Joypad joypad_;
+  std::deque<InputEvent> inputs_;
+
+  // Cartridge mapper
+  MbcType mbc_type_ = MbcType::kNone;
+  bool has_rtc_ = false;
+  BankState banks_;
 };
 
+// Per-mapper access paths, here so a bus compiled for one mapper
+// (MapperBus) can inline them
+template <typename Mapper>
+uint8_t MMU::ReadFor(uint16_t address) const {
+  if (dma_active_ && address < 0xFF00) [[unlikely]] {
+    return ReadDuringDma<Mapper>(address);
+  }
+  return ReadBus<Mapper>(address);
+}
+
+template <typename Mapper>
+uint8_t MMU::ReadDuringDma(uint16_t address) const {
+  // OAM is locked for the whole transfer
+  if (address >= 0xFE00) return 0xFF;
+  if (!DmaConflicts(address)) return ReadBus<Mapper>(address);
+  // Bus conflict: the CPU sees the byte the DMA is currently moving
+  uint64_t index = cycles_ > dma_start_ ? (cycles_ - dma_start_) / 4 : 0;
+  if (index >= kOamSize) index = kOamSize - 1;
+  return ReadBus<Mapper>(static_cast<uint16_t>(dma_source_ + index));
+}
+
+template <typename Mapper>
+uint8_t MMU::ReadBus(uint16_t address) const {
+  if (address < 0x4000) {
+    // Bank 0 window (MBC1 mode 1 can remap it)
+    return rom_[banks_.rom0_offset + address];
+  }
+  if (address < 0x8000) {
+    // Switchable ROM bank
+    return rom_[banks_.romx_offset + (address - kBankSize)];
+  }
+  if (address < 0xA000) {
+    return vram_[address - 0x8000];
+  }
+  if (address < 0xC000) {
+    // External RAM (banked, mapper specific)
+    return Mapper::ReadRam(banks_, sram_, address, cycles_);
+  }
+  if (address < 0xD000) {
+    return wram0_[address - 0xC000];
+  }
+  if (address < 0xE000) {
+    return wram1_[address - 0xD000];
+  }
+  if (address < 0xFE00) {
+    // Echo
+    return ReadBus<Mapper>(address - 0x2000);
+  }
+  if (address < 0xFEA0) {
+    return oam_[address - 0xFE00];
+  }
+  if (address < 0xFF00) {
+    return 0xFF;  // unusable
+  }
+  if (address < 0xFF80) {
+    return ReadIo(address);
+  }
+  if (address < 0xFFFF) {
+    return hram_[address - 0xFF80];
+  }
+  return interrupt_enable_;
+}
+
+template <typename Mapper>
+void MMU::WriteFor(uint16_t address, uint8_t value) {
+  if (dma_active_ && address < 0xFF00) [[unlikely]] {
+    // OAM and the bus the DMA is using ignore CPU writes
+    if (address >= 0xFE00 || DmaConflicts(address)) return;
+  }
+  WriteBus<Mapper>(address, value);
+}
+
+template <typename Mapper>
+void MMU::WriteBus(uint16_t address, uint8_t value) {
+  if (address < 0x8000) {
+    // Mapper control registers
+    Mapper::WriteControl(banks_, address, value, cycles_);
+    return;
+  }
+  if (address < 0xA000) {
+    // VRAM
+    vram_[address - 0x8000] = value;
+    LogPpuWrite(address, value);
+    return;
+  }
+  if (address < 0xC000) {
+    // External RAM (banked, mapper specific)
+    Mapper::WriteRam(banks_, sram_, address, value, cycles_);
+    return;
+  }
+  if (address < 0xD000) {
+    wram0_[address - 0xC000] = value;
+    return;
+  }
+  if (address < 0xE000) {
+    wram1_[address - 0xD000] = value;
+    return;
+  }
+  if (address < 0xFE00) {
+    // Echo
+    WriteBus<Mapper>(address - 0x2000, value);
+    return;
+  }
+  if (address < 0xFEA0) {
+    oam_[address - 0xFE00] = value;
+    LogPpuWrite(address, value);
+    return;
+  }
+  if (address < 0xFF00) {
+    // Unusable
+    return;
+  }
+  if (address < 0xFF80) {
+    WriteIo(address, value);
+    return;
+  }
+  if (address < 0xFFFF) {
+    hram_[address - 0xFF80] = value;
+    return;
+  }
+  interrupt_enable_ = value;
+  UpdatePendingInterrupts();
+}
+
 } // namespace gb
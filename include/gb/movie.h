@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "gb/emulator.h"
+
+namespace gb {
+
+// One joypad change: the full button state from `offset` T-cycles into
+// frame `frame` (counted from the start of the movie)
+struct MovieInput {
+  uint32_t frame;
+  uint32_t offset;
+  uint8_t buttons;
+};
+
+// Deterministic input movie: a starting point, the joypad changes that
+// were applied, and the state hash after every frame so playback can
+// pinpoint the first frame that diverges.
+//
+// Files are the Serialize() bytes, host byte order like save states.
+struct Movie {
+  uint64_t rom_hash = 0;             // FNV-1a of the ROM image
+  std::vector<uint8_t> start_state;  // Empty: power-on right after LoadROM
+  std::vector<MovieInput> inputs;    // Ordered by (frame, offset)
+  std::vector<uint64_t> frame_hashes; // Emulator::StateHash() per frame
+
+  uint32_t frames() const {
+    return static_cast<uint32_t>(frame_hashes.size());
+  }
+
+  std::vector<uint8_t> Serialize() const;
+  // Returns false if `data` is not a complete movie
+  bool Deserialize(const uint8_t* data, size_t size);
+};
+
+uint64_t RomHash(const std::vector<uint8_t>& rom);
+
+// Records a movie while driving an emulator frame by frame
+class MovieRecorder {
+ public:
+  // Power the emulator on with `rom` and record from there, or (with
+  // `from_current_state`) record from whatever the emulator, which must
+  // already have `rom` loaded, is doing now.
+  MovieRecorder(Emulator& emu, const std::vector<uint8_t>& rom,
+                bool from_current_state = false);
+
+  // Hold `buttons` from `offset` T-cycles into the next RunFrame()
+  void QueueInput(uint32_t offset, uint8_t buttons);
+
+  // Run one frame with the queued input and record its hash
+  void RunFrame();
+
+  const Movie& movie() const { return movie_; }
+
+ private:
+  Emulator& emu_;
+  Movie movie_;
+  size_t first_pending_ = 0; // Inputs from here on belong to the next frame
+};
+
+struct PlaybackResult {
+  bool rom_matches = false;
+  uint32_t frames = 0;        // Frames played
+  int64_t first_desync = -1;  // First frame whose hash differed, or -1
+  double seconds = 0;         // Wall time spent emulating
+
+  bool ok() const { return rom_matches && first_desync < 0; }
+};
+
+// Replay `movie` on `emu` as fast as possible, loading `rom` first. With
+// `verify`, every frame's state hash is checked and playback stops at the
+// first mismatch. `on_frame`, if set, runs after each frame with its index.
+PlaybackResult PlayMovie(
+    Emulator& emu, const std::vector<uint8_t>& rom, const Movie& movie,
+    bool verify = true,
+    const std::function<void(uint32_t)>& on_frame = nullptr);
+
+// Queue the inputs of `frame`, starting at `index`, relative to the
+// cycle the frame starts at (for callers that replay a movie themselves).
+// Returns the index of the first input of the following frame.
+size_t QueueFrameInputs(Emulator& emu, const std::vector<MovieInput>& inputs,
+                        size_t index, uint32_t frame);
+
+} // namespace gb
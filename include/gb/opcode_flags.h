@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "gb/cpu.h"
+
+namespace gb {
+
+// Flags (Z/N/H/C masks) an instruction reads, and flags it always
+// overwrites. A flag written only on some paths, or by only some of the
+// CB opcodes, does not count as written.
+struct OpcodeFlags {
+  uint8_t reads;
+  uint8_t writes;
+};
+
+// Flag effects of an opcode, from its opcode_list.h mnemonic
+constexpr OpcodeFlags FlagsForMnemonic(std::string_view name) {
+  constexpr uint8_t kZ = kZeroFlagMask;
+  constexpr uint8_t kN = kSubtractFlagMask;
+  constexpr uint8_t kH = kHalfCarryFlagMask;
+  constexpr uint8_t kC = kCarryFlagMask;
+  constexpr uint8_t kAll = kZ | kN | kH | kC;
+  auto starts = [&](std::string_view prefix) {
+    return name.starts_with(prefix);
+  };
+  if (starts("ADD_HL_")) return {0, kN | kH | kC};
+  if (starts("ADC_") || starts("SBC_")) return {kC, kAll};
+  if (starts("ADD_") || starts("SUB_") || starts("AND_") || starts("XOR_") ||
+      starts("OR_") || starts("CP_") || name == "LD_HL_SPplusr8" ||
+      name == "RLCA" || name == "RRCA" || name == "POP_AF") {
+    return {0, kAll};
+  }
+  if (name == "RLA" || name == "RRA") return {kC, kAll};
+  // 8-bit INC/DEC (INC_B, DEC_addrHL); the 16-bit ones leave flags alone
+  if ((starts("INC_") || starts("DEC_")) &&
+      (name.size() == 5 || name.ends_with("addrHL"))) {
+    return {0, kZ | kN | kH};
+  }
+  if (name == "DAA") return {kN | kH | kC, kZ | kH | kC};
+  if (name == "CPL") return {0, kN | kH};
+  if (name == "SCF") return {0, kN | kH | kC};
+  if (name == "CCF") return {kC, kN | kH | kC};
+  // PUSH AF stores them; a CB opcode may read C (RL, RR)
+  if (name == "PUSH_AF" || name == "PREFIX_CB") return {kAll, 0};
+  // Conditional JR/JP/CALL/RET
+  if (starts("JR_") || starts("JP_") || starts("CALL_") || starts("RET_")) {
+    if (name.find("_NZ") != name.npos || name.find("_Z") != name.npos) {
+      return {kZ, 0};
+    }
+    if (name.find("_NC") != name.npos || name.find("_C") != name.npos) {
+      return {kC, 0};
+    }
+  }
+  return {0, 0};
+}
+
+// Flag effects of all 256 primary opcodes. Only the instruction itself is
+// described: flags still reach whatever runs after a jump or interrupt.
+inline constexpr std::array<OpcodeFlags, 256> kOpcodeFlags = [] {
+  std::array<OpcodeFlags, 256> t{};
+#define OPCODE(name, code, cycles, taken) t[code] = FlagsForMnemonic(#name);
+#include "gb/opcode_list.h"
+#undef OPCODE
+  return t;
+}();
+
+// True if `next`, run right after `opcode`, overwrites every flag
+// `opcode` writes without reading any of them first
+constexpr bool FlagsDeadAfter(uint8_t opcode, uint8_t next) {
+  uint8_t written = kOpcodeFlags[opcode].writes;
+  return written != 0 && (kOpcodeFlags[next].writes & written) == written &&
+         (kOpcodeFlags[next].reads & written) == 0;
+}
+
+} // namespace gb
@@ -1,258 +1,260 @@
-// Defines all 256 primary opcodes. Format: OPCODE(Mnemonic, 0xNN)
+// Defines all 256 primary opcodes. Format:
+//   OPCODE(Mnemonic, 0xNN, T-cycles, T-cycles when a conditional branch is taken)
+// Cycle counts cover the whole instruction, opcode fetch included.
 // Opcodes 0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 0xEC, 0xED, 0xF4, 0xFC, 0xFD are undefined.
-OPCODE(NOP,             0x00)
-OPCODE(LD_BC_d16,       0x01)
-OPCODE(LD_addrBC_A,     0x02)
-OPCODE(INC_BC,          0x03)
-OPCODE(INC_B,           0x04)
-OPCODE(DEC_B,           0x05)
-OPCODE(LD_B_d8,         0x06)
-OPCODE(RLCA,            0x07)
-OPCODE(LD_a16_SP,       0x08)
-OPCODE(ADD_HL_BC,       0x09)
-OPCODE(LD_A_addrBC,     0x0A)
-OPCODE(DEC_BC,          0x0B)
-OPCODE(INC_C,           0x0C)
-OPCODE(DEC_C,           0x0D)
-OPCODE(LD_C_d8,         0x0E)
-OPCODE(RRCA,            0x0F)
-OPCODE(STOP,            0x10)
-OPCODE(LD_DE_d16,       0x11)
-OPCODE(LD_addrDE_A,     0x12)
-OPCODE(INC_DE,          0x13)
-OPCODE(INC_D,           0x14)
-OPCODE(DEC_D,           0x15)
-OPCODE(LD_D_d8,         0x16)
-OPCODE(RLA,             0x17)
-OPCODE(JR_r8,           0x18)
-OPCODE(ADD_HL_DE,       0x19)
-OPCODE(LD_A_addrDE,     0x1A)
-OPCODE(DEC_DE,          0x1B)
-OPCODE(INC_E,           0x1C)
-OPCODE(DEC_E,           0x1D)
-OPCODE(LD_E_d8,         0x1E)
-OPCODE(RRA,             0x1F)
-OPCODE(JR_NZ_r8,        0x20)
-OPCODE(LD_HL_d16,       0x21)
-OPCODE(LD_addrHLinc_A,  0x22) // LD (HL+), A
-OPCODE(INC_HL,          0x23)
-OPCODE(INC_H,           0x24)
-OPCODE(DEC_H,           0x25)
-OPCODE(LD_H_d8,         0x26)
-OPCODE(DAA,             0x27)
-OPCODE(JR_Z_r8,         0x28)
-OPCODE(ADD_HL_HL,       0x29)
-OPCODE(LD_A_addrHLinc,  0x2A) // LD A, (HL+)
-OPCODE(DEC_HL,          0x2B)
-OPCODE(INC_L,           0x2C)
-OPCODE(DEC_L,           0x2D)
-OPCODE(LD_L_d8,         0x2E)
-OPCODE(CPL,             0x2F)
-OPCODE(JR_NC_r8,        0x30)
-OPCODE(LD_SP_d16,       0x31)
-OPCODE(LD_addrHLdec_A,  0x32) // LD (HL-), A
-OPCODE(INC_SP,          0x33)
-OPCODE(INC_addrHL,      0x34)
-OPCODE(DEC_addrHL,      0x35)
-OPCODE(LD_addrHL_d8,    0x36)
-OPCODE(SCF,             0x37)
-OPCODE(JR_C_r8,         0x38)
-OPCODE(ADD_HL_SP,       0x39)
-OPCODE(LD_A_addrHLdec,  0x3A) // LD A, (HL-)
-OPCODE(DEC_SP,          0x3B)
-OPCODE(INC_A,           0x3C)
-OPCODE(DEC_A,           0x3D)
-OPCODE(LD_A_d8,         0x3E)
-OPCODE(CCF,             0x3F)
-OPCODE(LD_B_B,          0x40)
-OPCODE(LD_B_C,          0x41)
-OPCODE(LD_B_D,          0x42)
-OPCODE(LD_B_E,          0x43)
-OPCODE(LD_B_H,          0x44)
-OPCODE(LD_B_L,          0x45)
-OPCODE(LD_B_addrHL,     0x46)
-OPCODE(LD_B_A,          0x47)
-OPCODE(LD_C_B,          0x48)
-OPCODE(LD_C_C,          0x49)
-OPCODE(LD_C_D,          0x4A)
-OPCODE(LD_C_E,          0x4B)
-OPCODE(LD_C_H,          0x4C)
-OPCODE(LD_C_L,          0x4D)
-OPCODE(LD_C_addrHL,     0x4E)
-OPCODE(LD_C_A,          0x4F)
-OPCODE(LD_D_B,          0x50)
-OPCODE(LD_D_C,          0x51)
-OPCODE(LD_D_D,          0x52)
-OPCODE(LD_D_E,          0x53)
-OPCODE(LD_D_H,          0x54)
-OPCODE(LD_D_L,          0x55)
-OPCODE(LD_D_addrHL,     0x56)
-OPCODE(LD_D_A,          0x57)
-OPCODE(LD_E_B,          0x58)
-OPCODE(LD_E_C,          0x59)
-OPCODE(LD_E_D,          0x5A)
-OPCODE(LD_E_E,          0x5B)
-OPCODE(LD_E_H,          0x5C)
-OPCODE(LD_E_L,          0x5D)
-OPCODE(LD_E_addrHL,     0x5E)
-OPCODE(LD_E_A,          0x5F)
-OPCODE(LD_H_B,          0x60)
-OPCODE(LD_H_C,          0x61)
-OPCODE(LD_H_D,          0x62)
-OPCODE(LD_H_E,          0x63)
-OPCODE(LD_H_H,          0x64)
-OPCODE(LD_H_L,          0x65)
-OPCODE(LD_H_addrHL,     0x66)
-OPCODE(LD_H_A,          0x67)
-OPCODE(LD_L_B,          0x68)
-OPCODE(LD_L_C,          0x69)
-OPCODE(LD_L_D,          0x6A)
-OPCODE(LD_L_E,          0x6B)
-OPCODE(LD_L_H,          0x6C)
-OPCODE(LD_L_L,          0x6D)
-OPCODE(LD_L_addrHL,     0x6E)
-OPCODE(LD_L_A,          0x6F)
-OPCODE(LD_addrHL_B,     0x70)
-OPCODE(LD_addrHL_C,     0x71)
-OPCODE(LD_addrHL_D,     0x72)
-OPCODE(LD_addrHL_E,     0x73)
-OPCODE(LD_addrHL_H,     0x74)
-OPCODE(LD_addrHL_L,     0x75)
-OPCODE(HALT,            0x76)
-OPCODE(LD_addrHL_A,     0x77)
-OPCODE(LD_A_B,          0x78)
-OPCODE(LD_A_C,          0x79)
-OPCODE(LD_A_D,          0x7A)
-OPCODE(LD_A_E,          0x7B)
-OPCODE(LD_A_H,          0x7C)
-OPCODE(LD_A_L,          0x7D)
-OPCODE(LD_A_addrHL,     0x7E)
-OPCODE(LD_A_A,          0x7F)
-OPCODE(ADD_A_B,         0x80)
-OPCODE(ADD_A_C,         0x81)
-OPCODE(ADD_A_D,         0x82)
-OPCODE(ADD_A_E,         0x83)
-OPCODE(ADD_A_H,         0x84)
-OPCODE(ADD_A_L,         0x85)
-OPCODE(ADD_A_addrHL,    0x86)
-OPCODE(ADD_A_A,         0x87)
-OPCODE(ADC_A_B,         0x88)
-OPCODE(ADC_A_C,         0x89)
-OPCODE(ADC_A_D,         0x8A)
-OPCODE(ADC_A_E,         0x8B)
-OPCODE(ADC_A_H,         0x8C)
-OPCODE(ADC_A_L,         0x8D)
-OPCODE(ADC_A_addrHL,    0x8E)
-OPCODE(ADC_A_A,         0x8F)
-OPCODE(SUB_B,           0x90)
-OPCODE(SUB_C,           0x91)
-OPCODE(SUB_D,           0x92)
-OPCODE(SUB_E,           0x93)
-OPCODE(SUB_H,           0x94)
-OPCODE(SUB_L,           0x95)
-OPCODE(SUB_addrHL,      0x96)
-OPCODE(SUB_A,           0x97)
-OPCODE(SBC_A_B,         0x98)
-OPCODE(SBC_A_C,         0x99)
-OPCODE(SBC_A_D,         0x9A)
-OPCODE(SBC_A_E,         0x9B)
-OPCODE(SBC_A_H,         0x9C)
-OPCODE(SBC_A_L,         0x9D)
-OPCODE(SBC_A_addrHL,    0x9E)
-OPCODE(SBC_A_A,         0x9F)
-OPCODE(AND_B,           0xA0)
-OPCODE(AND_C,           0xA1)
-OPCODE(AND_D,           0xA2)
-OPCODE(AND_E,           0xA3)
-OPCODE(AND_H,           0xA4)
-OPCODE(AND_L,           0xA5)
-OPCODE(AND_addrHL,      0xA6)
-OPCODE(AND_A,           0xA7)
-OPCODE(XOR_B,           0xA8)
-OPCODE(XOR_C,           0xA9)
-OPCODE(XOR_D,           0xAA)
-OPCODE(XOR_E,           0xAB)
-OPCODE(XOR_H,           0xAC)
-OPCODE(XOR_L,           0xAD)
-OPCODE(XOR_addrHL,      0xAE)
-OPCODE(XOR_A,           0xAF)
-OPCODE(OR_B,            0xB0)
-OPCODE(OR_C,            0xB1)
-OPCODE(OR_D,            0xB2)
-OPCODE(OR_E,            0xB3)
-OPCODE(OR_H,            0xB4)
-OPCODE(OR_L,            0xB5)
-OPCODE(OR_addrHL,       0xB6)
-OPCODE(OR_A,            0xB7)
-OPCODE(CP_B,            0xB8)
-OPCODE(CP_C,            0xB9)
-OPCODE(CP_D,            0xBA)
-OPCODE(CP_E,            0xBB)
-OPCODE(CP_H,            0xBC)
-OPCODE(CP_L,            0xBD)
-OPCODE(CP_addrHL,       0xBE)
-OPCODE(CP_A,            0xBF)
-OPCODE(RET_NZ,          0xC0)
-OPCODE(POP_BC,          0xC1)
-OPCODE(JP_NZ_a16,       0xC2)
-OPCODE(JP_a16,          0xC3)
-OPCODE(CALL_NZ_a16,     0xC4)
-OPCODE(PUSH_BC,         0xC5)
-OPCODE(ADD_A_d8,        0xC6)
-OPCODE(RST_00H,         0xC7)
-OPCODE(RET_Z,           0xC8)
-OPCODE(RET,             0xC9)
-OPCODE(JP_Z_a16,        0xCA)
-OPCODE(PREFIX_CB,       0xCB) // Special case: Handled separately
-OPCODE(CALL_Z_a16,      0xCC)
-OPCODE(CALL_a16,        0xCD)
-OPCODE(ADC_A_d8,        0xCE)
-OPCODE(RST_08H,         0xCF)
-OPCODE(RET_NC,          0xD0)
-OPCODE(POP_DE,          0xD1)
-OPCODE(JP_NC_a16,       0xD2)
+OPCODE(NOP,             0x00,  4,  4)
+OPCODE(LD_BC_d16,       0x01, 12, 12)
+OPCODE(LD_addrBC_A,     0x02,  8,  8)
+OPCODE(INC_BC,          0x03,  8,  8)
+OPCODE(INC_B,           0x04,  4,  4)
+OPCODE(DEC_B,           0x05,  4,  4)
+OPCODE(LD_B_d8,         0x06,  8,  8)
+OPCODE(RLCA,            0x07,  4,  4)
+OPCODE(LD_a16_SP,       0x08, 20, 20)
+OPCODE(ADD_HL_BC,       0x09,  8,  8)
+OPCODE(LD_A_addrBC,     0x0A,  8,  8)
+OPCODE(DEC_BC,          0x0B,  8,  8)
+OPCODE(INC_C,           0x0C,  4,  4)
+OPCODE(DEC_C,           0x0D,  4,  4)
+OPCODE(LD_C_d8,         0x0E,  8,  8)
+OPCODE(RRCA,            0x0F,  4,  4)
+OPCODE(STOP,            0x10,  4,  4)
+OPCODE(LD_DE_d16,       0x11, 12, 12)
+OPCODE(LD_addrDE_A,     0x12,  8,  8)
+OPCODE(INC_DE,          0x13,  8,  8)
+OPCODE(INC_D,           0x14,  4,  4)
+OPCODE(DEC_D,           0x15,  4,  4)
+OPCODE(LD_D_d8,         0x16,  8,  8)
+OPCODE(RLA,             0x17,  4,  4)
+OPCODE(JR_r8,           0x18, 12, 12)
+OPCODE(ADD_HL_DE,       0x19,  8,  8)
+OPCODE(LD_A_addrDE,     0x1A,  8,  8)
+OPCODE(DEC_DE,          0x1B,  8,  8)
+OPCODE(INC_E,           0x1C,  4,  4)
+OPCODE(DEC_E,           0x1D,  4,  4)
+OPCODE(LD_E_d8,         0x1E,  8,  8)
+OPCODE(RRA,             0x1F,  4,  4)
+OPCODE(JR_NZ_r8,        0x20,  8, 12)
+OPCODE(LD_HL_d16,       0x21, 12, 12)
+OPCODE(LD_addrHLinc_A,  0x22,  8,  8) // LD (HL+), A
+OPCODE(INC_HL,          0x23,  8,  8)
+OPCODE(INC_H,           0x24,  4,  4)
+OPCODE(DEC_H,           0x25,  4,  4)
+OPCODE(LD_H_d8,         0x26,  8,  8)
+OPCODE(DAA,             0x27,  4,  4)
+OPCODE(JR_Z_r8,         0x28,  8, 12)
+OPCODE(ADD_HL_HL,       0x29,  8,  8)
+OPCODE(LD_A_addrHLinc,  0x2A,  8,  8) // LD A, (HL+)
+OPCODE(DEC_HL,          0x2B,  8,  8)
+OPCODE(INC_L,           0x2C,  4,  4)
+OPCODE(DEC_L,           0x2D,  4,  4)
+OPCODE(LD_L_d8,         0x2E,  8,  8)
+OPCODE(CPL,             0x2F,  4,  4)
+OPCODE(JR_NC_r8,        0x30,  8, 12)
+OPCODE(LD_SP_d16,       0x31, 12, 12)
+OPCODE(LD_addrHLdec_A,  0x32,  8,  8) // LD (HL-), A
+OPCODE(INC_SP,          0x33,  8,  8)
+OPCODE(INC_addrHL,      0x34, 12, 12)
+OPCODE(DEC_addrHL,      0x35, 12, 12)
+OPCODE(LD_addrHL_d8,    0x36, 12, 12)
+OPCODE(SCF,             0x37,  4,  4)
+OPCODE(JR_C_r8,         0x38,  8, 12)
+OPCODE(ADD_HL_SP,       0x39,  8,  8)
+OPCODE(LD_A_addrHLdec,  0x3A,  8,  8) // LD A, (HL-)
+OPCODE(DEC_SP,          0x3B,  8,  8)
+OPCODE(INC_A,           0x3C,  4,  4)
+OPCODE(DEC_A,           0x3D,  4,  4)
+OPCODE(LD_A_d8,         0x3E,  8,  8)
+OPCODE(CCF,             0x3F,  4,  4)
+OPCODE(LD_B_B,          0x40,  4,  4)
+OPCODE(LD_B_C,          0x41,  4,  4)
+OPCODE(LD_B_D,          0x42,  4,  4)
+OPCODE(LD_B_E,          0x43,  4,  4)
+OPCODE(LD_B_H,          0x44,  4,  4)
+OPCODE(LD_B_L,          0x45,  4,  4)
+OPCODE(LD_B_addrHL,     0x46,  8,  8)
+OPCODE(LD_B_A,          0x47,  4,  4)
+OPCODE(LD_C_B,          0x48,  4,  4)
+OPCODE(LD_C_C,          0x49,  4,  4)
+OPCODE(LD_C_D,          0x4A,  4,  4)
+OPCODE(LD_C_E,          0x4B,  4,  4)
+OPCODE(LD_C_H,          0x4C,  4,  4)
+OPCODE(LD_C_L,          0x4D,  4,  4)
+OPCODE(LD_C_addrHL,     0x4E,  8,  8)
+OPCODE(LD_C_A,          0x4F,  4,  4)
+OPCODE(LD_D_B,          0x50,  4,  4)
+OPCODE(LD_D_C,          0x51,  4,  4)
+OPCODE(LD_D_D,          0x52,  4,  4)
+OPCODE(LD_D_E,          0x53,  4,  4)
+OPCODE(LD_D_H,          0x54,  4,  4)
+OPCODE(LD_D_L,          0x55,  4,  4)
+OPCODE(LD_D_addrHL,     0x56,  8,  8)
+OPCODE(LD_D_A,          0x57,  4,  4)
+OPCODE(LD_E_B,          0x58,  4,  4)
+OPCODE(LD_E_C,          0x59,  4,  4)
+OPCODE(LD_E_D,          0x5A,  4,  4)
+OPCODE(LD_E_E,          0x5B,  4,  4)
+OPCODE(LD_E_H,          0x5C,  4,  4)
+OPCODE(LD_E_L,          0x5D,  4,  4)
+OPCODE(LD_E_addrHL,     0x5E,  8,  8)
+OPCODE(LD_E_A,          0x5F,  4,  4)
+OPCODE(LD_H_B,          0x60,  4,  4)
+OPCODE(LD_H_C,          0x61,  4,  4)
+OPCODE(LD_H_D,          0x62,  4,  4)
+OPCODE(LD_H_E,          0x63,  4,  4)
+OPCODE(LD_H_H,          0x64,  4,  4)
+OPCODE(LD_H_L,          0x65,  4,  4)
+OPCODE(LD_H_addrHL,     0x66,  8,  8)
+OPCODE(LD_H_A,          0x67,  4,  4)
+OPCODE(LD_L_B,          0x68,  4,  4)
+OPCODE(LD_L_C,          0x69,  4,  4)
+OPCODE(LD_L_D,          0x6A,  4,  4)
+OPCODE(LD_L_E,          0x6B,  4,  4)
+OPCODE(LD_L_H,          0x6C,  4,  4)
+OPCODE(LD_L_L,          0x6D,  4,  4)
+OPCODE(LD_L_addrHL,     0x6E,  8,  8)
+OPCODE(LD_L_A,          0x6F,  4,  4)
+OPCODE(LD_addrHL_B,     0x70,  8,  8)
+OPCODE(LD_addrHL_C,     0x71,  8,  8)
+OPCODE(LD_addrHL_D,     0x72,  8,  8)
+OPCODE(LD_addrHL_E,     0x73,  8,  8)
+OPCODE(LD_addrHL_H,     0x74,  8,  8)
+OPCODE(LD_addrHL_L,     0x75,  8,  8)
+OPCODE(HALT,            0x76,  4,  4)
+OPCODE(LD_addrHL_A,     0x77,  8,  8)
+OPCODE(LD_A_B,          0x78,  4,  4)
+OPCODE(LD_A_C,          0x79,  4,  4)
+OPCODE(LD_A_D,          0x7A,  4,  4)
+OPCODE(LD_A_E,          0x7B,  4,  4)
+OPCODE(LD_A_H,          0x7C,  4,  4)
+OPCODE(LD_A_L,          0x7D,  4,  4)
+OPCODE(LD_A_addrHL,     0x7E,  8,  8)
+OPCODE(LD_A_A,          0x7F,  4,  4)
+OPCODE(ADD_A_B,         0x80,  4,  4)
+OPCODE(ADD_A_C,         0x81,  4,  4)
+OPCODE(ADD_A_D,         0x82,  4,  4)
+OPCODE(ADD_A_E,         0x83,  4,  4)
+OPCODE(ADD_A_H,         0x84,  4,  4)
+OPCODE(ADD_A_L,         0x85,  4,  4)
+OPCODE(ADD_A_addrHL,    0x86,  8,  8)
+OPCODE(ADD_A_A,         0x87,  4,  4)
+OPCODE(ADC_A_B,         0x88,  4,  4)
+OPCODE(ADC_A_C,         0x89,  4,  4)
+OPCODE(ADC_A_D,         0x8A,  4,  4)
+OPCODE(ADC_A_E,         0x8B,  4,  4)
+OPCODE(ADC_A_H,         0x8C,  4,  4)
+OPCODE(ADC_A_L,         0x8D,  4,  4)
+OPCODE(ADC_A_addrHL,    0x8E,  8,  8)
+OPCODE(ADC_A_A,         0x8F,  4,  4)
+OPCODE(SUB_B,           0x90,  4,  4)
+OPCODE(SUB_C,           0x91,  4,  4)
+OPCODE(SUB_D,           0x92,  4,  4)
+OPCODE(SUB_E,           0x93,  4,  4)
+OPCODE(SUB_H,           0x94,  4,  4)
+OPCODE(SUB_L,           0x95,  4,  4)
+OPCODE(SUB_addrHL,      0x96,  8,  8)
+OPCODE(SUB_A,           0x97,  4,  4)
+OPCODE(SBC_A_B,         0x98,  4,  4)
+OPCODE(SBC_A_C,         0x99,  4,  4)
+OPCODE(SBC_A_D,         0x9A,  4,  4)
+OPCODE(SBC_A_E,         0x9B,  4,  4)
+OPCODE(SBC_A_H,         0x9C,  4,  4)
+OPCODE(SBC_A_L,         0x9D,  4,  4)
+OPCODE(SBC_A_addrHL,    0x9E,  8,  8)
+OPCODE(SBC_A_A,         0x9F,  4,  4)
+OPCODE(AND_B,           0xA0,  4,  4)
+OPCODE(AND_C,           0xA1,  4,  4)
+OPCODE(AND_D,           0xA2,  4,  4)
+OPCODE(AND_E,           0xA3,  4,  4)
+OPCODE(AND_H,           0xA4,  4,  4)
+OPCODE(AND_L,           0xA5,  4,  4)
+OPCODE(AND_addrHL,      0xA6,  8,  8)
+OPCODE(AND_A,           0xA7,  4,  4)
+OPCODE(XOR_B,           0xA8,  4,  4)
+OPCODE(XOR_C,           0xA9,  4,  4)
+OPCODE(XOR_D,           0xAA,  4,  4)
+OPCODE(XOR_E,           0xAB,  4,  4)
+OPCODE(XOR_H,           0xAC,  4,  4)
+OPCODE(XOR_L,           0xAD,  4,  4)
+OPCODE(XOR_addrHL,      0xAE,  8,  8)
+OPCODE(XOR_A,           0xAF,  4,  4)
+OPCODE(OR_B,            0xB0,  4,  4)
+OPCODE(OR_C,            0xB1,  4,  4)
+OPCODE(OR_D,            0xB2,  4,  4)
+OPCODE(OR_E,            0xB3,  4,  4)
+OPCODE(OR_H,            0xB4,  4,  4)
+OPCODE(OR_L,            0xB5,  4,  4)
+OPCODE(OR_addrHL,       0xB6,  8,  8)
+OPCODE(OR_A,            0xB7,  4,  4)
+OPCODE(CP_B,            0xB8,  4,  4)
+OPCODE(CP_C,            0xB9,  4,  4)
+OPCODE(CP_D,            0xBA,  4,  4)
+OPCODE(CP_E,            0xBB,  4,  4)
+OPCODE(CP_H,            0xBC,  4,  4)
+OPCODE(CP_L,            0xBD,  4,  4)
+OPCODE(CP_addrHL,       0xBE,  8,  8)
+OPCODE(CP_A,            0xBF,  4,  4)
+OPCODE(RET_NZ,          0xC0,  8, 20)
+OPCODE(POP_BC,          0xC1, 12, 12)
+OPCODE(JP_NZ_a16,       0xC2, 12, 16)
+OPCODE(JP_a16,          0xC3, 16, 16)
+OPCODE(CALL_NZ_a16,     0xC4, 12, 24)
+OPCODE(PUSH_BC,         0xC5, 16, 16)
+OPCODE(ADD_A_d8,        0xC6,  8,  8)
+OPCODE(RST_00H,         0xC7, 16, 16)
+OPCODE(RET_Z,           0xC8,  8, 20)
+OPCODE(RET,             0xC9, 16, 16)
+OPCODE(JP_Z_a16,        0xCA, 12, 16)
+OPCODE(PREFIX_CB,       0xCB,  4,  4) // Special case: Handled separately
+OPCODE(CALL_Z_a16,      0xCC, 12, 24)
+OPCODE(CALL_a16,        0xCD, 24, 24)
+OPCODE(ADC_A_d8,        0xCE,  8,  8)
+OPCODE(RST_08H,         0xCF, 16, 16)
+OPCODE(RET_NC,          0xD0,  8, 20)
+OPCODE(POP_DE,          0xD1, 12, 12)
+OPCODE(JP_NC_a16,       0xD2, 12, 16)
 // 0xD3 Undefined
-OPCODE(CALL_NC_a16,     0xD4)
-OPCODE(PUSH_DE,         0xD5)
-OPCODE(SUB_d8,          0xD6)
-OPCODE(RST_10H,         0xD7)
-OPCODE(RET_C,           0xD8)
-OPCODE(RETI,            0xD9)
-OPCODE(JP_C_a16,        0xDA)
+OPCODE(CALL_NC_a16,     0xD4, 12, 24)
+OPCODE(PUSH_DE,         0xD5, 16, 16)
+OPCODE(SUB_d8,          0xD6,  8,  8)
+OPCODE(RST_10H,         0xD7, 16, 16)
+OPCODE(RET_C,           0xD8,  8, 20)
+OPCODE(RETI,            0xD9, 16, 16)
+OPCODE(JP_C_a16,        0xDA, 12, 16)
 // 0xDB Undefined
-OPCODE(CALL_C_a16,      0xDC)
+OPCODE(CALL_C_a16,      0xDC, 12, 24)
 // 0xDD Undefined
-OPCODE(SBC_A_d8,        0xDE)
-OPCODE(RST_18H,         0xDF)
-OPCODE(LDH_a8_A,        0xE0) // LD ($FF00+a8), A
-OPCODE(POP_HL,          0xE1)
-OPCODE(LD_addrC_A,      0xE2) // LD ($FF00+C), A
+OPCODE(SBC_A_d8,        0xDE,  8,  8)
+OPCODE(RST_18H,         0xDF, 16, 16)
+OPCODE(LDH_a8_A,        0xE0, 12, 12) // LD ($FF00+a8), A
+OPCODE(POP_HL,          0xE1, 12, 12)
+OPCODE(LD_addrC_A,      0xE2,  8,  8) // LD ($FF00+C), A
 // 0xE3 Undefined
 // 0xE4 Undefined
-OPCODE(PUSH_HL,         0xE5)
-OPCODE(AND_d8,          0xE6)
-OPCODE(RST_20H,         0xE7)
-OPCODE(ADD_SP_r8,       0xE8)
-OPCODE(JP_HL,           0xE9) // JP (HL)
-OPCODE(LD_a16_A,        0xEA)
+OPCODE(PUSH_HL,         0xE5, 16, 16)
+OPCODE(AND_d8,          0xE6,  8,  8)
+OPCODE(RST_20H,         0xE7, 16, 16)
+OPCODE(ADD_SP_r8,       0xE8, 16, 16)
+OPCODE(JP_HL,           0xE9,  4,  4) // JP (HL)
+OPCODE(LD_a16_A,        0xEA, 16, 16)
 // 0xEB Undefined
 // 0xEC Undefined
 // 0xED Undefined
-OPCODE(XOR_d8,          0xEE)
-OPCODE(RST_28H,         0xEF)
-OPCODE(LDH_A_a8,        0xF0) // LD A, ($FF00+a8)
-OPCODE(POP_AF,          0xF1)
-OPCODE(LD_A_addrC,      0xF2) // LD A, ($FF00+C)
-OPCODE(DI,              0xF3)
+OPCODE(XOR_d8,          0xEE,  8,  8)
+OPCODE(RST_28H,         0xEF, 16, 16)
+OPCODE(LDH_A_a8,        0xF0, 12, 12) // LD A, ($FF00+a8)
+OPCODE(POP_AF,          0xF1, 12, 12)
+OPCODE(LD_A_addrC,      0xF2,  8,  8) // LD A, ($FF00+C)
+OPCODE(DI,              0xF3,  4,  4)
 // 0xF4 Undefined
-OPCODE(PUSH_AF,         0xF5)
-OPCODE(OR_d8,           0xF6)
-OPCODE(RST_30H,         0xF7)
-OPCODE(LD_HL_SPplusr8,  0xF8) // LD HL, SP+r8
-OPCODE(LD_SP_HL,        0xF9)
-OPCODE(LD_A_a16,        0xFA)
-OPCODE(EI,              0xFB)
+OPCODE(PUSH_AF,         0xF5, 16, 16)
+OPCODE(OR_d8,           0xF6,  8,  8)
+OPCODE(RST_30H,         0xF7, 16, 16)
+OPCODE(LD_HL_SPplusr8,  0xF8, 12, 12) // LD HL, SP+r8
+OPCODE(LD_SP_HL,        0xF9,  8,  8)
+OPCODE(LD_A_a16,        0xFA, 16, 16)
+OPCODE(EI,              0xFB,  4,  4)
 // 0xFC Undefined
 // 0xFD Undefined
-OPCODE(CP_d8,           0xFE)
-OPCODE(RST_38H,         0xFF)
\ No newline at end of file
+OPCODE(CP_d8,           0xFE,  8,  8)
+OPCODE(RST_38H,         0xFF, 16, 16)
\ No newline at end of file
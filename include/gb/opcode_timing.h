@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gb {
+
+// T-cycles an instruction takes, and what a conditional JR/JP/CALL/RET
+// takes instead when its branch is taken
+struct OpcodeTiming {
+  uint8_t cycles;
+  uint8_t taken;
+};
+
+// CB-prefixed opcode n is entry kCbTimingBase + n; its cost includes the
+// prefix fetch
+static constexpr size_t kCbTimingBase = 0x100;
+
+// Timing of all 512 opcodes: the primary set from opcode_list.h, the CB
+// set from its encoding (8 for registers, 16 for (HL), 12 for BIT n,(HL))
+inline constexpr std::array<OpcodeTiming, 512> kOpcodeTiming = [] {
+  std::array<OpcodeTiming, 512> t{};
+  // Undefined opcodes lock up real hardware; charge one fetch
+  for (OpcodeTiming& timing : t) timing = {4, 4};
+#define OPCODE(name, code, cycles, taken) t[code] = {cycles, taken};
+#include "gb/opcode_list.h"
+#undef OPCODE
+  for (size_t op = 0; op < 256; ++op) {
+    uint8_t cycles = (op & 7) != 6 ? 8 : (op >> 6) == 1 ? 12 : 16;
+    t[kCbTimingBase + op] = {cycles, cycles};
+  }
+  return t;
+}();
+
+} // namespace gb
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gb/state.h"
+
+namespace gb {
+
+// MBC3 clock register indices (RAM bank select values 0x08-0x0C)
+enum RtcRegister : uint8_t {
+  kRtcSeconds = 0,
+  kRtcMinutes,
+  kRtcHours,
+  kRtcDaysLow,
+  kRtcDaysHigh,
+  kRtcRegisterCount
+};
+
+// Size of the clock trailer appended to .sav files (VBA-M/BGB layout)
+static constexpr size_t kRtcSaveSize = 48;
+
+// MBC3 real-time clock.
+//
+// The counter is never ticked. It stores the register values at a base
+// point on the emulated clock and derives the current time from the cycles
+// elapsed since then, so reads are exact at any emulation speed and idle
+// time costs nothing.
+class Rtc {
+ public:
+  // CPU clock rate the MBC3 oscillator is measured against (T-cycles)
+  static constexpr uint64_t kCyclesPerSecond = 4194304;
+
+  // Clear all registers and start counting from the given cycle
+  void Reset(uint64_t now);
+
+  // Copy the live counter into the latched registers
+  void Latch(uint64_t now);
+
+  // Latched register value, as seen through 0xA000-0xBFFF
+  uint8_t ReadLatched(uint8_t reg) const { return latched_[reg]; }
+
+  // Write a live counter register (S, M, H, DL, DH)
+  void Write(uint8_t reg, uint8_t value, uint64_t now);
+
+  // Append the 48-byte .sav trailer: live and latched registers as 32-bit
+  // little-endian words followed by a 64-bit UNIX timestamp
+  void Serialize(std::vector<uint8_t>& out, uint64_t now,
+                 int64_t unix_time) const;
+
+  // Restore from a 44- or 48-byte trailer, advancing the clock by the
+  // wall-clock time elapsed since it was written. Returns false if the
+  // trailer has an unexpected size.
+  bool Deserialize(const uint8_t* data, size_t size, uint64_t now,
+                   int64_t unix_time);
+
+  // Save-state snapshot (exact, unlike the .sav trailer)
+  void SaveState(StateWriter& w) const;
+  void LoadState(StateReader& r);
+
+ private:
+  using Registers = std::array<uint8_t, kRtcRegisterCount>;
+
+  // Add whole seconds to a register set, carrying into the day counter
+  static Registers Advance(Registers regs, uint64_t seconds);
+
+  // Register values at a given point on the emulated clock
+  Registers RegistersAt(uint64_t now) const;
+
+  // Fold the elapsed whole seconds into the base registers
+  void Rebase(uint64_t now);
+
+  bool halted() const { return (base_[kRtcDaysHigh] & 0x40) != 0; }
+
+  // Register values at base_cycles_
+  Registers base_{};
+  Registers latched_{};
+  // Emulated cycle the base registers correspond to
+  uint64_t base_cycles_ = 0;
+  // Sub-second progress preserved across a halt
+  uint64_t halt_subsecond_ = 0;
+};
+
+} // namespace gb
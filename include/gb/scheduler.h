@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace gb {
+
+// Hardware events that complete at a known future cycle. Each kind has a
+// single slot; rescheduling replaces the pending one.
+enum class Event : uint8_t {
+  kOamDma, // OAM DMA transfer finished
+  kSerial, // Internal-clock serial transfer finished
+  kJoypad, // Next queued host input event is due
+  kCount
+};
+
+// Tracks pending events on the emulated T-cycle timeline. The earliest
+// deadline is cached so the per-instruction check in MMU::Tick() is a
+// single compare.
+class Scheduler {
+ public:
+  static constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+  Scheduler() { Clear(); }
+
+  // Schedule (or reschedule) an event at an absolute cycle
+  void Schedule(Event event, uint64_t when) {
+    uint64_t& slot = when_[Index(event)];
+    bool was_next = (slot == next_);
+    slot = when;
+    if (when < next_) {
+      next_ = when;
+    } else if (was_next) {
+      Recompute();
+    }
+  }
+
+  void Cancel(Event event) {
+    uint64_t& slot = when_[Index(event)];
+    if (slot == kNever) return;
+    bool was_next = (slot == next_);
+    slot = kNever;
+    if (was_next) Recompute();
+  }
+
+  void Clear() {
+    when_.fill(kNever);
+    next_ = kNever;
+  }
+
+  bool IsScheduled(Event event) const {
+    return when_[Index(event)] != kNever;
+  }
+  uint64_t When(Event event) const { return when_[Index(event)]; }
+
+  // Earliest pending deadline, or kNever
+  uint64_t next() const { return next_; }
+
+  // Remove and return the earliest event due at or before `now`.
+  // Returns false when nothing is due.
+  bool PopDue(uint64_t now, Event* event, uint64_t* when) {
+    if (next_ > now) return false;
+    for (size_t i = 0; i < when_.size(); ++i) {
+      if (when_[i] == next_) {
+        *event = static_cast<Event>(i);
+        *when = when_[i];
+        when_[i] = kNever;
+        Recompute();
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static constexpr size_t Index(Event event) {
+    return static_cast<size_t>(event);
+  }
+
+  void Recompute() {
+    next_ = kNever;
+    for (uint64_t when : when_) {
+      if (when < next_) next_ = when;
+    }
+  }
+
+  std::array<uint64_t, static_cast<size_t>(Event::kCount)> when_;
+  uint64_t next_ = kNever;
+};
+
+} // namespace gb
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "gb/state.h"
+
+namespace gb {
+
+// Serial port: SB (0xFF01) data and SC (0xFF02) control.
+//
+// Only internal-clock transfers make progress; there is no link partner,
+// so every received bit is 1. Outgoing bytes are handed to a sink when the
+// transfer completes: by default they are appended to an in-memory buffer,
+// or a callback can take them instead (e.g. to stop a headless run as soon
+// as a test ROM prints its verdict).
+class Serial {
+ public:
+  using Sink = std::function<void(uint8_t)>;
+
+  // DMG internal clock: 8192 Hz, eight bits per transfer (T-cycles)
+  static constexpr uint32_t kCyclesPerBit = 512;
+  static constexpr uint32_t kCyclesPerByte = 8 * kCyclesPerBit;
+
+  uint8_t data() const { return sb_; }
+  // Unused SC bits read as 1
+  uint8_t control() const { return static_cast<uint8_t>(sc_ | 0x7E); }
+
+  void WriteData(uint8_t value) { sb_ = value; }
+  // Returns true if the write starts an internal-clock transfer, which the
+  // caller schedules to complete kCyclesPerByte later
+  bool WriteControl(uint8_t value);
+
+  // Finish the transfer in flight: shift in 0xFF, clear the start bit and
+  // deliver the outgoing byte to the sink
+  void Complete();
+
+  // Route outgoing bytes to `sink`; an empty sink restores buffering
+  void set_sink(Sink sink) { sink_ = std::move(sink); }
+
+  // Bytes buffered while no callback sink is installed
+  const std::string& output() const { return output_; }
+
+  bool transferring() const { return (sc_ & 0x81) == 0x81; }
+
+  void Reset();
+
+  // Save-state snapshot of the registers (the sink is host configuration)
+  void SaveState(StateWriter& w) const;
+  void LoadState(StateReader& r);
+
+ private:
+  uint8_t sb_ = 0;
+  uint8_t sc_ = 0;
+  uint8_t outgoing_ = 0; // Byte latched when the transfer started
+  Sink sink_;
+  std::string output_;
+};
+
+} // namespace gb
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace gb {
+
+// Save states are a flat sequence of fixed-size fields in host byte order.
+// Every component writes and reads its fields in the same order; the
+// reader only has to check that it never runs past the end.
+
+class StateWriter {
+ public:
+  explicit StateWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  template <typename T>
+  void Write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    WriteBytes(&value, sizeof(T));
+  }
+
+  void WriteBytes(const void* data, size_t size) {
+    size_t pos = out_.size();
+    out_.resize(pos + size);
+    std::memcpy(out_.data() + pos, data, size);
+  }
+
+ private:
+  std::vector<uint8_t>& out_;
+};
+
+// Reads fail sticky: once the input runs out every further read leaves
+// its destination untouched and ok() stays false.
+class StateReader {
+ public:
+  StateReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  void Read(T* value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    ReadBytes(value, sizeof(T));
+  }
+
+  void ReadBytes(void* data, size_t size) {
+    if (!ok_ || size > size_ - pos_) {
+      ok_ = false;
+      return;
+    }
+    std::memcpy(data, data_ + pos_, size);
+    pos_ += size;
+  }
+
+  bool ok() const { return ok_; }
+  // True once every byte has been consumed without error
+  bool done() const { return ok_ && pos_ == size_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+// Parts of the machine that are hashed separately, so a divergence
+// between two runs can be pinned down to a region
+enum class StateRegion : uint8_t {
+  kCpu,  // Registers, IME, HALT and the CPU clock
+  kVram,
+  kWram,
+  kOam,
+  kIo,
+  kHram,
+  kSram,
+  kMmu,   // IE, clock, scheduled events, DMA, serial, joypad, mapper
+  kFrame, // Framebuffer and frame counters
+  kCount,
+};
+
+static constexpr size_t kStateRegionCount =
+    static_cast<size_t>(StateRegion::kCount);
+
+inline const char* StateRegionName(StateRegion region) {
+  static constexpr const char* kNames[kStateRegionCount] = {
+      "cpu", "vram", "wram", "oam", "io", "hram", "sram", "mmu", "frame"};
+  return kNames[static_cast<size_t>(region)];
+}
+
+// One Hash64() per StateRegion
+using StateHashes = std::array<uint64_t, kStateRegionCount>;
+
+} // namespace gb
@@ -0,0 +1,19 @@
+// Opcode pairs Step() executes as one fused handler. Format:
+//   SUPERINSTRUCTION(first opcode, second opcode)
+// At most one pair per first opcode. The first instruction must not write
+// memory, branch, or touch IME/HALT, so nothing it does can raise or
+// service an interrupt between the two. The set covers loop counters,
+// copy loops and register polling; gameboy-emu-pairs reports how often a
+// ROM set runs each pair and what the list leaves on the table.
+SUPERINSTRUCTION(0x05, 0x20) // DEC B; JR NZ,r8
+SUPERINSTRUCTION(0x0D, 0x20) // DEC C; JR NZ,r8
+SUPERINSTRUCTION(0x3D, 0x20) // DEC A; JR NZ,r8
+SUPERINSTRUCTION(0xB1, 0x20) // OR C; JR NZ,r8
+SUPERINSTRUCTION(0xE6, 0x20) // AND d8; JR NZ,r8
+SUPERINSTRUCTION(0xFE, 0x20) // CP d8; JR NZ,r8
+SUPERINSTRUCTION(0x0B, 0x78) // DEC BC; LD A,B
+SUPERINSTRUCTION(0x78, 0xB1) // LD A,B; OR C
+SUPERINSTRUCTION(0x2A, 0x12) // LD A,(HL+); LD (DE),A
+SUPERINSTRUCTION(0x1A, 0x22) // LD A,(DE); LD (HL+),A
+SUPERINSTRUCTION(0x7E, 0x12) // LD A,(HL); LD (DE),A
+SUPERINSTRUCTION(0xF0, 0xFE) // LDH A,(a8); CP d8
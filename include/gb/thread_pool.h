@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gb {
+
+// Fixed-size work-stealing thread pool.
+//
+// Each worker owns a deque: it pops its own tasks from the back (most
+// recently submitted, still warm in cache) and, when empty, steals from
+// the front of the other workers' deques. Suited to batches of tasks with
+// very uneven run times, such as a directory of test ROMs.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  // `threads == 0` uses one worker per hardware thread
+  explicit ThreadPool(size_t threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Queue a task. Tasks are spread round-robin over the workers.
+  void Submit(Task task);
+
+  // Block until every submitted task has finished
+  void Wait();
+
+  size_t size() const { return threads_.size(); }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // Worker main loop
+  void Run(size_t index);
+  // Take a task from our own queue, or steal one from another worker
+  bool TryPop(size_t index, Task* task);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  size_t queued_ = 0;  // Tasks submitted but not yet picked up
+  size_t pending_ = 0; // Tasks submitted but not yet finished
+  size_t next_queue_ = 0;
+  bool stop_ = false;
+};
+
+} // namespace gb
@@ -0,0 +1,92 @@
+#include "gb/aot.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define GB_AOT_DLOPEN 1
+#endif
+
+#include <cstdio>
+
+namespace gb {
+
+std::unique_ptr<AotPlugin> AotPlugin::Load(const std::string& path,
+                                           std::string* error) {
+#ifdef GB_AOT_DLOPEN
+  void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    *error = dlerror();
+    return nullptr;
+  }
+  std::unique_ptr<AotPlugin> plugin(new AotPlugin());
+  plugin->handle_ = handle;
+  auto module_fn =
+      reinterpret_cast<GbAotModuleFn>(dlsym(handle, "gb_aot_module"));
+  const GbAotModule* module = module_fn ? module_fn() : nullptr;
+  if (!module) {
+    *error = path + ": not a gameboy-emu AOT plugin";
+    return nullptr;
+  }
+  if (module->abi_version != kAotAbiVersion) {
+    *error = path + ": built for AOT ABI version " +
+             std::to_string(module->abi_version) + ", expected " +
+             std::to_string(kAotAbiVersion);
+    return nullptr;
+  }
+  if (!plugin->Index(*module)) {
+    *error = path + ": entry outside the ROM windows";
+    return nullptr;
+  }
+  return plugin;
+#else
+  *error = path + ": plugins are not supported on this platform";
+  return nullptr;
+#endif
+}
+
+std::unique_ptr<AotPlugin> AotPlugin::FromModule(const GbAotModule& module) {
+  std::unique_ptr<AotPlugin> plugin(new AotPlugin());
+  if (module.abi_version != kAotAbiVersion || !plugin->Index(module)) {
+    return nullptr;
+  }
+  return plugin;
+}
+
+AotPlugin::~AotPlugin() {
+#ifdef GB_AOT_DLOPEN
+  if (handle_) dlclose(handle_);
+#endif
+}
+
+std::string AotPlugin::FileName(uint64_t rom_hash) {
+  char name[64];
+#if defined(__APPLE__)
+  const char* suffix = "dylib";
+#else
+  const char* suffix = "so";
+#endif
+  std::snprintf(name, sizeof(name), "gb-aot-%016llx.%s",
+                static_cast<unsigned long long>(rom_hash), suffix);
+  return name;
+}
+
+bool AotPlugin::Index(const GbAotModule& module) {
+  banks_.resize(1);
+  banks_[0] = std::make_unique<GbAotBlock[]>(kBankSize);
+  for (uint32_t i = 0; i < module.count; ++i) {
+    const GbAotEntry& entry = module.entries[i];
+    // Bank 0 code sits below 0x4000, every other bank's above
+    bool low = entry.address < kBankSize;
+    if ((entry.bank == 0) != low || entry.address >= 2 * kBankSize) {
+      return false;
+    }
+    if (entry.bank >= banks_.size()) banks_.resize(entry.bank + 1);
+    std::unique_ptr<GbAotBlock[]>& bank = banks_[entry.bank];
+    if (!bank) bank = std::make_unique<GbAotBlock[]>(kBankSize);
+    bank[entry.address % kBankSize] = entry.block;
+  }
+  rom_hash_ = module.rom_hash;
+  count_ = module.count;
+  return true;
+}
+
+} // namespace gb
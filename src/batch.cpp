@@ -0,0 +1,92 @@
+#include "gb/batch.h"
+
+#include <cstring> // for std::memcpy
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace gb {
+
+namespace {
+
+// Best effort: a failed pin only costs locality
+void PinToCpu(std::thread& thread, size_t cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % CPU_SETSIZE, &set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+  (void)thread;
+  (void)cpu;
+#endif
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(size_t threads, bool pin) {
+  size_t cpus = std::thread::hardware_concurrency();
+  if (threads == 0) threads = cpus;
+  if (threads == 0) threads = 1;
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this, i] { Run(i); });
+    if (pin && cpus > 0) PinToCpu(threads_.back(), i % cpus);
+  }
+}
+
+BatchRunner::~BatchRunner() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& thread : threads_) thread.join();
+}
+
+void BatchRunner::RunFrame(Emulator* const* emulators, size_t count,
+                           uint8_t* frames) {
+  if (count == 0) return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  emulators_ = emulators;
+  count_ = count;
+  frames_ = frames;
+  running_ = threads_.size();
+  ++generation_;
+  work_cv_.notify_all();
+  done_cv_.wait(lock, [this] { return running_ == 0; });
+}
+
+void BatchRunner::RunShard(size_t index) {
+  // Contiguous shard [begin, end): stable for a given batch size
+  size_t workers = threads_.size();
+  size_t begin = count_ * index / workers;
+  size_t end = count_ * (index + 1) / workers;
+  for (size_t i = begin; i < end; ++i) {
+    Emulator& emu = *emulators_[i];
+    emu.RunFrame();
+    if (frames_) {
+      std::memcpy(frames_ + i * kFrameBytes, emu.framebuffer(), kFrameBytes);
+    }
+  }
+}
+
+void BatchRunner::Run(size_t index) {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+    }
+    RunShard(index);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--running_ == 0) done_cv_.notify_one();
+    }
+  }
+}
+
+} // namespace gb
@@ -1,74 +1,581 @@
 #include "gb/cpu.h"
+#include "gb/aot.h"
+#include "gb/fastmem.h"
+#include "gb/flat_bus.h"
+#include "gb/mapper_bus.h"
 #include "gb/mmu.h"
+#include "gb/opcode_flags.h"
+#include "gb/opcode_timing.h"
 
 #include <iostream>
+#include <algorithm>
 #include <array>
 #include <cstdint> // Include cstdint for fixed-width integers
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <utility>
 
 namespace gb {
 
+namespace {
+
+// Longest loop body, in bytes, considered for idle-loop skipping. Real
+// polling loops are a handful of instructions.
+constexpr uint16_t kMaxIdleLoopBytes = 16;
+
+// Opcodes with a flag-free variant: register-only results whose flags
+// are the only other effect (INC/DEC (HL) write memory, DAA's result
+// depends on flags it would have to keep)
+constexpr bool HasFlagFreeVariant(uint8_t opcode) {
+  if (opcode >= 0x80 && opcode < 0xC0) return true; // ALU A,r
+  if ((opcode & 0xC7) == 0xC6) return true;         // ALU A,d8
+  if (opcode >= 0x40) return false;
+  if ((opcode & 0x06) == 0x04) return (opcode & 0x38) != 0x30; // INC/DEC r
+  if ((opcode & 0x0F) == 0x09) return true;                    // ADD HL,rr
+  return (opcode & 0x07) == 0x07 && opcode != 0x27; // Rotates, CPL, SCF, CCF
+}
+
+// Operation encoded by a CB-prefixed opcode
+constexpr CbOp CbOpFor(size_t opcode) {
+  switch (opcode >> 6) {
+    case 0:
+      return static_cast<CbOp>((opcode >> 3) & 7);
+    case 1:
+      return CbOp::kBit;
+    case 2:
+      return CbOp::kRes;
+    default:
+      return CbOp::kSet;
+  }
+}
+
+} // namespace
+
 // === Core Execution Logic ===
 
-void CPU::Reset() {
+template <MemoryBus Bus>
+BasicCpu<Bus>::BasicCpu(Bus& bus) : bus_(bus) {}
+
+void CpuState::Reset() {
   pc_ = 0x0100;
   sp_ = 0xFFFE;
   ime_ = false;
 
   // Reset registers
   a_ = f_ = b_ = c_ = d_ = e_ = h_ = l_ = 0;
+  halted_ = false;
+  ei_delay_ = false;
+  breakpoint_ = false;
+  ForgetIdleLoop();
 }
 
-uint8_t CPU::FetchOpcode() {
-  uint8_t opcode = MMU::Instance().Read(pc_);
+template <MemoryBus Bus>
+uint8_t BasicCpu<Bus>::FetchOpcode() {
+  uint8_t opcode = bus_.Read(pc_);
   pc_++;
-  cycles_ += 4;  // Account for opcode fetch (4 t-states)
   return opcode;
 }
 
-uint8_t CPU::Fetch8() {
+template <MemoryBus Bus>
+uint8_t BasicCpu<Bus>::Fetch8() {
   return FetchOpcode();
 }
 
-uint16_t CPU::Fetch16() {
+template <MemoryBus Bus>
+uint16_t BasicCpu<Bus>::Fetch16() {
   uint16_t low = FetchOpcode();
   uint16_t high = FetchOpcode();
   return (static_cast<uint16_t>(high) << 8) | low;
 }
 
-void CPU::Execute(uint8_t opcode) {
-  static const std::array<void (CPU::*)(), 256> kDispatch = [] {
-    std::array<void (CPU::*)(), 256> t;
-    t.fill(&CPU::OpIllegal);  // default undefined opcodes
-#define OPCODE(name, code) t[code] = &CPU::Op##name;
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Write8(uint16_t address, uint8_t value) {
+  // A loop that writes is not idle
+  idle_clean_ = false;
+  bus_.Write(address, value);
+}
+
+template <MemoryBus Bus>
+constexpr typename BasicCpu<Bus>::Handler BasicCpu<Bus>::HandlerFor(
+    uint8_t opcode) {
+  switch (opcode) {
+#define OPCODE(name, code, cycles, taken) \
+  case code:                              \
+    return &BasicCpu::Op##name;
 #include "gb/opcode_list.h"
 #undef OPCODE
+    default:
+      return &BasicCpu::OpIllegal;  // undefined opcodes
+  }
+}
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Execute(uint8_t opcode) {
+  static constexpr std::array<Handler, 256> kDispatch = [] {
+    std::array<Handler, 256> t{};
+    for (size_t i = 0; i < t.size(); ++i) {
+      t[i] = HandlerFor(static_cast<uint8_t>(i));
+    }
     return t;
   }();
   (this->*kDispatch[opcode])();
 }
 
-void CPU::Step() {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::ExecuteTimed(uint8_t opcode) {
+  timing_index_ = opcode;
+  branch_taken_ = false;
+  Execute(opcode);
+  // The only place instructions are charged for their cycles
+  const OpcodeTiming& timing = kOpcodeTiming[timing_index_];
+  cycles_ += branch_taken_ ? timing.taken : timing.cycles;
+}
+
+template <MemoryBus Bus>
+template <uint8_t kFirst, uint8_t kSecond>
+void BasicCpu<Bus>::OpPair() {
+  constexpr OpcodeTiming kFirstTiming = kOpcodeTiming[kFirst];
+  constexpr OpcodeTiming kSecondTiming = kOpcodeTiming[kSecond];
+  (this->*HandlerFor(kFirst))();
+  cycles_ += kFirstTiming.cycles;
+  if (bus_.Read(pc_) != kSecond) return;
+  if constexpr (EventBus<Bus>) {
+    // The bus has not seen the first instruction's cycles (or an
+    // interrupt dispatch before it) yet; an event inside them must be
+    // handled before the second one runs
+    if (bus_.CyclesUntilEvent() <= cycles_ - bus_cycles_) return;
+  }
+  SyncBus();
+  ++pc_;
+  branch_taken_ = false;
+  (this->*HandlerFor(kSecond))();
+  cycles_ += branch_taken_ ? kSecondTiming.taken : kSecondTiming.cycles;
+  ++fused_pairs_;
+}
+
+template <MemoryBus Bus>
+template <uint8_t kOpcode>
+constexpr typename BasicCpu<Bus>::Handler BasicCpu<Bus>::FlagFreeHandlerFor() {
+  if constexpr (HasFlagFreeVariant(kOpcode)) {
+    return &BasicCpu::OpFlagFree<kOpcode>;
+  } else {
+    return nullptr;
+  }
+}
+
+template <MemoryBus Bus>
+template <uint8_t kOpcode>
+void BasicCpu<Bus>::OpFlagFree() {
+  constexpr int kRegister = (kOpcode >> 3) & 7;
+  if constexpr (kOpcode < 0x40 && (kOpcode & 0x07) == 0x04) {
+    WriteOperand<kRegister>(ReadOperand<kRegister>() + 1);
+  } else if constexpr (kOpcode < 0x40 && (kOpcode & 0x07) == 0x05) {
+    WriteOperand<kRegister>(ReadOperand<kRegister>() - 1);
+  } else if constexpr (kOpcode < 0x40 && (kOpcode & 0x0F) == 0x09) {
+    uint16_t value = kOpcode == 0x09   ? (b_ << 8 | c_)
+                     : kOpcode == 0x19 ? (d_ << 8 | e_)
+                     : kOpcode == 0x29 ? hl()
+                                       : sp_;
+    set_hl(static_cast<uint16_t>(hl() + value));
+  } else if constexpr (kOpcode == 0x07) { // RLCA
+    a_ = static_cast<uint8_t>(a_ << 1 | a_ >> 7);
+  } else if constexpr (kOpcode == 0x0F) { // RRCA
+    a_ = static_cast<uint8_t>(a_ >> 1 | a_ << 7);
+  } else if constexpr (kOpcode == 0x17) { // RLA
+    a_ = static_cast<uint8_t>(a_ << 1 | (GetFlag(kCarryFlagMask) ? 1 : 0));
+  } else if constexpr (kOpcode == 0x1F) { // RRA
+    a_ = static_cast<uint8_t>(a_ >> 1 | (GetFlag(kCarryFlagMask) ? 0x80 : 0));
+  } else if constexpr (kOpcode == 0x2F) { // CPL
+    a_ = static_cast<uint8_t>(~a_);
+  } else if constexpr (kOpcode == 0x37 || kOpcode == 0x3F) {
+    // SCF, CCF: nothing but flags
+  } else {
+    // ADD, ADC, SUB, SBC, AND, XOR, OR, CP on a register, (HL) or d8
+    uint8_t value;
+    if constexpr (kOpcode >= 0xC0) {
+      value = Fetch8();
+    } else {
+      value = ReadOperand<kOpcode & 7>();
+    }
+    uint8_t carry = GetFlag(kCarryFlagMask) ? 1 : 0;
+    switch (kRegister) {
+      case 0: a_ = static_cast<uint8_t>(a_ + value); break;
+      case 1: a_ = static_cast<uint8_t>(a_ + value + carry); break;
+      case 2: a_ = static_cast<uint8_t>(a_ - value); break;
+      case 3: a_ = static_cast<uint8_t>(a_ - value - carry); break;
+      case 4: a_ &= value; break;
+      case 5: a_ ^= value; break;
+      case 6: a_ |= value; break;
+      default: break; // CP
+    }
+  }
+}
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::ExecuteSkippingDeadFlags(uint8_t opcode) {
+  static constexpr std::array<Handler, 256> kFlagFree =
+      []<size_t... kOpcodes>(std::index_sequence<kOpcodes...>) {
+        return std::array<Handler, 256>{
+            FlagFreeHandlerFor<static_cast<uint8_t>(kOpcodes)>()...};
+      }(std::make_index_sequence<256>{});
+  // A run of these instructions is a straight-line block with nothing
+  // for an interrupt check to find inside it: they neither write memory
+  // nor touch IME, so only a bus event could raise one. Run the block
+  // through its first other instruction, each one with or without flags
+  // depending on whether its successor reads them. The peeked successor
+  // doubles as its fetch, so the lookahead costs no extra bus read.
+  while (Handler flag_free = kFlagFree[opcode]) {
+    uint32_t cycles = kOpcodeTiming[opcode].cycles;
+    if constexpr (EventBus<Bus>) {
+      // An event inside this instruction must be handled before the next
+      if (bus_.CyclesUntilEvent() <= cycles_ - bus_cycles_ + cycles) break;
+    }
+    // pc_ is past the opcode; the d8 forms have one operand byte
+    uint8_t next = bus_.Read(pc_ + ((opcode & 0xC7) == 0xC6 ? 1 : 0));
+    if (FlagsDeadAfter(opcode, next)) {
+      (this->*flag_free)();
+      ++dead_flag_instructions_;
+    } else {
+      Execute(opcode);
+    }
+    cycles_ += cycles;
+    // Nothing has written memory since the peek
+    opcode = next;
+    ++pc_;
+  }
+  // The instruction ending the block may write
+  SyncBus();
+  ExecuteTimed(opcode);
+}
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Step() {
+  bus_cycles_ = cycles_;
   // Handle delayed EI (enable after next instruction)
   if (ei_delay_) {
     ime_ = true;
     ei_delay_ = false;
   }
-  // Service interrupts first
+  // Service interrupts first, then bring the bus up to the instruction
+  // after a dispatch
   ServiceInterrupts();
+  SyncBus();
 
-  // If halted, consume a machine cycle and return
+  uint16_t pc = pc_;
   if (halted_) {
-    cycles_ += 4;
-    return;
+    // If halted, consume a machine cycle, or on an EventBus every machine
+    // cycle up to the one that reaches the next event: nothing can wake
+    // the CPU before then
+    uint64_t wait = 4;
+    if constexpr (EventBus<Bus>) {
+      if (idle_skip_) {
+        uint64_t until_event = std::min<uint64_t>(
+            bus_.CyclesUntilEvent(), std::numeric_limits<uint32_t>::max() - 3);
+        wait = std::max<uint64_t>(4, (until_event + 3) & ~uint64_t{3});
+        skipped_cycles_ += wait - 4;
+      }
+    }
+    cycles_ += wait;
+  } else if (aot_ && RunAotBlock()) {
+    // Compiled code ran from PC
+  } else if (superinstructions_ || skip_dead_flags_) {
+    // Normal instruction fetch & execute, fusing the listed pairs and
+    // skipping flags nothing reads
+    static constexpr std::array<Handler, 256> kPairs = [] {
+      std::array<Handler, 256> t{};
+#define SUPERINSTRUCTION(first, second) \
+  t[first] = &BasicCpu::OpPair<first, second>;
+#include "gb/superinstruction_list.h"
+#undef SUPERINSTRUCTION
+      return t;
+    }();
+    uint8_t opcode = FetchOpcode();
+    Handler pair = superinstructions_ ? kPairs[opcode] : nullptr;
+    if (pair) {
+      (this->*pair)();
+    } else if (skip_dead_flags_) {
+      ExecuteSkippingDeadFlags(opcode);
+    } else {
+      ExecuteTimed(opcode);
+    }
+  } else {
+    StepInstruction();
+  }
+  // Let the rest of the system catch up with the time just spent
+  SyncBus();
+  // A short jump backwards may have closed a copy/fill loop or an idle loop
+  if (!halted_ && pc_ <= pc && pc - pc_ < kMaxIdleLoopBytes) {
+    if constexpr (BulkBus<Bus>) {
+      if (bulk_loops_ && RunBulkLoop()) return;
+    }
+    if constexpr (EventBus<Bus>) {
+      if (idle_skip_) CheckIdleLoop();
+    }
   }
-  // Normal instruction fetch & execute
-  uint8_t opcode = FetchOpcode();
-  Execute(opcode);
+}
+
+template <MemoryBus Bus>
+struct BasicCpu<Bus>::AotContext {
+  BasicCpu* cpu;
+  const GbAotMachine* machine;
+};
+
+template <MemoryBus Bus>
+bool BasicCpu<Bus>::RunAotBlock() {
+  if constexpr (BankedBus<Bus>) {
+    // Blocks have their operands baked in from the ROM, bank 0 at 0x0000.
+    // OAM DMA hides the ROM from the CPU, and MBC1 can map another bank
+    // there.
+    const BankState& banks = bus_.banks();
+    if (bus_.dma_active() || (pc_ < kBankSize && banks.rom0_offset != 0)) {
+      return false;
+    }
+    GbAotBlock block = aot_->Find(pc_, banks.romx_offset / kBankSize);
+    if (!block) return false;
+    // Nothing a block runs writes memory before its last instruction, so
+    // as with superinstructions only a bus event could raise an
+    // interrupt inside it. The bus is behind by any interrupt dispatch
+    // this Step.
+    uint64_t until_event = bus_.CyclesUntilEvent();
+    uint64_t behind = cycles_ - bus_cycles_;
+    auto budget = static_cast<uint32_t>(std::min<uint64_t>(
+        until_event > behind ? until_event - behind : 0,
+        std::numeric_limits<uint32_t>::max()));
+    GbAotMachine m{a_, f_, b_, c_, d_, e_, h_, l_, sp_, pc_,
+                   budget, 0, 0, nullptr, &AotRead, &AotWrite};
+    AotContext context{this, &m};
+    m.context = &context;
+    block(&m);
+    if (m.cycles == 0) return false;
+    a_ = m.a;
+    f_ = m.f;
+    b_ = m.b;
+    c_ = m.c;
+    d_ = m.d;
+    e_ = m.e;
+    h_ = m.h;
+    l_ = m.l;
+    sp_ = m.sp;
+    pc_ = m.pc;
+    cycles_ += m.cycles;
+    aot_instructions_ += m.instructions;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+template <MemoryBus Bus>
+uint8_t BasicCpu<Bus>::AotRead(void* context, uint16_t address) {
+  return static_cast<AotContext*>(context)->cpu->bus_.Read(address);
+}
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::AotWrite(void* context, uint16_t address, uint8_t value) {
+  auto* c = static_cast<AotContext*>(context);
+  BasicCpu* cpu = c->cpu;
+  // Run the bus up to the writing instruction first, as SyncBus() does
+  // for interpreted blocks; the block's cycles join cycles_ only when it
+  // returns
+  uint64_t now = cpu->cycles_ + c->machine->cycles;
+  if (now > cpu->bus_cycles_) {
+    cpu->bus_.Tick(static_cast<uint32_t>(now - cpu->bus_cycles_));
+    cpu->bus_cycles_ = now;
+  }
+  cpu->Write8(address, value);
+}
+
+template <MemoryBus Bus>
+bool BasicCpu<Bus>::RunBulkLoop() {
+  if constexpr (BulkBus<Bus>) {
+    // Recognised loops, from the head through the closing JR NZ:
+    //   fill: LD (HL+),A or LD (HL-),A; DEC B or DEC C; JR NZ
+    //   copy: LD A,(HL+); LD (DE),A; INC DE; DEC B or DEC C; JR NZ
+    //   copy: LD A,(HL+); LD (DE),A; INC DE; DEC BC; LD A,B; OR C; JR NZ
+    auto at = [this](uint16_t offset) {
+      return bus_.Read(static_cast<uint16_t>(pc_ + offset));
+    };
+    auto cycles = [](std::initializer_list<uint8_t> opcodes) {
+      uint32_t total = kOpcodeTiming[0x20].taken;
+      for (uint8_t opcode : opcodes) total += kOpcodeTiming[opcode].cycles;
+      return total;
+    };
+    // An interrupt the next Step() would dispatch (one an event in the
+    // SyncBus() just before the jump back may have raised) must cut in
+    // after this iteration, not after the loop
+    if ((ime_ || ei_delay_) && PendingInterrupts()) return false;
+
+    uint8_t head = at(0);
+    bool copy = head == 0x2A;
+    if (!copy && head != 0x22 && head != 0x32) return false;
+    uint8_t dec = at(copy ? 3 : 1);
+    uint8_t* counter = dec == 0x05 ? &b_ : dec == 0x0D ? &c_ : nullptr;
+    uint16_t length;
+    uint32_t period;
+    if (!copy && counter && at(2) == 0x20 && at(3) == 0xFC) {
+      length = 4;
+      period = cycles({head, dec});
+    } else if (copy && at(1) == 0x12 && at(2) == 0x13 && counter &&
+               at(4) == 0x20 && at(5) == 0xFA) {
+      length = 6;
+      period = cycles({0x2A, 0x12, 0x13, dec});
+    } else if (copy && at(1) == 0x12 && at(2) == 0x13 && dec == 0x0B &&
+               at(4) == 0x78 && at(5) == 0xB1 && at(6) == 0x20 &&
+               at(7) == 0xF8) {
+      length = 8;
+      period = cycles({0x2A, 0x12, 0x13, 0x0B, 0x78, 0xB1});
+    } else {
+      return false;
+    }
+
+    // From the head the loop runs `counter` more times (a zero counter
+    // wraps first), the last one falling through. Run all but that one,
+    // and on an EventBus only those that end before the next event, so it
+    // still lands on the instruction it would have.
+    uint16_t bc = static_cast<uint16_t>(b_ << 8 | c_);
+    uint32_t left = counter ? (*counter ? *counter : 0x100u)
+                            : (bc ? bc : 0x10000u);
+    uint32_t count = left - 1;
+    if constexpr (EventBus<Bus>) {
+      uint64_t until_event = bus_.CyclesUntilEvent();
+      if (until_event == 0) return false;
+      count = static_cast<uint32_t>(
+          std::min<uint64_t>(count, (until_event - 1) / period));
+    }
+    if (count == 0) return false;
+
+    // Both ends must be plain memory, and the loop must not overwrite
+    // its own code
+    uint16_t hl = this->hl();
+    uint16_t de = static_cast<uint16_t>(d_ << 8 | e_);
+    uint32_t dst = copy ? de : head == 0x22 ? hl : hl + 1u - count;
+    if (dst > 0xFFFF || dst + count > 0x10000 ||
+        (dst < pc_ + length && pc_ < dst + count)) {
+      return false;
+    }
+    uint8_t* out = bus_.WritableRange(static_cast<uint16_t>(dst), count);
+    const uint8_t* in = copy ? bus_.ReadableRange(hl, count) : nullptr;
+    if (out == nullptr || (copy && in == nullptr)) return false;
+
+    if (!copy) {
+      std::memset(out, a_, count);
+      set_hl(static_cast<uint16_t>(head == 0x22 ? hl + count : hl - count));
+    } else {
+      if (dst > hl && dst < hl + count) {
+        // Overlapping forwards: each byte copies one written earlier
+        for (uint32_t i = 0; i < count; ++i) out[i] = in[i];
+      } else {
+        std::memmove(out, in, count);
+      }
+      a_ = out[count - 1];
+      set_hl(static_cast<uint16_t>(hl + count));
+      de = static_cast<uint16_t>(de + count);
+      d_ = static_cast<uint8_t>(de >> 8);
+      e_ = static_cast<uint8_t>(de);
+    }
+    if (counter) {
+      // Flags as left by the last DEC
+      *counter = Dec8(static_cast<uint8_t>(*counter - count + 1));
+    } else {
+      // Flags as left by the last OR C
+      bc = static_cast<uint16_t>(bc - count);
+      b_ = static_cast<uint8_t>(bc >> 8);
+      c_ = static_cast<uint8_t>(bc);
+      a_ = b_;
+      Or8(c_);
+    }
+    uint32_t elapsed = count * period;
+    cycles_ += elapsed;
+    bus_.Tick(elapsed);
+    bulk_iterations_ += count;
+    ForgetIdleLoop();
+    return true;
+  }
+  return false;
+}
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::CheckIdleLoop() {
+  if constexpr (EventBus<Bus>) {
+    uint64_t until_event = bus_.CyclesUntilEvent();
+    uint64_t period = cycles_ - idle_start_;
+    // Back at the head after one iteration that wrote nothing, with the
+    // same registers and with no event in between (the horizon moved by
+    // exactly the iteration's length): every further iteration repeats
+    // this one until the event. Skip all but the one that reaches it, so
+    // the event still lands on the instruction it would have.
+    if (idle_clean_ && pc_ == idle_pc_ && period > 0 &&
+        until_event + period == idle_until_event_ && ime_ == idle_ime_ &&
+        ei_delay_ == idle_ei_delay_ && registers() == idle_regs_) {
+      uint64_t limit = std::min<uint64_t>(
+          until_event, std::numeric_limits<uint32_t>::max());
+      uint64_t skip = limit > 0 ? (limit - 1) / period * period : 0;
+      if (skip > 0) {
+        cycles_ += skip;
+        skipped_cycles_ += skip;
+        bus_.Tick(static_cast<uint32_t>(skip));
+        until_event -= skip;
+      }
+    }
+    idle_clean_ = true;
+    idle_pc_ = pc_;
+    idle_regs_ = registers();
+    idle_ime_ = ime_;
+    idle_ei_delay_ = ei_delay_;
+    idle_start_ = cycles_;
+    idle_until_event_ = until_event;
+  }
+}
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::StepInstruction() {
+  ExecuteTimed(FetchOpcode());
+}
+
+Registers CpuState::registers() const {
+  return Registers{a_, f_, b_, c_, d_, e_, h_, l_, sp_, pc_};
+}
+
+void CpuState::set_registers(const Registers& regs) {
+  a_ = regs.a;
+  f_ = regs.f;
+  b_ = regs.b;
+  c_ = regs.c;
+  d_ = regs.d;
+  e_ = regs.e;
+  h_ = regs.h;
+  l_ = regs.l;
+  sp_ = regs.sp;
+  pc_ = regs.pc;
+}
+
+void CpuState::SaveState(StateWriter& w) const {
+  for (uint8_t reg : {a_, f_, b_, c_, d_, e_, h_, l_}) w.Write(reg);
+  w.Write(sp_);
+  w.Write(pc_);
+  w.Write(ime_);
+  w.Write(ei_delay_);
+  w.Write(halted_);
+  w.Write(cycles_);
+}
+
+void CpuState::LoadState(StateReader& r) {
+  for (uint8_t* reg : {&a_, &f_, &b_, &c_, &d_, &e_, &h_, &l_}) r.Read(reg);
+  r.Read(&sp_);
+  r.Read(&pc_);
+  r.Read(&ime_);
+  r.Read(&ei_delay_);
+  r.Read(&halted_);
+  r.Read(&cycles_);
+  breakpoint_ = false;
+  ForgetIdleLoop();
 }
 
 // === Flag Helpers ===
 
-void CPU::SetFlag(uint8_t flag_mask, bool set) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::SetFlag(uint8_t flag_mask, bool set) {
   if (set) {
     f_ |= flag_mask;
   } else {
@@ -77,30 +584,34 @@ void CPU::SetFlag(uint8_t flag_mask, bool set) {
   f_ &= 0xF0; // Lower 4 bits are always 0
 }
 
-bool CPU::GetFlag(uint8_t flag_mask) const {
+template <MemoryBus Bus>
+bool BasicCpu<Bus>::GetFlag(uint8_t flag_mask) const {
   return (f_ & flag_mask) != 0;
 }
 
 // === Stack Helpers ===
 
-void CPU::PushWord(uint16_t word) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::PushWord(uint16_t word) {
   sp_--;
-  MMU::Instance().Write(sp_, static_cast<uint8_t>(word >> 8)); // High byte
+  Write8(sp_, static_cast<uint8_t>(word >> 8)); // High byte
   sp_--;
-  MMU::Instance().Write(sp_, static_cast<uint8_t>(word & 0xFF)); // Low byte
+  Write8(sp_, static_cast<uint8_t>(word & 0xFF)); // Low byte
 }
 
-uint16_t CPU::PopWord() {
-  uint16_t low = MMU::Instance().Read(sp_);
+template <MemoryBus Bus>
+uint16_t BasicCpu<Bus>::PopWord() {
+  uint16_t low = bus_.Read(sp_);
   sp_++;
-  uint16_t high = MMU::Instance().Read(sp_);
+  uint16_t high = bus_.Read(sp_);
   sp_++;
   return (high << 8) | low;
 }
 
 // === Arithmetic Helpers ===
 
-void CPU::Add8(uint8_t val, bool use_carry) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Add8(uint8_t val, bool use_carry) {
   uint8_t current_a = a_;
   uint8_t carry = (use_carry && GetFlag(kCarryFlagMask)) ? 1 : 0;
   uint16_t result = static_cast<uint16_t>(current_a) + val + carry;
@@ -112,7 +623,8 @@ void CPU::Add8(uint8_t val, bool use_carry) {
   SetFlag(kCarryFlagMask, result > 0xFF);
 }
 
-void CPU::Sub8(uint8_t val, bool use_carry) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Sub8(uint8_t val, bool use_carry) {
   uint8_t current_a = a_;
   uint8_t carry = (use_carry && GetFlag(kCarryFlagMask)) ? 1 : 0;
   // Simulate subtraction using addition with two's complement might be needed
@@ -131,7 +643,8 @@ void CPU::Sub8(uint8_t val, bool use_carry) {
   a_ = result_byte;
 }
 
-uint8_t CPU::Inc8(uint8_t reg) {
+template <MemoryBus Bus>
+uint8_t BasicCpu<Bus>::Inc8(uint8_t reg) {
   uint8_t result = reg + 1;
   SetFlag(kZeroFlagMask, result == 0);
   SetFlag(kSubtractFlagMask, false);
@@ -140,7 +653,8 @@ uint8_t CPU::Inc8(uint8_t reg) {
   return result;
 }
 
-uint8_t CPU::Dec8(uint8_t reg) {
+template <MemoryBus Bus>
+uint8_t BasicCpu<Bus>::Dec8(uint8_t reg) {
   uint8_t result = reg - 1;
   SetFlag(kZeroFlagMask, result == 0);
   SetFlag(kSubtractFlagMask, true);
@@ -151,7 +665,8 @@ uint8_t CPU::Dec8(uint8_t reg) {
 
 // === Logic Helpers ===
 
-void CPU::And8(uint8_t val) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::And8(uint8_t val) {
   a_ &= val;
   SetFlag(kZeroFlagMask, a_ == 0);
   SetFlag(kSubtractFlagMask, false);
@@ -159,7 +674,8 @@ void CPU::And8(uint8_t val) {
   SetFlag(kCarryFlagMask, false);
 }
 
-void CPU::Or8(uint8_t val) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Or8(uint8_t val) {
   a_ |= val;
   SetFlag(kZeroFlagMask, a_ == 0);
   SetFlag(kSubtractFlagMask, false);
@@ -167,7 +683,8 @@ void CPU::Or8(uint8_t val) {
   SetFlag(kCarryFlagMask, false);
 }
 
-void CPU::Xor8(uint8_t val) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Xor8(uint8_t val) {
   a_ ^= val;
   SetFlag(kZeroFlagMask, a_ == 0);
   SetFlag(kSubtractFlagMask, false);
@@ -175,7 +692,8 @@ void CPU::Xor8(uint8_t val) {
   SetFlag(kCarryFlagMask, false);
 }
 
-void CPU::Cp8(uint8_t val) {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::Cp8(uint8_t val) {
   uint8_t current_a = a_;
   uint16_t result_sub = static_cast<uint16_t>(current_a) - val;
   uint8_t result_byte = static_cast<uint8_t>(result_sub & 0xFF);
@@ -189,7 +707,8 @@ void CPU::Cp8(uint8_t val) {
 
 // === Rotate/Shift Helpers (A Register) ===
 
-void CPU::RlcA() { // RLCA 0x07
+template <MemoryBus Bus>
+void BasicCpu<Bus>::RlcA() { // RLCA 0x07
   uint8_t carry = (a_ & 0x80) >> 7;
   a_ = (a_ << 1) | carry;
   SetFlag(kZeroFlagMask, false);
@@ -198,7 +717,8 @@ void CPU::RlcA() { // RLCA 0x07
   SetFlag(kCarryFlagMask, carry);
 }
 
-void CPU::RrcA() { // RRCA 0x0F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::RrcA() { // RRCA 0x0F
   uint8_t carry = a_ & 0x01;
   a_ = (a_ >> 1) | (carry << 7);
   SetFlag(kZeroFlagMask, false);
@@ -207,7 +727,8 @@ void CPU::RrcA() { // RRCA 0x0F
   SetFlag(kCarryFlagMask, carry);
 }
 
-void CPU::RlA() { // RLA 0x17
+template <MemoryBus Bus>
+void BasicCpu<Bus>::RlA() { // RLA 0x17
   uint8_t old_carry = GetFlag(kCarryFlagMask) ? 1 : 0;
   uint8_t new_carry = (a_ & 0x80) >> 7;
   a_ = (a_ << 1) | old_carry;
@@ -217,7 +738,8 @@ void CPU::RlA() { // RLA 0x17
   SetFlag(kCarryFlagMask, new_carry);
 }
 
-void CPU::RrA() { // RRA 0x1F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::RrA() { // RRA 0x1F
   uint8_t old_carry = GetFlag(kCarryFlagMask) ? 1 : 0;
   uint8_t new_carry = a_ & 0x01;
   a_ = (a_ >> 1) | (old_carry << 7);
@@ -233,110 +755,201 @@ void CPU::RrA() { // RRA 0x1F
 // --- Load Instructions (LD) ---
 
 // 8-bit Loads
-void CPU::OpLD_B_d8() { b_ = Fetch8(); } // 0x06
-void CPU::OpLD_C_d8() { c_ = Fetch8(); } // 0x0E
-void CPU::OpLD_D_d8() { d_ = Fetch8(); } // 0x16
-void CPU::OpLD_E_d8() { e_ = Fetch8(); } // 0x1E
-void CPU::OpLD_H_d8() { h_ = Fetch8(); } // 0x26
-void CPU::OpLD_L_d8() { l_ = Fetch8(); } // 0x2E
-void CPU::OpLD_A_d8() { a_ = Fetch8(); } // 0x3E
-
-void CPU::OpLD_B_B() { /* NOP */ }         // 0x40
-void CPU::OpLD_B_C() { b_ = c_; }         // 0x41
-void CPU::OpLD_B_D() { b_ = d_; }         // 0x42
-void CPU::OpLD_B_E() { b_ = e_; }         // 0x43
-void CPU::OpLD_B_H() { b_ = h_; }         // 0x44
-void CPU::OpLD_B_L() { b_ = l_; }         // 0x45
-void CPU::OpLD_B_addrHL() { b_ = MMU::Instance().Read(hl()); } // 0x46
-void CPU::OpLD_B_A() { b_ = a_; }         // 0x47
-void CPU::OpLD_C_B() { c_ = b_; }         // 0x48
-void CPU::OpLD_C_C() { /* NOP */ }         // 0x49
-void CPU::OpLD_C_D() { c_ = d_; }         // 0x4A
-void CPU::OpLD_C_E() { c_ = e_; }         // 0x4B
-void CPU::OpLD_C_H() { c_ = h_; }         // 0x4C
-void CPU::OpLD_C_L() { c_ = l_; }         // 0x4D
-void CPU::OpLD_C_addrHL() { c_ = MMU::Instance().Read(hl()); } // 0x4E
-void CPU::OpLD_C_A() { c_ = a_; }         // 0x4F
-void CPU::OpLD_D_B() { d_ = b_; }         // 0x50
-void CPU::OpLD_D_C() { d_ = c_; }         // 0x51
-void CPU::OpLD_D_D() { /* NOP */ }         // 0x52
-void CPU::OpLD_D_E() { d_ = e_; }         // 0x53
-void CPU::OpLD_D_H() { d_ = h_; }         // 0x54
-void CPU::OpLD_D_L() { d_ = l_; }         // 0x55
-void CPU::OpLD_D_addrHL() { d_ = MMU::Instance().Read(hl()); } // 0x56
-void CPU::OpLD_D_A() { d_ = a_; }         // 0x57
-void CPU::OpLD_E_B() { e_ = b_; }         // 0x58
-void CPU::OpLD_E_C() { e_ = c_; }         // 0x59
-void CPU::OpLD_E_D() { e_ = d_; }         // 0x5A
-void CPU::OpLD_E_E() { /* NOP */ }         // 0x5B
-void CPU::OpLD_E_H() { e_ = h_; }         // 0x5C
-void CPU::OpLD_E_L() { e_ = l_; }         // 0x5D
-void CPU::OpLD_E_addrHL() { e_ = MMU::Instance().Read(hl()); } // 0x5E
-void CPU::OpLD_E_A() { e_ = a_; }         // 0x5F
-void CPU::OpLD_H_B() { h_ = b_; }         // 0x60
-void CPU::OpLD_H_C() { h_ = c_; }         // 0x61
-void CPU::OpLD_H_D() { h_ = d_; }         // 0x62
-void CPU::OpLD_H_E() { h_ = e_; }         // 0x63
-void CPU::OpLD_H_H() { /* NOP */ }         // 0x64
-void CPU::OpLD_H_L() { h_ = l_; }         // 0x65
-void CPU::OpLD_H_addrHL() { h_ = MMU::Instance().Read(hl()); } // 0x66
-void CPU::OpLD_H_A() { h_ = a_; }         // 0x67
-void CPU::OpLD_L_B() { l_ = b_; }         // 0x68
-void CPU::OpLD_L_C() { l_ = c_; }         // 0x69
-void CPU::OpLD_L_D() { l_ = d_; }         // 0x6A
-void CPU::OpLD_L_E() { l_ = e_; }         // 0x6B
-void CPU::OpLD_L_H() { l_ = h_; }         // 0x6C
-void CPU::OpLD_L_L() { /* NOP */ }         // 0x6D
-void CPU::OpLD_L_addrHL() { l_ = MMU::Instance().Read(hl()); } // 0x6E
-void CPU::OpLD_L_A() { l_ = a_; }         // 0x6F
-
-void CPU::OpLD_addrHL_B() { MMU::Instance().Write(hl(), b_); } // 0x70
-void CPU::OpLD_addrHL_C() { MMU::Instance().Write(hl(), c_); } // 0x71
-void CPU::OpLD_addrHL_D() { MMU::Instance().Write(hl(), d_); } // 0x72
-void CPU::OpLD_addrHL_E() { MMU::Instance().Write(hl(), e_); } // 0x73
-void CPU::OpLD_addrHL_H() { MMU::Instance().Write(hl(), h_); } // 0x74
-void CPU::OpLD_addrHL_L() { MMU::Instance().Write(hl(), l_); } // 0x75
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_d8() { b_ = Fetch8(); } // 0x06
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_d8() { c_ = Fetch8(); } // 0x0E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_d8() { d_ = Fetch8(); } // 0x16
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_d8() { e_ = Fetch8(); } // 0x1E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_d8() { h_ = Fetch8(); } // 0x26
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_d8() { l_ = Fetch8(); } // 0x2E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_d8() { a_ = Fetch8(); } // 0x3E
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_B() { breakpoint_ = true; } // 0x40, debug breakpoint
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_C() { b_ = c_; }         // 0x41
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_D() { b_ = d_; }         // 0x42
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_E() { b_ = e_; }         // 0x43
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_H() { b_ = h_; }         // 0x44
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_L() { b_ = l_; }         // 0x45
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_addrHL() { b_ = bus_.Read(hl()); } // 0x46
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_B_A() { b_ = a_; }         // 0x47
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_B() { c_ = b_; }         // 0x48
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_C() { /* NOP */ }         // 0x49
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_D() { c_ = d_; }         // 0x4A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_E() { c_ = e_; }         // 0x4B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_H() { c_ = h_; }         // 0x4C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_L() { c_ = l_; }         // 0x4D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_addrHL() { c_ = bus_.Read(hl()); } // 0x4E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_C_A() { c_ = a_; }         // 0x4F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_B() { d_ = b_; }         // 0x50
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_C() { d_ = c_; }         // 0x51
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_D() { /* NOP */ }         // 0x52
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_E() { d_ = e_; }         // 0x53
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_H() { d_ = h_; }         // 0x54
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_L() { d_ = l_; }         // 0x55
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_addrHL() { d_ = bus_.Read(hl()); } // 0x56
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_D_A() { d_ = a_; }         // 0x57
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_B() { e_ = b_; }         // 0x58
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_C() { e_ = c_; }         // 0x59
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_D() { e_ = d_; }         // 0x5A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_E() { /* NOP */ }         // 0x5B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_H() { e_ = h_; }         // 0x5C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_L() { e_ = l_; }         // 0x5D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_addrHL() { e_ = bus_.Read(hl()); } // 0x5E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_E_A() { e_ = a_; }         // 0x5F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_B() { h_ = b_; }         // 0x60
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_C() { h_ = c_; }         // 0x61
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_D() { h_ = d_; }         // 0x62
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_E() { h_ = e_; }         // 0x63
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_H() { /* NOP */ }         // 0x64
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_L() { h_ = l_; }         // 0x65
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_addrHL() { h_ = bus_.Read(hl()); } // 0x66
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_H_A() { h_ = a_; }         // 0x67
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_B() { l_ = b_; }         // 0x68
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_C() { l_ = c_; }         // 0x69
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_D() { l_ = d_; }         // 0x6A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_E() { l_ = e_; }         // 0x6B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_H() { l_ = h_; }         // 0x6C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_L() { /* NOP */ }         // 0x6D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_addrHL() { l_ = bus_.Read(hl()); } // 0x6E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_L_A() { l_ = a_; }         // 0x6F
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_B() { Write8(hl(), b_); } // 0x70
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_C() { Write8(hl(), c_); } // 0x71
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_D() { Write8(hl(), d_); } // 0x72
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_E() { Write8(hl(), e_); } // 0x73
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_H() { Write8(hl(), h_); } // 0x74
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_L() { Write8(hl(), l_); } // 0x75
 // 0x76 is HALT
-void CPU::OpLD_addrHL_A() { MMU::Instance().Write(hl(), a_); } // 0x77
-void CPU::OpLD_addrHL_d8() { MMU::Instance().Write(hl(), Fetch8()); } // 0x36
-
-void CPU::OpLD_A_B() { a_ = b_; }         // 0x78
-void CPU::OpLD_A_C() { a_ = c_; }         // 0x79
-void CPU::OpLD_A_D() { a_ = d_; }         // 0x7A
-void CPU::OpLD_A_E() { a_ = e_; }         // 0x7B
-void CPU::OpLD_A_H() { a_ = h_; }         // 0x7C
-void CPU::OpLD_A_L() { a_ = l_; }         // 0x7D
-void CPU::OpLD_A_addrHL() { a_ = MMU::Instance().Read(hl()); } // 0x7E
-void CPU::OpLD_A_A() { /* NOP */ }         // 0x7F
-
-void CPU::OpLD_A_addrBC() { a_ = MMU::Instance().Read((static_cast<uint16_t>(b_) << 8) | c_); } // 0x0A
-void CPU::OpLD_A_addrDE() { a_ = MMU::Instance().Read((static_cast<uint16_t>(d_) << 8) | e_); } // 0x1A
-void CPU::OpLD_A_addrHLinc() { a_ = MMU::Instance().Read(hl()); set_hl(hl() + 1); } // 0x2A, LD A, (HL+)
-void CPU::OpLD_A_addrHLdec() { a_ = MMU::Instance().Read(hl()); set_hl(hl() - 1); } // 0x3A, LD A, (HL-)
-
-void CPU::OpLD_addrBC_A() { MMU::Instance().Write((static_cast<uint16_t>(b_) << 8) | c_, a_); } // 0x02
-void CPU::OpLD_addrDE_A() { MMU::Instance().Write((static_cast<uint16_t>(d_) << 8) | e_, a_); } // 0x12
-void CPU::OpLD_addrHLinc_A() { MMU::Instance().Write(hl(), a_); set_hl(hl() + 1); } // 0x22, LD (HL+), A
-void CPU::OpLD_addrHLdec_A() { MMU::Instance().Write(hl(), a_); set_hl(hl() - 1); } // 0x32, LD (HL-), A
-
-void CPU::OpLD_A_a16() { uint16_t addr = Fetch16(); a_ = MMU::Instance().Read(addr); } // 0xFA
-void CPU::OpLD_a16_A() { uint16_t addr = Fetch16(); MMU::Instance().Write(addr, a_); } // 0xEA
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_A() { Write8(hl(), a_); } // 0x77
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHL_d8() { Write8(hl(), Fetch8()); } // 0x36
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_B() { a_ = b_; }         // 0x78
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_C() { a_ = c_; }         // 0x79
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_D() { a_ = d_; }         // 0x7A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_E() { a_ = e_; }         // 0x7B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_H() { a_ = h_; }         // 0x7C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_L() { a_ = l_; }         // 0x7D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_addrHL() { a_ = bus_.Read(hl()); } // 0x7E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_A() { /* NOP */ }         // 0x7F
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_addrBC() { a_ = bus_.Read((static_cast<uint16_t>(b_) << 8) | c_); } // 0x0A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_addrDE() { a_ = bus_.Read((static_cast<uint16_t>(d_) << 8) | e_); } // 0x1A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_addrHLinc() { a_ = bus_.Read(hl()); set_hl(hl() + 1); } // 0x2A, LD A, (HL+)
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_addrHLdec() { a_ = bus_.Read(hl()); set_hl(hl() - 1); } // 0x3A, LD A, (HL-)
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrBC_A() { Write8((static_cast<uint16_t>(b_) << 8) | c_, a_); } // 0x02
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrDE_A() { Write8((static_cast<uint16_t>(d_) << 8) | e_, a_); } // 0x12
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHLinc_A() { Write8(hl(), a_); set_hl(hl() + 1); } // 0x22, LD (HL+), A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrHLdec_A() { Write8(hl(), a_); set_hl(hl() - 1); } // 0x32, LD (HL-), A
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_a16() { uint16_t addr = Fetch16(); a_ = bus_.Read(addr); } // 0xFA
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_a16_A() { uint16_t addr = Fetch16(); Write8(addr, a_); } // 0xEA
 
 // High RAM (LDH)
-void CPU::OpLDH_A_a8() { uint16_t addr = 0xFF00 + Fetch8(); a_ = MMU::Instance().Read(addr); } // 0xF0
-void CPU::OpLDH_a8_A() { uint16_t addr = 0xFF00 + Fetch8(); MMU::Instance().Write(addr, a_); } // 0xE0
-void CPU::OpLD_A_addrC() { uint16_t addr = 0xFF00 + c_; a_ = MMU::Instance().Read(addr); } // 0xF2
-void CPU::OpLD_addrC_A() { uint16_t addr = 0xFF00 + c_; MMU::Instance().Write(addr, a_); } // 0xE2
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLDH_A_a8() { uint16_t addr = 0xFF00 + Fetch8(); a_ = bus_.Read(addr); } // 0xF0
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLDH_a8_A() { uint16_t addr = 0xFF00 + Fetch8(); Write8(addr, a_); } // 0xE0
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_A_addrC() { uint16_t addr = 0xFF00 + c_; a_ = bus_.Read(addr); } // 0xF2
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_addrC_A() { uint16_t addr = 0xFF00 + c_; Write8(addr, a_); } // 0xE2
 
 // 16-bit Loads
-void CPU::OpLD_BC_d16() { uint16_t val = Fetch16(); b_ = static_cast<uint8_t>(val >> 8); c_ = static_cast<uint8_t>(val & 0xFF); } // 0x01
-void CPU::OpLD_DE_d16() { uint16_t val = Fetch16(); d_ = static_cast<uint8_t>(val >> 8); e_ = static_cast<uint8_t>(val & 0xFF); } // 0x11
-void CPU::OpLD_HL_d16() { set_hl(Fetch16()); } // 0x21
-void CPU::OpLD_SP_d16() { sp_ = Fetch16(); } // 0x31
-
-void CPU::OpLD_SP_HL() { sp_ = hl(); } // 0xF9
-
-void CPU::OpLD_HL_SPplusr8() { // 0xF8
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_BC_d16() { uint16_t val = Fetch16(); b_ = static_cast<uint8_t>(val >> 8); c_ = static_cast<uint8_t>(val & 0xFF); } // 0x01
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_DE_d16() { uint16_t val = Fetch16(); d_ = static_cast<uint8_t>(val >> 8); e_ = static_cast<uint8_t>(val & 0xFF); } // 0x11
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_HL_d16() { set_hl(Fetch16()); } // 0x21
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_SP_d16() { sp_ = Fetch16(); } // 0x31
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_SP_HL() { sp_ = hl(); } // 0xF9
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_HL_SPplusr8() { // 0xF8
   int8_t offset = static_cast<int8_t>(Fetch8());
   uint16_t current_sp = sp_;
   uint16_t result = static_cast<uint16_t>(current_sp + offset);
@@ -351,127 +964,225 @@ void CPU::OpLD_HL_SPplusr8() { // 0xF8
   set_hl(result);
 }
 
-void CPU::OpLD_a16_SP() { // 0x08
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpLD_a16_SP() { // 0x08
   uint16_t addr = Fetch16();
-  MMU::Instance().Write(addr, static_cast<uint8_t>(sp_ & 0xFF)); // Low byte
-  MMU::Instance().Write(addr + 1, static_cast<uint8_t>(sp_ >> 8)); // High byte
+  Write8(addr, static_cast<uint8_t>(sp_ & 0xFF)); // Low byte
+  Write8(addr + 1, static_cast<uint8_t>(sp_ >> 8)); // High byte
 }
 
 
 // --- ALU Instructions ---
 
 // 8-bit Arithmetic (INC, DEC)
-void CPU::OpINC_B() { b_ = Inc8(b_); } // 0x04
-void CPU::OpDEC_B() { b_ = Dec8(b_); } // 0x05
-void CPU::OpINC_C() { c_ = Inc8(c_); } // 0x0C
-void CPU::OpDEC_C() { c_ = Dec8(c_); } // 0x0D
-void CPU::OpINC_D() { d_ = Inc8(d_); } // 0x14
-void CPU::OpDEC_D() { d_ = Dec8(d_); } // 0x15
-void CPU::OpINC_E() { e_ = Inc8(e_); } // 0x1C
-void CPU::OpDEC_E() { e_ = Dec8(e_); } // 0x1D
-void CPU::OpINC_H() { h_ = Inc8(h_); } // 0x24
-void CPU::OpDEC_H() { h_ = Dec8(h_); } // 0x25
-void CPU::OpINC_L() { l_ = Inc8(l_); } // 0x2C
-void CPU::OpDEC_L() { l_ = Dec8(l_); } // 0x2D
-void CPU::OpINC_A() { a_ = Inc8(a_); } // 0x3C
-void CPU::OpDEC_A() { a_ = Dec8(a_); } // 0x3D
-
-void CPU::OpINC_addrHL() { uint16_t addr = hl(); MMU::Instance().Write(addr, Inc8(MMU::Instance().Read(addr))); } // 0x34
-void CPU::OpDEC_addrHL() { uint16_t addr = hl(); MMU::Instance().Write(addr, Dec8(MMU::Instance().Read(addr))); } // 0x35
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_B() { b_ = Inc8(b_); } // 0x04
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_B() { b_ = Dec8(b_); } // 0x05
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_C() { c_ = Inc8(c_); } // 0x0C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_C() { c_ = Dec8(c_); } // 0x0D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_D() { d_ = Inc8(d_); } // 0x14
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_D() { d_ = Dec8(d_); } // 0x15
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_E() { e_ = Inc8(e_); } // 0x1C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_E() { e_ = Dec8(e_); } // 0x1D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_H() { h_ = Inc8(h_); } // 0x24
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_H() { h_ = Dec8(h_); } // 0x25
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_L() { l_ = Inc8(l_); } // 0x2C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_L() { l_ = Dec8(l_); } // 0x2D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_A() { a_ = Inc8(a_); } // 0x3C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_A() { a_ = Dec8(a_); } // 0x3D
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_addrHL() { uint16_t addr = hl(); Write8(addr, Inc8(bus_.Read(addr))); } // 0x34
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_addrHL() { uint16_t addr = hl(); Write8(addr, Dec8(bus_.Read(addr))); } // 0x35
 
 // 8-bit Arithmetic (ADD, ADC, SUB, SBC)
-void CPU::OpADD_A_B() { Add8(b_, false); } // 0x80
-void CPU::OpADD_A_C() { Add8(c_, false); } // 0x81
-void CPU::OpADD_A_D() { Add8(d_, false); } // 0x82
-void CPU::OpADD_A_E() { Add8(e_, false); } // 0x83
-void CPU::OpADD_A_H() { Add8(h_, false); } // 0x84
-void CPU::OpADD_A_L() { Add8(l_, false); } // 0x85
-void CPU::OpADD_A_addrHL() { Add8(MMU::Instance().Read(hl()), false); } // 0x86
-void CPU::OpADD_A_A() { Add8(a_, false); } // 0x87
-void CPU::OpADD_A_d8() { Add8(Fetch8(), false); } // 0xC6
-
-void CPU::OpADC_A_B() { Add8(b_, true); } // 0x88
-void CPU::OpADC_A_C() { Add8(c_, true); } // 0x89
-void CPU::OpADC_A_D() { Add8(d_, true); } // 0x8A
-void CPU::OpADC_A_E() { Add8(e_, true); } // 0x8B
-void CPU::OpADC_A_H() { Add8(h_, true); } // 0x8C
-void CPU::OpADC_A_L() { Add8(l_, true); } // 0x8D
-void CPU::OpADC_A_addrHL() { Add8(MMU::Instance().Read(hl()), true); } // 0x8E
-void CPU::OpADC_A_A() { Add8(a_, true); } // 0x8F
-void CPU::OpADC_A_d8() { Add8(Fetch8(), true); } // 0xCE
-
-void CPU::OpSUB_B() { Sub8(b_, false); } // 0x90
-void CPU::OpSUB_C() { Sub8(c_, false); } // 0x91
-void CPU::OpSUB_D() { Sub8(d_, false); } // 0x92
-void CPU::OpSUB_E() { Sub8(e_, false); } // 0x93
-void CPU::OpSUB_H() { Sub8(h_, false); } // 0x94
-void CPU::OpSUB_L() { Sub8(l_, false); } // 0x95
-void CPU::OpSUB_addrHL() { Sub8(MMU::Instance().Read(hl()), false); } // 0x96
-void CPU::OpSUB_A() { Sub8(a_, false); } // 0x97
-void CPU::OpSUB_d8() { Sub8(Fetch8(), false); } // 0xD6
-
-void CPU::OpSBC_A_B() { Sub8(b_, true); } // 0x98
-void CPU::OpSBC_A_C() { Sub8(c_, true); } // 0x99
-void CPU::OpSBC_A_D() { Sub8(d_, true); } // 0x9A
-void CPU::OpSBC_A_E() { Sub8(e_, true); } // 0x9B
-void CPU::OpSBC_A_H() { Sub8(h_, true); } // 0x9C
-void CPU::OpSBC_A_L() { Sub8(l_, true); } // 0x9D
-void CPU::OpSBC_A_addrHL() { Sub8(MMU::Instance().Read(hl()), true); } // 0x9E
-void CPU::OpSBC_A_A() { Sub8(a_, true); } // 0x9F
-void CPU::OpSBC_A_d8() { Sub8(Fetch8(), true); } // 0xDE
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_B() { Add8(b_, false); } // 0x80
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_C() { Add8(c_, false); } // 0x81
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_D() { Add8(d_, false); } // 0x82
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_E() { Add8(e_, false); } // 0x83
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_H() { Add8(h_, false); } // 0x84
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_L() { Add8(l_, false); } // 0x85
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_addrHL() { Add8(bus_.Read(hl()), false); } // 0x86
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_A() { Add8(a_, false); } // 0x87
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_A_d8() { Add8(Fetch8(), false); } // 0xC6
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_B() { Add8(b_, true); } // 0x88
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_C() { Add8(c_, true); } // 0x89
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_D() { Add8(d_, true); } // 0x8A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_E() { Add8(e_, true); } // 0x8B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_H() { Add8(h_, true); } // 0x8C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_L() { Add8(l_, true); } // 0x8D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_addrHL() { Add8(bus_.Read(hl()), true); } // 0x8E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_A() { Add8(a_, true); } // 0x8F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADC_A_d8() { Add8(Fetch8(), true); } // 0xCE
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_B() { Sub8(b_, false); } // 0x90
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_C() { Sub8(c_, false); } // 0x91
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_D() { Sub8(d_, false); } // 0x92
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_E() { Sub8(e_, false); } // 0x93
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_H() { Sub8(h_, false); } // 0x94
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_L() { Sub8(l_, false); } // 0x95
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_addrHL() { Sub8(bus_.Read(hl()), false); } // 0x96
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_A() { Sub8(a_, false); } // 0x97
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSUB_d8() { Sub8(Fetch8(), false); } // 0xD6
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_B() { Sub8(b_, true); } // 0x98
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_C() { Sub8(c_, true); } // 0x99
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_D() { Sub8(d_, true); } // 0x9A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_E() { Sub8(e_, true); } // 0x9B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_H() { Sub8(h_, true); } // 0x9C
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_L() { Sub8(l_, true); } // 0x9D
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_addrHL() { Sub8(bus_.Read(hl()), true); } // 0x9E
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_A() { Sub8(a_, true); } // 0x9F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSBC_A_d8() { Sub8(Fetch8(), true); } // 0xDE
 
 // 8-bit Logic (AND, OR, XOR, CP)
-void CPU::OpAND_B() { And8(b_); } // 0xA0
-void CPU::OpAND_C() { And8(c_); } // 0xA1
-void CPU::OpAND_D() { And8(d_); } // 0xA2
-void CPU::OpAND_E() { And8(e_); } // 0xA3
-void CPU::OpAND_H() { And8(h_); } // 0xA4
-void CPU::OpAND_L() { And8(l_); } // 0xA5
-void CPU::OpAND_addrHL() { And8(MMU::Instance().Read(hl())); } // 0xA6
-void CPU::OpAND_A() { And8(a_); } // 0xA7
-void CPU::OpAND_d8() { And8(Fetch8()); } // 0xE6
-
-void CPU::OpXOR_B() { Xor8(b_); } // 0xA8
-void CPU::OpXOR_C() { Xor8(c_); } // 0xA9
-void CPU::OpXOR_D() { Xor8(d_); } // 0xAA
-void CPU::OpXOR_E() { Xor8(e_); } // 0xAB
-void CPU::OpXOR_H() { Xor8(h_); } // 0xAC
-void CPU::OpXOR_L() { Xor8(l_); } // 0xAD
-void CPU::OpXOR_addrHL() { Xor8(MMU::Instance().Read(hl())); } // 0xAE
-void CPU::OpXOR_A() { Xor8(a_); } // 0xAF
-void CPU::OpXOR_d8() { Xor8(Fetch8()); } // 0xEE
-
-void CPU::OpOR_B() { Or8(b_); } // 0xB0
-void CPU::OpOR_C() { Or8(c_); } // 0xB1
-void CPU::OpOR_D() { Or8(d_); } // 0xB2
-void CPU::OpOR_E() { Or8(e_); } // 0xB3
-void CPU::OpOR_H() { Or8(h_); } // 0xB4
-void CPU::OpOR_L() { Or8(l_); } // 0xB5
-void CPU::OpOR_addrHL() { Or8(MMU::Instance().Read(hl())); } // 0xB6
-void CPU::OpOR_A() { Or8(a_); } // 0xB7
-void CPU::OpOR_d8() { Or8(Fetch8()); } // 0xF6
-
-void CPU::OpCP_B() { Cp8(b_); } // 0xB8
-void CPU::OpCP_C() { Cp8(c_); } // 0xB9
-void CPU::OpCP_D() { Cp8(d_); } // 0xBA
-void CPU::OpCP_E() { Cp8(e_); } // 0xBB
-void CPU::OpCP_H() { Cp8(h_); } // 0xBC
-void CPU::OpCP_L() { Cp8(l_); } // 0xBD
-void CPU::OpCP_addrHL() { Cp8(MMU::Instance().Read(hl())); } // 0xBE
-void CPU::OpCP_A() { Cp8(a_); } // 0xBF
-void CPU::OpCP_d8() { Cp8(Fetch8()); } // 0xFE
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_B() { And8(b_); } // 0xA0
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_C() { And8(c_); } // 0xA1
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_D() { And8(d_); } // 0xA2
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_E() { And8(e_); } // 0xA3
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_H() { And8(h_); } // 0xA4
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_L() { And8(l_); } // 0xA5
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_addrHL() { And8(bus_.Read(hl())); } // 0xA6
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_A() { And8(a_); } // 0xA7
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpAND_d8() { And8(Fetch8()); } // 0xE6
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_B() { Xor8(b_); } // 0xA8
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_C() { Xor8(c_); } // 0xA9
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_D() { Xor8(d_); } // 0xAA
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_E() { Xor8(e_); } // 0xAB
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_H() { Xor8(h_); } // 0xAC
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_L() { Xor8(l_); } // 0xAD
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_addrHL() { Xor8(bus_.Read(hl())); } // 0xAE
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_A() { Xor8(a_); } // 0xAF
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpXOR_d8() { Xor8(Fetch8()); } // 0xEE
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_B() { Or8(b_); } // 0xB0
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_C() { Or8(c_); } // 0xB1
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_D() { Or8(d_); } // 0xB2
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_E() { Or8(e_); } // 0xB3
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_H() { Or8(h_); } // 0xB4
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_L() { Or8(l_); } // 0xB5
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_addrHL() { Or8(bus_.Read(hl())); } // 0xB6
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_A() { Or8(a_); } // 0xB7
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpOR_d8() { Or8(Fetch8()); } // 0xF6
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_B() { Cp8(b_); } // 0xB8
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_C() { Cp8(c_); } // 0xB9
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_D() { Cp8(d_); } // 0xBA
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_E() { Cp8(e_); } // 0xBB
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_H() { Cp8(h_); } // 0xBC
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_L() { Cp8(l_); } // 0xBD
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_addrHL() { Cp8(bus_.Read(hl())); } // 0xBE
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_A() { Cp8(a_); } // 0xBF
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCP_d8() { Cp8(Fetch8()); } // 0xFE
 
 // 16-bit Arithmetic
-void CPU::OpINC_BC() { uint16_t bc = (static_cast<uint16_t>(b_) << 8) | c_; bc++; b_ = static_cast<uint8_t>(bc >> 8); c_ = static_cast<uint8_t>(bc & 0xFF); } // 0x03
-void CPU::OpDEC_BC() { uint16_t bc = (static_cast<uint16_t>(b_) << 8) | c_; bc--; b_ = static_cast<uint8_t>(bc >> 8); c_ = static_cast<uint8_t>(bc & 0xFF); } // 0x0B
-void CPU::OpINC_DE() { uint16_t de = (static_cast<uint16_t>(d_) << 8) | e_; de++; d_ = static_cast<uint8_t>(de >> 8); e_ = static_cast<uint8_t>(de & 0xFF); } // 0x13
-void CPU::OpDEC_DE() { uint16_t de = (static_cast<uint16_t>(d_) << 8) | e_; de--; d_ = static_cast<uint8_t>(de >> 8); e_ = static_cast<uint8_t>(de & 0xFF); } // 0x1B
-void CPU::OpINC_HL() { set_hl(hl() + 1); } // 0x23
-void CPU::OpDEC_HL() { set_hl(hl() - 1); } // 0x2B
-void CPU::OpINC_SP() { sp_++; } // 0x33
-void CPU::OpDEC_SP() { sp_--; } // 0x3B
-
-void CPU::OpADD_HL_BC() { // 0x09
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_BC() { uint16_t bc = (static_cast<uint16_t>(b_) << 8) | c_; bc++; b_ = static_cast<uint8_t>(bc >> 8); c_ = static_cast<uint8_t>(bc & 0xFF); } // 0x03
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_BC() { uint16_t bc = (static_cast<uint16_t>(b_) << 8) | c_; bc--; b_ = static_cast<uint8_t>(bc >> 8); c_ = static_cast<uint8_t>(bc & 0xFF); } // 0x0B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_DE() { uint16_t de = (static_cast<uint16_t>(d_) << 8) | e_; de++; d_ = static_cast<uint8_t>(de >> 8); e_ = static_cast<uint8_t>(de & 0xFF); } // 0x13
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_DE() { uint16_t de = (static_cast<uint16_t>(d_) << 8) | e_; de--; d_ = static_cast<uint8_t>(de >> 8); e_ = static_cast<uint8_t>(de & 0xFF); } // 0x1B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_HL() { set_hl(hl() + 1); } // 0x23
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_HL() { set_hl(hl() - 1); } // 0x2B
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpINC_SP() { sp_++; } // 0x33
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDEC_SP() { sp_--; } // 0x3B
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_HL_BC() { // 0x09
   uint16_t val1 = hl();
   uint16_t val2 = (static_cast<uint16_t>(b_) << 8) | c_;
   uint32_t result = static_cast<uint32_t>(val1) + val2;
@@ -480,7 +1191,8 @@ void CPU::OpADD_HL_BC() { // 0x09
   SetFlag(kCarryFlagMask, result > 0xFFFF);
   set_hl(static_cast<uint16_t>(result & 0xFFFF));
 }
-void CPU::OpADD_HL_DE() { // 0x19
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_HL_DE() { // 0x19
   uint16_t val1 = hl();
   uint16_t val2 = (static_cast<uint16_t>(d_) << 8) | e_;
   uint32_t result = static_cast<uint32_t>(val1) + val2;
@@ -489,7 +1201,8 @@ void CPU::OpADD_HL_DE() { // 0x19
   SetFlag(kCarryFlagMask, result > 0xFFFF);
   set_hl(static_cast<uint16_t>(result & 0xFFFF));
 }
-void CPU::OpADD_HL_HL() { // 0x29
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_HL_HL() { // 0x29
   uint16_t val1 = hl();
   uint32_t result = static_cast<uint32_t>(val1) + val1;
   SetFlag(kSubtractFlagMask, false);
@@ -497,7 +1210,8 @@ void CPU::OpADD_HL_HL() { // 0x29
   SetFlag(kCarryFlagMask, result > 0xFFFF);
   set_hl(static_cast<uint16_t>(result & 0xFFFF));
 }
-void CPU::OpADD_HL_SP() { // 0x39
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_HL_SP() { // 0x39
   uint16_t val1 = hl();
   uint16_t val2 = sp_;
   uint32_t result = static_cast<uint32_t>(val1) + val2;
@@ -507,7 +1221,8 @@ void CPU::OpADD_HL_SP() { // 0x39
   set_hl(static_cast<uint16_t>(result & 0xFFFF));
 }
 
-void CPU::OpADD_SP_r8() { // 0xE8
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpADD_SP_r8() { // 0xE8
   int8_t offset = static_cast<int8_t>(Fetch8());
   uint16_t current_sp = sp_;
   uint16_t result = static_cast<uint16_t>(current_sp + offset);
@@ -522,7 +1237,8 @@ void CPU::OpADD_SP_r8() { // 0xE8
 }
 
 // Miscellaneous ALU
-void CPU::OpDAA() { // 0x27
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDAA() { // 0x27
   uint16_t correction = 0;
   bool carry = GetFlag(kCarryFlagMask);
   bool half_carry = GetFlag(kHalfCarryFlagMask);
@@ -542,21 +1258,24 @@ void CPU::OpDAA() { // 0x27
   SetFlag(kHalfCarryFlagMask, false); // Always reset
 }
 
-void CPU::OpCPL() { // 0x2F - Complement A
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCPL() { // 0x2F - Complement A
   a_ = ~a_;
   SetFlag(kSubtractFlagMask, true);
   SetFlag(kHalfCarryFlagMask, true);
   // Z, C flags not affected
 }
 
-void CPU::OpSCF() { // 0x37 - Set Carry Flag
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSCF() { // 0x37 - Set Carry Flag
   SetFlag(kSubtractFlagMask, false);
   SetFlag(kHalfCarryFlagMask, false);
   SetFlag(kCarryFlagMask, true);
   // Z flag not affected
 }
 
-void CPU::OpCCF() { // 0x3F - Complement Carry Flag
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCCF() { // 0x3F - Complement Carry Flag
   SetFlag(kSubtractFlagMask, false);
   SetFlag(kHalfCarryFlagMask, false);
   SetFlag(kCarryFlagMask, !GetFlag(kCarryFlagMask));
@@ -564,235 +1283,362 @@ void CPU::OpCCF() { // 0x3F - Complement Carry Flag
 }
 
 // Rotates & Shifts (A Register only for non-CB)
-void CPU::OpRLCA() { RlcA(); } // 0x07
-void CPU::OpRRCA() { RrcA(); } // 0x0F
-void CPU::OpRLA() { RlA(); }   // 0x17
-void CPU::OpRRA() { RrA(); }   // 0x1F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRLCA() { RlcA(); } // 0x07
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRRCA() { RrcA(); } // 0x0F
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRLA() { RlA(); }   // 0x17
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRRA() { RrA(); }   // 0x1F
 
 
 // --- Control Flow Instructions ---
 
 // Jumps (JP, JR)
-void CPU::OpJP_a16() { // 0xC3
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJP_a16() { // 0xC3
   pc_ = Fetch16();
-  cycles_ += 4;
 }
 
-void CPU::OpJP_HL() { pc_ = hl(); } // 0xE9
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJP_HL() { pc_ = hl(); } // 0xE9
 
-void CPU::OpJP_NZ_a16() { // 0xC2
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJP_NZ_a16() { // 0xC2
   uint16_t addr = Fetch16();
   if (!GetFlag(kZeroFlagMask)) {
     pc_ = addr;
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJP_Z_a16() { // 0xCA
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJP_Z_a16() { // 0xCA
   uint16_t addr = Fetch16();
   if (GetFlag(kZeroFlagMask)) {
     pc_ = addr;
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJP_NC_a16() { // 0xD2
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJP_NC_a16() { // 0xD2
   uint16_t addr = Fetch16();
   if (!GetFlag(kCarryFlagMask)) {
     pc_ = addr;
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJP_C_a16() { // 0xDA
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJP_C_a16() { // 0xDA
   uint16_t addr = Fetch16();
   if (GetFlag(kCarryFlagMask)) {
     pc_ = addr;
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJR_r8() { // 0x18
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJR_r8() { // 0x18
   int8_t offset = static_cast<int8_t>(Fetch8());
   pc_ = static_cast<uint16_t>(pc_ + offset);
-  cycles_ += 4;
 }
 
-void CPU::OpJR_NZ_r8() { // 0x20
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJR_NZ_r8() { // 0x20
   int8_t offset = static_cast<int8_t>(Fetch8());
   if (!GetFlag(kZeroFlagMask)) {
     pc_ = static_cast<uint16_t>(pc_ + offset);
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJR_Z_r8() { // 0x28
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJR_Z_r8() { // 0x28
   int8_t offset = static_cast<int8_t>(Fetch8());
   if (GetFlag(kZeroFlagMask)) {
     pc_ = static_cast<uint16_t>(pc_ + offset);
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJR_NC_r8() { // 0x30
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJR_NC_r8() { // 0x30
   int8_t offset = static_cast<int8_t>(Fetch8());
   if (!GetFlag(kCarryFlagMask)) {
     pc_ = static_cast<uint16_t>(pc_ + offset);
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpJR_C_r8() { // 0x38
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpJR_C_r8() { // 0x38
   int8_t offset = static_cast<int8_t>(Fetch8());
   if (GetFlag(kCarryFlagMask)) {
     pc_ = static_cast<uint16_t>(pc_ + offset);
-    cycles_ += 4;
+    branch_taken_ = true;
   }
 }
 
 // Calls
-void CPU::OpCALL_a16() { // 0xCD
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCALL_a16() { // 0xCD
   uint16_t addr = Fetch16();
   PushWord(pc_);
   pc_ = addr;
-  // Account for call overhead
-  cycles_ += 12;
 }
 
-void CPU::OpCALL_NZ_a16() { // 0xC4
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCALL_NZ_a16() { // 0xC4
   uint16_t addr = Fetch16();
   if (!GetFlag(kZeroFlagMask)) {
     PushWord(pc_);
     pc_ = addr;
-    // Additional cycles when call is taken
-    cycles_ += 12;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpCALL_Z_a16() { // 0xCC
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCALL_Z_a16() { // 0xCC
   uint16_t addr = Fetch16();
   if (GetFlag(kZeroFlagMask)) {
     PushWord(pc_);
     pc_ = addr;
-    cycles_ += 12;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpCALL_NC_a16() { // 0xD4
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCALL_NC_a16() { // 0xD4
   uint16_t addr = Fetch16();
   if (!GetFlag(kCarryFlagMask)) {
     PushWord(pc_);
     pc_ = addr;
-    cycles_ += 12;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpCALL_C_a16() { // 0xDC
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpCALL_C_a16() { // 0xDC
   uint16_t addr = Fetch16();
   if (GetFlag(kCarryFlagMask)) {
     PushWord(pc_);
     pc_ = addr;
-    cycles_ += 12;
+    branch_taken_ = true;
   }
 }
 
 // Restarts (RST)
-void CPU::OpRST_00H() { PushWord(pc_); pc_ = 0x0000; } // 0xC7
-void CPU::OpRST_08H() { PushWord(pc_); pc_ = 0x0008; } // 0xCF
-void CPU::OpRST_10H() { PushWord(pc_); pc_ = 0x0010; } // 0xD7
-void CPU::OpRST_18H() { PushWord(pc_); pc_ = 0x0018; } // 0xDF
-void CPU::OpRST_20H() { PushWord(pc_); pc_ = 0x0020; } // 0xE7
-void CPU::OpRST_28H() { PushWord(pc_); pc_ = 0x0028; } // 0xEF
-void CPU::OpRST_30H() { PushWord(pc_); pc_ = 0x0030; } // 0xF7
-void CPU::OpRST_38H() { PushWord(pc_); pc_ = 0x0038; } // 0xFF
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_00H() { PushWord(pc_); pc_ = 0x0000; } // 0xC7
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_08H() { PushWord(pc_); pc_ = 0x0008; } // 0xCF
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_10H() { PushWord(pc_); pc_ = 0x0010; } // 0xD7
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_18H() { PushWord(pc_); pc_ = 0x0018; } // 0xDF
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_20H() { PushWord(pc_); pc_ = 0x0020; } // 0xE7
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_28H() { PushWord(pc_); pc_ = 0x0028; } // 0xEF
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_30H() { PushWord(pc_); pc_ = 0x0030; } // 0xF7
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRST_38H() { PushWord(pc_); pc_ = 0x0038; } // 0xFF
 
 // Returns (RET, RETI)
-void CPU::OpRET() { // 0xC9
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRET() { // 0xC9
   pc_ = PopWord();
-  // Account for return overhead
-  cycles_ += 8;
 }
 
-void CPU::OpRET_NZ() { // 0xC0
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRET_NZ() { // 0xC0
   if (!GetFlag(kZeroFlagMask)) {
     pc_ = PopWord();
-    // Additional cycles when return is taken
-    cycles_ += 8;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpRET_Z() { // 0xC8
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRET_Z() { // 0xC8
   if (GetFlag(kZeroFlagMask)) {
     pc_ = PopWord();
-    cycles_ += 8;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpRET_NC() { // 0xD0
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRET_NC() { // 0xD0
   if (!GetFlag(kCarryFlagMask)) {
     pc_ = PopWord();
-    cycles_ += 8;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpRET_C() { // 0xD8
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRET_C() { // 0xD8
   if (GetFlag(kCarryFlagMask)) {
     pc_ = PopWord();
-    cycles_ += 8;
+    branch_taken_ = true;
   }
 }
 
-void CPU::OpRETI() { // 0xD9
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpRETI() { // 0xD9
   pc_ = PopWord();
   ime_ = true; // Enable interrupts immediately after returning
-  // Account for return-from-interrupt overhead
-  cycles_ += 8;
 }
 
 
 // --- Stack Instructions (PUSH, POP) ---
 
-void CPU::OpPUSH_BC() { PushWord((static_cast<uint16_t>(b_) << 8) | c_); } // 0xC5
-void CPU::OpPUSH_DE() { PushWord((static_cast<uint16_t>(d_) << 8) | e_); } // 0xD5
-void CPU::OpPUSH_HL() { PushWord(hl()); } // 0xE5
-void CPU::OpPUSH_AF() { PushWord((static_cast<uint16_t>(a_) << 8) | f_); } // 0xF5
-
-void CPU::OpPOP_BC() { uint16_t val = PopWord(); b_ = static_cast<uint8_t>(val >> 8); c_ = static_cast<uint8_t>(val & 0xFF); } // 0xC1
-void CPU::OpPOP_DE() { uint16_t val = PopWord(); d_ = static_cast<uint8_t>(val >> 8); e_ = static_cast<uint8_t>(val & 0xFF); } // 0xD1
-void CPU::OpPOP_HL() { set_hl(PopWord()); } // 0xE1
-void CPU::OpPOP_AF() { uint16_t val = PopWord(); a_ = static_cast<uint8_t>(val >> 8); f_ = static_cast<uint8_t>(val & 0xF0); } // 0xF1
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPUSH_BC() { PushWord((static_cast<uint16_t>(b_) << 8) | c_); } // 0xC5
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPUSH_DE() { PushWord((static_cast<uint16_t>(d_) << 8) | e_); } // 0xD5
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPUSH_HL() { PushWord(hl()); } // 0xE5
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPUSH_AF() { PushWord((static_cast<uint16_t>(a_) << 8) | f_); } // 0xF5
+
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPOP_BC() { uint16_t val = PopWord(); b_ = static_cast<uint8_t>(val >> 8); c_ = static_cast<uint8_t>(val & 0xFF); } // 0xC1
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPOP_DE() { uint16_t val = PopWord(); d_ = static_cast<uint8_t>(val >> 8); e_ = static_cast<uint8_t>(val & 0xFF); } // 0xD1
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPOP_HL() { set_hl(PopWord()); } // 0xE1
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPOP_AF() { uint16_t val = PopWord(); a_ = static_cast<uint8_t>(val >> 8); f_ = static_cast<uint8_t>(val & 0xF0); } // 0xF1
 
 
 // --- Miscellaneous Instructions ---
 
-void CPU::OpNOP() {} // 0x00
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpNOP() {} // 0x00
 
-void CPU::OpSTOP() {  // 0x10
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpSTOP() {  // 0x10
   // Enter STOP (low-power) state, consume immediate operand
   (void)Fetch8();
   halted_ = true;
 }
 
-void CPU::OpHALT() {  // 0x76
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpHALT() {  // 0x76
   // HALT CPU until next interrupt
   halted_ = true;
 }
 
-void CPU::OpDI() { ime_ = false; } // 0xF3 - Disable Interrupts
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpDI() { ime_ = false; } // 0xF3 - Disable Interrupts
 
-void CPU::OpEI() {  // 0xFB - Enable Interrupts
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpEI() {  // 0xFB - Enable Interrupts
   // Delayed EI: set flag to enable interrupts after next instruction
   ei_delay_ = true;
 }
 
-void CPU::OpPREFIX_CB() { // 0xCB
-  // TODO: This should trigger CB prefix handling.
-  // If CB instructions are not implemented, this is effectively an illegal/NOP.
-  std::cerr << "Error: Encountered 0xCB prefix but CB instructions are not implemented." << std::endl;
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpPREFIX_CB() { // 0xCB
+  // Second dispatch through a table generated from the opcode bits, so
+  // it costs the same as the first
+  static constexpr auto kCbDispatch =
+      []<size_t... kOpcodes>(std::index_sequence<kOpcodes...>) {
+        return std::array<void (BasicCpu::*)(uint8_t), 256>{
+            &BasicCpu::template OpCb<CbOpFor(kOpcodes), kOpcodes & 7>...};
+      }(std::make_index_sequence<256>());
+  uint8_t opcode = FetchOpcode();
+  timing_index_ = static_cast<uint16_t>(kCbTimingBase + opcode);
+  (this->*kCbDispatch[opcode])(opcode);
+}
+
+// --- CB-Prefixed Instructions ---
+
+template <MemoryBus Bus>
+template <int kOperand>
+uint8_t BasicCpu<Bus>::ReadOperand() {
+  if constexpr (kOperand == 0) return b_;
+  else if constexpr (kOperand == 1) return c_;
+  else if constexpr (kOperand == 2) return d_;
+  else if constexpr (kOperand == 3) return e_;
+  else if constexpr (kOperand == 4) return h_;
+  else if constexpr (kOperand == 5) return l_;
+  else if constexpr (kOperand == 6) return bus_.Read(hl());
+  else return a_;
+}
+
+template <MemoryBus Bus>
+template <int kOperand>
+void BasicCpu<Bus>::WriteOperand(uint8_t value) {
+  if constexpr (kOperand == 0) b_ = value;
+  else if constexpr (kOperand == 1) c_ = value;
+  else if constexpr (kOperand == 2) d_ = value;
+  else if constexpr (kOperand == 3) e_ = value;
+  else if constexpr (kOperand == 4) h_ = value;
+  else if constexpr (kOperand == 5) l_ = value;
+  else if constexpr (kOperand == 6) Write8(hl(), value);
+  else a_ = value;
+}
+
+template <MemoryBus Bus>
+template <CbOp kOp>
+uint8_t BasicCpu<Bus>::Shift(uint8_t value) {
+  const uint8_t old_carry = (f_ & kCarryFlagMask) ? 1 : 0;
+  uint8_t result = 0;
+  uint8_t carry = 0;
+  if constexpr (kOp == CbOp::kRlc) {
+    carry = value >> 7;
+    result = static_cast<uint8_t>(value << 1) | carry;
+  } else if constexpr (kOp == CbOp::kRrc) {
+    carry = value & 1;
+    result = static_cast<uint8_t>((value >> 1) | (carry << 7));
+  } else if constexpr (kOp == CbOp::kRl) {
+    carry = value >> 7;
+    result = static_cast<uint8_t>(value << 1) | old_carry;
+  } else if constexpr (kOp == CbOp::kRr) {
+    carry = value & 1;
+    result = static_cast<uint8_t>((value >> 1) | (old_carry << 7));
+  } else if constexpr (kOp == CbOp::kSla) {
+    carry = value >> 7;
+    result = static_cast<uint8_t>(value << 1);
+  } else if constexpr (kOp == CbOp::kSra) {
+    carry = value & 1;
+    result = static_cast<uint8_t>((value >> 1) | (value & 0x80));
+  } else if constexpr (kOp == CbOp::kSwap) {
+    result = static_cast<uint8_t>((value << 4) | (value >> 4));
+  } else {
+    static_assert(kOp == CbOp::kSrl);
+    carry = value & 1;
+    result = value >> 1;
+  }
+  f_ = (result == 0 ? kZeroFlagMask : 0) | (carry ? kCarryFlagMask : 0);
+  return result;
+}
+
+template <MemoryBus Bus>
+template <CbOp kOp, int kOperand>
+void BasicCpu<Bus>::OpCb(uint8_t opcode) {
+  const uint8_t mask = static_cast<uint8_t>(1 << ((opcode >> 3) & 7));
+  uint8_t value = ReadOperand<kOperand>();
+  if constexpr (kOp == CbOp::kBit) {
+    // Z from the tested bit, N cleared, H set, C untouched
+    f_ = static_cast<uint8_t>((f_ & kCarryFlagMask) | kHalfCarryFlagMask |
+                              ((value & mask) ? 0 : kZeroFlagMask));
+  } else if constexpr (kOp == CbOp::kRes) {
+    WriteOperand<kOperand>(value & static_cast<uint8_t>(~mask));
+  } else if constexpr (kOp == CbOp::kSet) {
+    WriteOperand<kOperand>(value | mask);
+  } else {
+    WriteOperand<kOperand>(Shift<kOp>(value));
+  }
 }
 
 // Handler for undefined/illegal opcodes
-void CPU::OpIllegal() {
+template <MemoryBus Bus>
+void BasicCpu<Bus>::OpIllegal() {
   // Report illegal opcode and enter halted state
   std::cerr << "Error: Illegal opcode encountered at PC=0x"
             << std::hex << (pc_ - 1) << std::dec << std::endl;
@@ -800,11 +1646,9 @@ void CPU::OpIllegal() {
 }
 
 // Check and service any pending interrupts
-void CPU::ServiceInterrupts() {
-  // Read interrupt enable and flags
-  uint8_t ie = MMU::Instance().Read(0xFFFF);
-  uint8_t iflag = MMU::Instance().Read(0xFF0F);
-  uint8_t pending = ie & iflag;
+template <MemoryBus Bus>
+void BasicCpu<Bus>::ServiceInterrupts() {
+  uint8_t pending = PendingInterrupts();
   if (!pending) return;
   // If interrupts disabled, exit HALT but do not service
   if (!ime_) {
@@ -817,8 +1661,9 @@ void CPU::ServiceInterrupts() {
     if (pending & mask) {
       ime_ = false;
       halted_ = false;
+      ForgetIdleLoop();
       // Clear the IF flag for this interrupt
-      MMU::Instance().Write(0xFF0F, iflag & ~mask);
+      bus_.Write(kIfAddress, bus_.Read(kIfAddress) & ~mask);
       // Push current PC and jump to vector
       PushWord(pc_);
       pc_ = 0x0040 + i * 8;
@@ -828,4 +1673,14 @@ void CPU::ServiceInterrupts() {
   }
 }
 
-} // namespace gb
\ No newline at end of file
+// The CPU is compiled once per bus so memory accesses inline
+template class BasicCpu<MMU>;
+template class BasicCpu<MapperBus<NoMbc>>;
+template class BasicCpu<MapperBus<Mbc1>>;
+template class BasicCpu<MapperBus<Mbc2>>;
+template class BasicCpu<MapperBus<Mbc3>>;
+template class BasicCpu<MapperBus<Mbc5>>;
+template class BasicCpu<FastmemBus>;
+template class BasicCpu<FlatBus>;
+
+} // namespace gb
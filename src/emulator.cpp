@@ -0,0 +1,177 @@
+#include "gb/emulator.h"
+
+#include <limits>
+#include <utility>
+#include <variant>
+
+#include "gb/hash.h"
+#include "gb/movie.h"
+#include "gb/state.h"
+
+namespace gb {
+
+namespace {
+
+// "GBST" followed by a format version, bumped whenever a component
+// changes what it serializes
+constexpr uint32_t kStateMagic = 0x54534247;
+constexpr uint32_t kStateVersion = 2;
+
+} // namespace
+
+Emulator::Emulator()
+    : buses_(mmu_, mmu_, mmu_, mmu_, mmu_),
+      cpu_(std::in_place_type<MapperCpu<NoMbc>>,
+           std::get<MapperBus<NoMbc>>(buses_)),
+      cpu_state_(&std::get<MapperCpu<NoMbc>>(cpu_)) {
+  cpu().Reset();
+}
+
+void Emulator::LoadROM(const std::vector<uint8_t>& rom_data) {
+  cpu().set_aot(nullptr);
+  aot_.reset();
+  rom_hash_ = RomHash(rom_data);
+  mmu_.Reset();
+  mmu_.LoadROM(rom_data);
+  SelectCpu();
+  cpu().Reset();
+  framebuffer_.fill(0);
+  frame_end_ = mmu_.cycles() + kCyclesPerFrame;
+  frame_count_ = 0;
+}
+
+template <typename Mapper>
+void Emulator::UseCpu() {
+  if (std::holds_alternative<MapperCpu<Mapper>>(cpu_)) return;
+  CpuState state = cpu();
+  MapperCpu<Mapper>& next = cpu_.emplace<MapperCpu<Mapper>>(
+      std::get<MapperBus<Mapper>>(buses_));
+  static_cast<CpuState&>(next) = state;
+  cpu_state_ = &next;
+}
+
+void Emulator::SelectCpu() {
+  switch (mmu_.mbc_type()) {
+    case MbcType::kMbc1:
+      UseCpu<Mbc1>();
+      break;
+    case MbcType::kMbc2:
+      UseCpu<Mbc2>();
+      break;
+    case MbcType::kMbc3:
+      UseCpu<Mbc3>();
+      break;
+    case MbcType::kMbc5:
+      UseCpu<Mbc5>();
+      break;
+    default:
+      UseCpu<NoMbc>();
+      break;
+  }
+}
+
+bool Emulator::LoadAotPlugin(const std::string& directory,
+                             std::string* error) {
+  std::string path = directory + "/" + AotPlugin::FileName(rom_hash_);
+  std::unique_ptr<AotPlugin> plugin = AotPlugin::Load(path, error);
+  if (!plugin) return false;
+  if (plugin->rom_hash() != rom_hash_) {
+    *error = path + ": compiled from another ROM";
+    return false;
+  }
+  aot_ = std::move(plugin);
+  cpu().set_aot(aot_.get());
+  return true;
+}
+
+void Emulator::RunFrame() {
+  RunFrameFor(std::numeric_limits<uint64_t>::max());
+}
+
+bool Emulator::RunFrameFor(uint64_t max_steps) {
+  stop_requested_ = false;
+  mmu_.set_idle_limit(frame_end_);
+  // Dispatch on the mapper once per call rather than per Step()
+  bool done = std::visit(
+      [&](auto& cpu) {
+        for (uint64_t steps = 0; !frame_done(); ++steps) {
+          if (steps == max_steps) return false;
+          cpu.Step();
+          if (stop_requested_) return false;
+          if (stop_on_breakpoint_ && cpu.breakpoint()) return false;
+        }
+        return true;
+      },
+      cpu_);
+  if (done) EndFrame();
+  return done;
+}
+
+void Emulator::Step() {
+  std::visit([](auto& cpu) { cpu.Step(); }, cpu_);
+}
+
+void Emulator::EndFrame() {
+  frame_end_ += kCyclesPerFrame;
+  ++frame_count_;
+}
+
+std::vector<uint8_t> Emulator::SaveState() const {
+  std::vector<uint8_t> out;
+  StateWriter w(out);
+  w.Write(kStateMagic);
+  w.Write(kStateVersion);
+  cpu().SaveState(w);
+  mmu_.SaveState(w);
+  w.Write(framebuffer_);
+  w.Write(frame_end_);
+  w.Write(frame_count_);
+  return out;
+}
+
+StateHashes Emulator::RegionHashes() const {
+  StateHashes hashes{};
+  mmu_.HashRegions(hashes);
+  std::vector<uint8_t> cpu;
+  StateWriter w(cpu);
+  cpu_state_->SaveState(w);
+  hashes[static_cast<size_t>(StateRegion::kCpu)] =
+      Hash64(cpu.data(), cpu.size());
+  const uint64_t frame[] = {frame_end_, frame_count_};
+  hashes[static_cast<size_t>(StateRegion::kFrame)] = Hash64(
+      frame, sizeof(frame), Hash64(framebuffer_.data(), framebuffer_.size()));
+  return hashes;
+}
+
+uint64_t Emulator::StateHash() const {
+  StateHashes hashes = RegionHashes();
+  return Hash64(hashes.data(), sizeof(hashes));
+}
+
+bool Emulator::LoadState(const uint8_t* data, size_t size) {
+  // Components restore in place, so keep a copy to roll back to
+  std::vector<uint8_t> backup = SaveState();
+  StateReader r(data, size);
+  if (Restore(r)) return true;
+  StateReader undo(backup.data(), backup.size());
+  Restore(undo);
+  return false;
+}
+
+bool Emulator::Restore(StateReader& r) {
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  r.Read(&magic);
+  r.Read(&version);
+  if (!r.ok() || magic != kStateMagic || version != kStateVersion) {
+    return false;
+  }
+  cpu().LoadState(r);
+  bool ok = mmu_.LoadState(r);
+  r.Read(&framebuffer_);
+  r.Read(&frame_end_);
+  r.Read(&frame_count_);
+  return ok && r.done();
+}
+
+} // namespace gb
@@ -0,0 +1,235 @@
+#include "gb/fastmem.h"
+
+#ifdef GB_FASTMEM
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#endif
+
+namespace gb {
+
+#ifdef GB_FASTMEM
+
+namespace {
+
+constexpr size_t kGuestSize = 0x10000;
+constexpr long kHostPageSize = 0x1000;
+// Live buses the fault handler searches, one slot each
+constexpr size_t kMaxBuses = 256;
+
+// The instructions FastmemBus::Read/Write compile to
+constexpr uint8_t kLoad[] = {0x0F, 0xB6, 0x02}; // movzbl (%rdx),%eax
+constexpr uint8_t kStore[] = {0x88, 0x02};      // movb %al,(%rdx)
+
+std::array<std::atomic<FastmemBus*>, kMaxBuses> g_buses{};
+struct sigaction g_previous;
+std::once_flag g_install;
+
+} // namespace
+
+struct FastmemFaultHandler {
+  static void Handle(int sig, siginfo_t* info, void* context) {
+    auto* fault = static_cast<uint8_t*>(info->si_addr);
+    greg_t* regs = static_cast<ucontext_t*>(context)->uc_mcontext.gregs;
+    auto* rip = reinterpret_cast<const uint8_t*>(regs[REG_RIP]);
+    for (std::atomic<FastmemBus*>& slot : g_buses) {
+      FastmemBus* bus = slot.load(std::memory_order_acquire);
+      if (bus == nullptr || fault < bus->base_ ||
+          fault >= bus->base_ + kGuestSize) {
+        continue;
+      }
+      auto address = static_cast<uint16_t>(fault - bus->base_);
+      if (std::memcmp(rip, kLoad, sizeof(kLoad)) == 0) {
+        regs[REG_RAX] = bus->FaultRead(address);
+        regs[REG_RIP] += sizeof(kLoad);
+        return;
+      }
+      if (std::memcmp(rip, kStore, sizeof(kStore)) == 0) {
+        bus->FaultWrite(address, static_cast<uint8_t>(regs[REG_RAX]));
+        regs[REG_RIP] += sizeof(kStore);
+        return;
+      }
+      break; // Some other access into the region: a real crash
+    }
+    // Not ours: hand over to whoever was installed before
+    if (g_previous.sa_flags & SA_SIGINFO) {
+      g_previous.sa_sigaction(sig, info, context);
+    } else if (g_previous.sa_handler != SIG_DFL &&
+               g_previous.sa_handler != SIG_IGN) {
+      g_previous.sa_handler(sig);
+    } else {
+      // Let the fault repeat with the default action
+      signal(sig, SIG_DFL);
+    }
+  }
+};
+
+bool FastmemBus::Supported() {
+  return sysconf(_SC_PAGESIZE) == kHostPageSize;
+}
+
+FastmemBus::FastmemBus(MMU& mmu) : mmu_(mmu) {
+  if (!Supported()) return;
+  std::call_once(g_install, [] {
+    struct sigaction action {};
+    action.sa_sigaction = &FastmemFaultHandler::Handle;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &g_previous);
+  });
+
+  // Backing file: the RAM block, then the ROM image
+  const std::vector<uint8_t>& rom = mmu_.rom();
+  fd_ = memfd_create("gb-fastmem", MFD_CLOEXEC);
+  if (fd_ < 0) return;
+  if (ftruncate(fd_, kRamBlockSize + rom.size()) != 0 ||
+      pwrite(fd_, rom.data(), rom.size(), kRamBlockSize) !=
+          static_cast<ssize_t>(rom.size())) {
+    return;
+  }
+  void* ram = mmap(nullptr, kRamBlockSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd_, 0);
+  void* base = mmap(nullptr, kGuestSize, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (ram == MAP_FAILED || base == MAP_FAILED) {
+    if (ram != MAP_FAILED) munmap(ram, kRamBlockSize);
+    if (base != MAP_FAILED) munmap(base, kGuestSize);
+    return;
+  }
+  for (size_t i = 0; i < kMaxBuses; ++i) {
+    FastmemBus* expected = nullptr;
+    if (g_buses[i].compare_exchange_strong(expected, this)) {
+      slot_ = static_cast<int>(i);
+      break;
+    }
+  }
+  if (slot_ < 0) {
+    munmap(ram, kRamBlockSize);
+    munmap(base, kGuestSize);
+    return;
+  }
+  ram_ = static_cast<uint8_t*>(ram);
+  mmu_.UseRamBlock(ram_);
+  base_ = static_cast<uint8_t*>(base);
+  // Force the first full mapping
+  dma_mapped_ = true;
+  Sync();
+  if (map_failures_ > 0) Release();
+}
+
+FastmemBus::~FastmemBus() {
+  Release();
+  if (fd_ >= 0) close(fd_);
+}
+
+void FastmemBus::Release() {
+  if (base_ == nullptr) return;
+  g_buses[slot_].store(nullptr, std::memory_order_release);
+  // Hand the RAM contents back to the MMU
+  mmu_.UseRamBlock(nullptr);
+  munmap(base_, kGuestSize);
+  munmap(ram_, kRamBlockSize);
+  base_ = nullptr;
+}
+
+void FastmemBus::Sync() {
+  if (base_ == nullptr) return;
+  const BankState& banks = mmu_.banks();
+  bool dma = mmu_.dma_active();
+  bool logged = mmu_.ppu_log_enabled();
+  if (dma == dma_mapped_ && banks.rom0_offset == rom0_mapped_ &&
+      banks.romx_offset == romx_mapped_ && logged == vram_logged_) {
+    return;
+  }
+  // VRAM stores fault into the MMU while it logs them
+  int vram_prot = logged ? PROT_READ : PROT_READ | PROT_WRITE;
+  if (dma) {
+    // Every access below 0xFF00 may conflict with the transfer
+    MapNone(0x0000, kGuestSize);
+  } else if (dma_mapped_) {
+    MapFile(0x0000, kBankSize, kRamBlockSize + banks.rom0_offset, PROT_READ);
+    MapFile(0x4000, kBankSize, kRamBlockSize + banks.romx_offset, PROT_READ);
+    MapFile(0x8000, kVramSize, 0, vram_prot);
+    MapNone(0xA000, 0x2000); // Cartridge RAM: mapper controlled
+    MapFile(0xC000, kWram0Size + kWram1Size, kVramSize,
+            PROT_READ | PROT_WRITE);
+    MapFile(0xE000, kWram0Size, kVramSize, PROT_READ | PROT_WRITE); // Echo
+    MapNone(0xF000, 0x1000); // Echo tail, OAM, I/O, HRAM, IE
+  } else {
+    // Bank switch
+    if (banks.rom0_offset != rom0_mapped_) {
+      MapFile(0x0000, kBankSize, kRamBlockSize + banks.rom0_offset, PROT_READ);
+    }
+    if (banks.romx_offset != romx_mapped_) {
+      MapFile(0x4000, kBankSize, kRamBlockSize + banks.romx_offset, PROT_READ);
+    }
+    if (logged != vram_logged_) MapFile(0x8000, kVramSize, 0, vram_prot);
+  }
+  dma_mapped_ = dma;
+  vram_logged_ = logged;
+  rom0_mapped_ = banks.rom0_offset;
+  romx_mapped_ = banks.romx_offset;
+}
+
+void FastmemBus::MapFile(uint16_t address, uint32_t size, uint32_t offset,
+                         int prot) {
+  if (mmap(base_ + address, size, prot, MAP_SHARED | MAP_FIXED, fd_,
+           offset) == MAP_FAILED) {
+    MapFailed(address, size);
+  }
+}
+
+void FastmemBus::MapNone(uint16_t address, uint32_t size) {
+  if (mmap(base_ + address, size, PROT_NONE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1,
+           0) == MAP_FAILED) {
+    MapFailed(address, size);
+  }
+}
+
+void FastmemBus::MapFailed(uint16_t address, uint32_t size) {
+  ++map_failures_;
+  // Whatever was mapped there before (a stale ROM bank, writable VRAM)
+  // must not stay reachable: lock the range so its accesses fault into
+  // the MMU, which is slow but right
+  if (mprotect(base_ + address, size, PROT_NONE) != 0) {
+    std::fprintf(stderr, "fastmem: cannot remap guest 0x%04X-0x%04X: %s\n",
+                 address, address + size - 1, std::strerror(errno));
+    std::abort();
+  }
+}
+
+uint8_t FastmemBus::FaultRead(uint16_t address) {
+  ++faults_;
+  return mmu_.Read(address);
+}
+
+void FastmemBus::FaultWrite(uint16_t address, uint8_t value) {
+  ++faults_;
+  mmu_.Write(address, value);
+  // Bank switches and DMA starts change the mapping
+  Sync();
+}
+
+#else // !GB_FASTMEM
+
+bool FastmemBus::Supported() { return false; }
+
+FastmemBus::FastmemBus(MMU& mmu) : mmu_(mmu) {}
+
+FastmemBus::~FastmemBus() = default;
+
+void FastmemBus::Sync() {}
+
+#endif
+
+} // namespace gb
@@ -0,0 +1,114 @@
+#include "gb/gbcore.h"
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include "gb/batch.h"
+#include "gb/emulator.h"
+
+// The C handle is the emulator itself; the struct only exists so C code
+// gets a distinct opaque type.
+struct gb_emulator : gb::Emulator {};
+
+struct gb_batch : gb::BatchRunner {
+  using BatchRunner::BatchRunner;
+  // Reused conversion buffer from gb_emulator* to Emulator*
+  std::vector<gb::Emulator*> instances;
+};
+
+static_assert(GB_SCREEN_WIDTH == gb::kScreenWidth);
+static_assert(GB_SCREEN_HEIGHT == gb::kScreenHeight);
+static_assert(static_cast<int>(GB_BUTTON_A) == gb::kButtonA);
+static_assert(static_cast<int>(GB_BUTTON_DOWN) == gb::kButtonDown);
+
+// Nothing may throw across the C boundary; allocation failure is the only
+// thing the core can throw.
+
+gb_emulator* gb_create(void) {
+  try {
+    return new gb_emulator;
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+void gb_destroy(gb_emulator* emu) { delete emu; }
+
+int gb_load_rom(gb_emulator* emu, const uint8_t* data, size_t size) {
+  try {
+    emu->LoadROM(std::vector<uint8_t>(data, data + size));
+  } catch (const std::exception&) {
+    return -1;
+  }
+  return 0;
+}
+
+void gb_set_joypad(gb_emulator* emu, uint8_t buttons) {
+  emu->SetJoypad(buttons);
+}
+
+void gb_run_frames(gb_emulator* emu, uint32_t frames) {
+  for (uint32_t i = 0; i < frames; ++i) emu->RunFrame();
+}
+
+uint64_t gb_frame_count(const gb_emulator* emu) { return emu->frame_count(); }
+
+const uint8_t* gb_framebuffer(const gb_emulator* emu) {
+  return emu->framebuffer();
+}
+
+void gb_read_memory(const gb_emulator* emu, uint16_t address, uint8_t* out,
+                    size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = emu->mmu().Read(static_cast<uint16_t>(address + i));
+  }
+}
+
+void gb_write_memory(gb_emulator* emu, uint16_t address, const uint8_t* data,
+                     size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    emu->mmu().Write(static_cast<uint16_t>(address + i), data[i]);
+  }
+}
+
+size_t gb_save_state(const gb_emulator* emu, uint8_t* out, size_t capacity) {
+  try {
+    std::vector<uint8_t> state = emu->SaveState();
+    if (out && capacity >= state.size()) {
+      std::copy(state.begin(), state.end(), out);
+    }
+    return state.size();
+  } catch (const std::exception&) {
+    return 0;
+  }
+}
+
+int gb_load_state(gb_emulator* emu, const uint8_t* data, size_t size) {
+  try {
+    return emu->LoadState(data, size) ? 0 : -1;
+  } catch (const std::exception&) {
+    return -1;
+  }
+}
+
+gb_batch* gb_batch_create(uint32_t threads, int pin) {
+  try {
+    return new gb_batch(threads, pin != 0);
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+void gb_batch_destroy(gb_batch* batch) { delete batch; }
+
+int gb_batch_run_frame(gb_batch* batch, gb_emulator* const* emus,
+                       size_t count, uint8_t* frames) {
+  try {
+    batch->instances.assign(emus, emus + count);
+  } catch (const std::exception&) {
+    return -1;
+  }
+  batch->RunFrame(batch->instances.data(), count, frames);
+  return 0;
+}
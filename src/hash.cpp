@@ -0,0 +1,116 @@
+#include "gb/hash.h"
+
+#include <array>
+#include <cstring>
+
+// Compile the stripe loop for AVX2 as well and pick it at load time
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__)
+#define GB_HASH_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define GB_HASH_CLONES
+#endif
+
+namespace gb {
+
+namespace {
+
+constexpr size_t kLanes = 8;
+constexpr size_t kStripeSize = kLanes * sizeof(uint64_t);
+constexpr size_t kStripesPerBlock = 16;
+constexpr uint64_t kPrime32 = 0x9E3779B1ull;
+constexpr uint64_t kPrime64a = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime64b = 0xC2B2AE3D27D4EB4Full;
+
+// Per-stripe keys: stripe n of a block uses words n..n+7, so reordering
+// stripes changes the hash. The last eight words also scramble blocks.
+constexpr std::array<uint64_t, kLanes + kStripesPerBlock - 1> MakeKey() {
+  std::array<uint64_t, kLanes + kStripesPerBlock - 1> key{};
+  uint64_t x = 0;
+  for (uint64_t& word : key) {
+    // splitmix64
+    x += 0x9E3779B97F4A7C15ull;
+    uint64_t z = x;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    word = z ^ (z >> 31);
+  }
+  return key;
+}
+constexpr auto kKey = MakeKey();
+
+inline uint64_t Load64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void Accumulate(uint64_t* acc, const uint8_t* stripe,
+                       const uint64_t* key) {
+  for (size_t i = 0; i < kLanes; ++i) {
+    uint64_t v = Load64(stripe + i * sizeof(uint64_t));
+    uint64_t k = v ^ key[i];
+    acc[i ^ 1] += v;
+    acc[i] += (k & 0xFFFFFFFFull) * (k >> 32);
+  }
+}
+
+inline void Scramble(uint64_t* acc, const uint64_t* key) {
+  for (size_t i = 0; i < kLanes; ++i) {
+    uint64_t a = acc[i];
+    a ^= a >> 47;
+    a ^= key[i];
+    acc[i] = a * kPrime32;
+  }
+}
+
+inline uint64_t Avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= 0x165667919E3779F9ull;
+  return h ^ (h >> 32);
+}
+
+GB_HASH_CLONES void AccumulateStripes(uint64_t* acc, const uint8_t* p,
+                                      size_t stripes) {
+  size_t n = 0;
+  while (stripes > 0) {
+    Accumulate(acc, p, kKey.data() + n);
+    p += kStripeSize;
+    --stripes;
+    if (++n == kStripesPerBlock) {
+      Scramble(acc, kKey.data() + kStripesPerBlock - 1);
+      n = 0;
+    }
+  }
+}
+
+} // namespace
+
+uint64_t Hash64(const void* data, size_t size, uint64_t seed) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  uint64_t acc[kLanes];
+  for (size_t i = 0; i < kLanes; ++i) acc[i] = kKey[i] ^ seed;
+
+  size_t stripes = size / kStripeSize;
+  AccumulateStripes(acc, p, stripes);
+
+  // Zero-pad the tail to one more stripe; the length below tells the
+  // padding apart from real zeros
+  size_t tail = size % kStripeSize;
+  if (tail) {
+    uint8_t last[kStripeSize] = {};
+    std::memcpy(last, p + stripes * kStripeSize, tail);
+    Accumulate(acc, last, kKey.data() + stripes % kStripesPerBlock);
+  }
+
+  uint64_t h = size * kPrime64a;
+  for (size_t i = 0; i < kLanes; i += 2) {
+    h += Avalanche((acc[i] ^ kKey[i]) * kPrime64b) ^
+         ((acc[i + 1] ^ kKey[i + 1]) * kPrime64a);
+    h = (h << 31 | h >> 33) * kPrime64b;
+  }
+  return Avalanche(h);
+}
+
+} // namespace gb
+
+#undef GB_HASH_CLONES
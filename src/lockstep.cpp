@@ -0,0 +1,425 @@
+#include "gb/lockstep.h"
+
+#include <array>
+#include <utility>
+
+#include "gb/opcode_timing.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GB_LOCKSTEP_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace gb {
+
+namespace {
+
+// What a vectorizable opcode does to one lane
+enum class Kind : uint8_t {
+  kNone, // Not in the lockstep subset; lanes step through CPU::Step()
+  kNop,
+  kLd, // dst <- src (register or immediate)
+  kInc,
+  kDec,
+  kAdd, // A <- A op src
+  kSub,
+  kAnd,
+  kXor,
+  kOr,
+  kCp,
+  kJr, // Relative jump, optionally conditional
+};
+
+// Relative jump conditions
+enum Cond : uint8_t { kAlways, kIfNZ, kIfZ, kIfNC, kIfC };
+
+struct LaneOp {
+  Kind kind = Kind::kNone;
+  uint8_t dst = 0; // Register column (SM83 operand encoding)
+  uint8_t src = 0;
+  bool imm = false; // Operand is the byte after the opcode
+  Cond cond = kAlways;
+};
+
+constexpr uint8_t kRegA = 7;
+constexpr uint8_t kRegHL = 6; // (HL) operand: memory, never vectorized
+
+constexpr std::array<LaneOp, 256> kLaneOps = [] {
+  std::array<LaneOp, 256> ops{};
+  ops[0x00] = {Kind::kNop};
+  for (uint8_t r = 0; r < 8; ++r) {
+    if (r == kRegHL) continue;
+    ops[0x04 + 8 * r] = {Kind::kInc, r};
+    ops[0x05 + 8 * r] = {Kind::kDec, r};
+    ops[0x06 + 8 * r] = {Kind::kLd, r, 0, true};
+    for (uint8_t s = 0; s < 8; ++s) {
+      if (s == kRegHL) continue;
+      ops[0x40 + 8 * r + s] = {Kind::kLd, r, s};
+    }
+  }
+  ops[0x40] = {}; // LD B,B is the debugger breakpoint
+
+  // 0x80-0xBF: ALU A,r; ADC and SBC stay scalar
+  constexpr Kind kAlu[8] = {Kind::kAdd, Kind::kNone, Kind::kSub, Kind::kNone,
+                            Kind::kAnd, Kind::kXor,  Kind::kOr,  Kind::kCp};
+  for (uint8_t op = 0; op < 8; ++op) {
+    if (kAlu[op] == Kind::kNone) continue;
+    for (uint8_t s = 0; s < 8; ++s) {
+      if (s == kRegHL) continue;
+      ops[0x80 + 8 * op + s] = {kAlu[op], kRegA, s};
+    }
+    ops[0xC6 + 8 * op] = {kAlu[op], kRegA, 0, true};
+  }
+
+  ops[0x18] = {Kind::kJr, 0, 0, true, kAlways};
+  ops[0x20] = {Kind::kJr, 0, 0, true, kIfNZ};
+  ops[0x28] = {Kind::kJr, 0, 0, true, kIfZ};
+  ops[0x30] = {Kind::kJr, 0, 0, true, kIfNC};
+  ops[0x38] = {Kind::kJr, 0, 0, true, kIfC};
+  return ops;
+}();
+
+bool Taken(Cond cond, uint8_t f) {
+  switch (cond) {
+    case kIfNZ:
+      return !(f & kZeroFlagMask);
+    case kIfZ:
+      return (f & kZeroFlagMask) != 0;
+    case kIfNC:
+      return !(f & kCarryFlagMask);
+    case kIfC:
+      return (f & kCarryFlagMask) != 0;
+    default:
+      return true;
+  }
+}
+
+// One lane of a data operation, with the same flag rules as the CPU
+// helpers (Inc8, Add8, Sub8, ...)
+void ApplyLane(Kind kind, uint8_t& dst, uint8_t src, uint8_t& f) {
+  uint8_t d = dst;
+  uint8_t r;
+  switch (kind) {
+    case Kind::kLd:
+      dst = src;
+      return;
+    case Kind::kInc:
+      r = d + 1;
+      f = (r == 0 ? kZeroFlagMask : 0) |
+          ((r & 0x0F) == 0 ? kHalfCarryFlagMask : 0) | (f & kCarryFlagMask);
+      dst = r;
+      return;
+    case Kind::kDec:
+      r = d - 1;
+      f = (r == 0 ? kZeroFlagMask : 0) | kSubtractFlagMask |
+          ((r & 0x0F) == 0x0F ? kHalfCarryFlagMask : 0) |
+          (f & kCarryFlagMask);
+      dst = r;
+      return;
+    case Kind::kAdd:
+      r = d + src;
+      f = (r == 0 ? kZeroFlagMask : 0) |
+          ((d ^ src ^ r) & 0x10 ? kHalfCarryFlagMask : 0) |
+          (r < d ? kCarryFlagMask : 0);
+      dst = r;
+      return;
+    case Kind::kSub:
+    case Kind::kCp:
+      r = d - src;
+      f = (r == 0 ? kZeroFlagMask : 0) | kSubtractFlagMask |
+          ((d ^ src ^ r) & 0x10 ? kHalfCarryFlagMask : 0) |
+          (src > d ? kCarryFlagMask : 0);
+      if (kind == Kind::kSub) dst = r;
+      return;
+    case Kind::kAnd:
+      dst = d & src;
+      f = (dst == 0 ? kZeroFlagMask : 0) | kHalfCarryFlagMask;
+      return;
+    case Kind::kXor:
+      dst = d ^ src;
+      f = dst == 0 ? kZeroFlagMask : 0;
+      return;
+    case Kind::kOr:
+      dst = d | src;
+      f = dst == 0 ? kZeroFlagMask : 0;
+      return;
+    default:
+      return;
+  }
+}
+
+#if defined(GB_LOCKSTEP_AVX2)
+
+#define GB_AVX2 __attribute__((target("avx2"), always_inline)) inline
+
+GB_AVX2 __m256i Load(const uint8_t* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+GB_AVX2 void Store(uint8_t* p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+// Z for every zero byte of `r`
+GB_AVX2 __m256i ZeroFlag(__m256i r) {
+  return _mm256_and_si256(_mm256_cmpeq_epi8(r, _mm256_setzero_si256()),
+                          _mm256_set1_epi8(static_cast<char>(kZeroFlagMask)));
+}
+
+// Bit 4 of d ^ s ^ r is the carry/borrow out of bit 3; move it up to H
+GB_AVX2 __m256i HalfFlag(__m256i d, __m256i s, __m256i r) {
+  __m256i x = _mm256_and_si256(_mm256_xor_si256(_mm256_xor_si256(d, s), r),
+                               _mm256_set1_epi8(0x10));
+  return _mm256_add_epi8(x, x);
+}
+
+// ApplyLane() over whole 32-lane blocks; lanes outside `active` keep
+// their values. Returns how many leading lanes were handled.
+__attribute__((target("avx2"))) size_t ApplyAvx2(Kind kind, uint8_t* dst,
+                                                   const uint8_t* src,
+                                                   uint8_t* f,
+                                                   const uint8_t* active,
+                                                   size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi8(-1);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  const __m256i n_flag = _mm256_set1_epi8(kSubtractFlagMask);
+  const __m256i h_flag = _mm256_set1_epi8(kHalfCarryFlagMask);
+  const __m256i c_flag = _mm256_set1_epi8(kCarryFlagMask);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i mask = Load(active + i);
+    if (_mm256_testz_si256(mask, mask)) continue;
+    __m256i d = Load(dst + i);
+    __m256i s = Load(src + i);
+    __m256i fl = Load(f + i);
+    __m256i r = d;
+    __m256i nf = fl;
+    switch (kind) {
+      case Kind::kLd:
+        r = s;
+        break;
+      case Kind::kInc:
+        r = _mm256_sub_epi8(d, ones);
+        nf = _mm256_or_si256(
+            _mm256_or_si256(ZeroFlag(r), _mm256_and_si256(fl, c_flag)),
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_and_si256(r, low_nibble), zero),
+                h_flag));
+        break;
+      case Kind::kDec:
+        r = _mm256_add_epi8(d, ones);
+        nf = _mm256_or_si256(
+            _mm256_or_si256(ZeroFlag(r), _mm256_and_si256(fl, c_flag)),
+            _mm256_or_si256(
+                n_flag,
+                _mm256_and_si256(_mm256_cmpeq_epi8(
+                                     _mm256_and_si256(r, low_nibble),
+                                     low_nibble),
+                                 h_flag)));
+        break;
+      case Kind::kAdd: {
+        r = _mm256_add_epi8(d, s);
+        // Unsigned overflow: the saturating sum differs from the wrapped one
+        __m256i carry = _mm256_xor_si256(
+            _mm256_cmpeq_epi8(_mm256_adds_epu8(d, s), r), ones);
+        nf = _mm256_or_si256(
+            _mm256_or_si256(ZeroFlag(r), HalfFlag(d, s, r)),
+            _mm256_and_si256(carry, c_flag));
+        break;
+      }
+      case Kind::kSub:
+      case Kind::kCp: {
+        __m256i diff = _mm256_sub_epi8(d, s);
+        // Borrow when s > d, i.e. max(d, s) != d
+        __m256i borrow = _mm256_xor_si256(
+            _mm256_cmpeq_epi8(_mm256_max_epu8(d, s), d), ones);
+        nf = _mm256_or_si256(
+            _mm256_or_si256(ZeroFlag(diff), HalfFlag(d, s, diff)),
+            _mm256_or_si256(n_flag, _mm256_and_si256(borrow, c_flag)));
+        if (kind == Kind::kSub) r = diff;
+        break;
+      }
+      case Kind::kAnd:
+        r = _mm256_and_si256(d, s);
+        nf = _mm256_or_si256(ZeroFlag(r), h_flag);
+        break;
+      case Kind::kXor:
+        r = _mm256_xor_si256(d, s);
+        nf = ZeroFlag(r);
+        break;
+      case Kind::kOr:
+        r = _mm256_or_si256(d, s);
+        nf = ZeroFlag(r);
+        break;
+      default:
+        return 0;
+    }
+    Store(dst + i, _mm256_blendv_epi8(d, r, mask));
+    Store(f + i, _mm256_blendv_epi8(fl, nf, mask));
+  }
+  return i;
+}
+
+#undef GB_AVX2
+
+#endif // GB_LOCKSTEP_AVX2
+
+} // namespace
+
+bool LockstepEngine::SimdSupported() {
+#if defined(GB_LOCKSTEP_AVX2)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+LockstepEngine::LockstepEngine(std::vector<Emulator*> lanes, bool simd)
+    : lanes_(std::move(lanes)), simd_(simd && SimdSupported()) {
+  size_t n = lanes_.size();
+  for (auto& column : regs_) column.assign(n, 0);
+  f_.assign(n, 0);
+  pc_.assign(n, 0);
+  sp_.assign(n, 0);
+  active_.assign(n, 0);
+  imm_.assign(n, 0);
+}
+
+void LockstepEngine::Gather(size_t lane) {
+  Registers r = lanes_[lane]->cpu().registers();
+  regs_[0][lane] = r.b;
+  regs_[1][lane] = r.c;
+  regs_[2][lane] = r.d;
+  regs_[3][lane] = r.e;
+  regs_[4][lane] = r.h;
+  regs_[5][lane] = r.l;
+  regs_[kRegA][lane] = r.a;
+  f_[lane] = r.f;
+  pc_[lane] = r.pc;
+  sp_[lane] = r.sp;
+}
+
+void LockstepEngine::Scatter(size_t lane) {
+  Registers r;
+  r.b = regs_[0][lane];
+  r.c = regs_[1][lane];
+  r.d = regs_[2][lane];
+  r.e = regs_[3][lane];
+  r.h = regs_[4][lane];
+  r.l = regs_[5][lane];
+  r.a = regs_[kRegA][lane];
+  r.f = f_[lane];
+  r.pc = pc_[lane];
+  r.sp = sp_[lane];
+  lanes_[lane]->cpu().set_registers(r);
+}
+
+bool LockstepEngine::Eligible(size_t lane) const {
+  // The lockstep subset never touches IME, HALT or EI, so the CPU object's
+  // copies of those stay current while its registers live in the columns
+  const CpuState& cpu = lanes_[lane]->cpu();
+  if (cpu.halted() || cpu.ei_pending()) return false;
+  if (!cpu.ime()) return true;
+  const MMU& mmu = lanes_[lane]->mmu();
+  return mmu.pending_interrupts() == 0;
+}
+
+void LockstepEngine::RunFrame() {
+  size_t n = lanes_.size();
+  for (size_t i = 0; i < n; ++i) Gather(i);
+
+  for (;;) {
+    // Lead with the first lane that can take a lockstep step
+    size_t leader = n;
+    bool running = false;
+    for (size_t i = 0; i < n; ++i) {
+      if (lanes_[i]->frame_done()) continue;
+      running = true;
+      if (Eligible(i)) {
+        leader = i;
+        break;
+      }
+    }
+    if (!running) break;
+
+    uint16_t pc = 0;
+    uint8_t opcode = 0;
+    bool lockstep = false;
+    if (leader < n) {
+      pc = pc_[leader];
+      opcode = lanes_[leader]->mmu().Read(pc);
+      lockstep = kLaneOps[opcode].kind != Kind::kNone;
+    }
+
+    // Lanes that match the leader join the group; the rest step alone
+    size_t group = 0;
+    for (size_t i = 0; i < n; ++i) {
+      active_[i] = 0;
+      if (lanes_[i]->frame_done()) continue;
+      if (lockstep && pc_[i] == pc && Eligible(i) &&
+          lanes_[i]->mmu().Read(pc) == opcode) {
+        active_[i] = 0xFF;
+        ++group;
+        continue;
+      }
+      Scatter(i);
+      lanes_[i]->Step();
+      Gather(i);
+      ++stats_.scalar_instructions;
+    }
+    if (group > 0) {
+      ExecuteGroup(opcode);
+      ++stats_.vector_steps;
+      stats_.vector_instructions += group;
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    Scatter(i);
+    lanes_[i]->EndFrame();
+  }
+}
+
+void LockstepEngine::ExecuteGroup(uint8_t opcode) {
+  const LaneOp& op = kLaneOps[opcode];
+  size_t n = lanes_.size();
+
+  // Operands come from each lane's own memory map (banks may differ)
+  if (op.imm) {
+    for (size_t i = 0; i < n; ++i) {
+      if (active_[i]) {
+        imm_[i] = lanes_[i]->mmu().Read(static_cast<uint16_t>(pc_[i] + 1));
+      }
+    }
+  }
+
+  if (op.kind != Kind::kNop && op.kind != Kind::kJr) {
+    uint8_t* dst = regs_[op.dst].data();
+    const uint8_t* src = op.imm ? imm_.data() : regs_[op.src].data();
+    size_t done = 0;
+#if defined(GB_LOCKSTEP_AVX2)
+    if (simd_) done = ApplyAvx2(op.kind, dst, src, f_.data(), active_.data(), n);
+#endif
+    for (size_t i = done; i < n; ++i) {
+      if (active_[i]) ApplyLane(op.kind, dst[i], src[i], f_[i]);
+    }
+  }
+
+  // Program counters and clocks, charged from the same timing table as
+  // CPU::Step()
+  const OpcodeTiming& timing = kOpcodeTiming[opcode];
+  for (size_t i = 0; i < n; ++i) {
+    if (!active_[i]) continue;
+    uint32_t cycles = timing.cycles;
+    pc_[i] = static_cast<uint16_t>(pc_[i] + (op.imm ? 2 : 1));
+    if (op.kind == Kind::kJr && Taken(op.cond, f_[i])) {
+      pc_[i] = static_cast<uint16_t>(pc_[i] + static_cast<int8_t>(imm_[i]));
+      cycles = timing.taken;
+    }
+    lanes_[i]->cpu().AdvanceCycles(cycles);
+    lanes_[i]->mmu().Tick(cycles);
+  }
+}
+
+} // namespace gb
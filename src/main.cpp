@@ -1,10 +1,47 @@
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
-#include "gb/cpu.h"
+#include "gb/emulator.h"
+#include "gb/movie.h"
 
-int main() {
+namespace {
+
+// Wall-clock length of one emulated frame (~59.7 Hz)
+constexpr double kFrameMs = 1000.0 * gb::kCyclesPerFrame / 4194304.0;
+
+// Keyboard layout: arrows, Z/X for A/B, Enter/Backspace for Start/Select
+uint8_t ButtonForKey(SDL_Keycode key) {
+  switch (key) {
+    case SDLK_RIGHT:
+      return gb::kButtonRight;
+    case SDLK_LEFT:
+      return gb::kButtonLeft;
+    case SDLK_UP:
+      return gb::kButtonUp;
+    case SDLK_DOWN:
+      return gb::kButtonDown;
+    case SDLK_z:
+      return gb::kButtonA;
+    case SDLK_x:
+      return gb::kButtonB;
+    case SDLK_RETURN:
+      return gb::kButtonStart;
+    case SDLK_BACKSPACE:
+      return gb::kButtonSelect;
+    default:
+      return 0;
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) != 0) {
     std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
     return 1;
@@ -31,17 +68,80 @@ int main() {
 
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
 
-  gb::CPU cpu;
-  cpu.Reset();
+  // gameboy-emu [rom] [--record movie] [--aot plugin-dir]
+  const char* rom_path = nullptr;
+  const char* movie_path = nullptr;
+  const char* aot_dir = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--record" && i + 1 < argc) {
+      movie_path = argv[++i];
+    } else if (std::string(argv[i]) == "--aot" && i + 1 < argc) {
+      aot_dir = argv[++i];
+    } else {
+      rom_path = argv[i];
+    }
+  }
+
+  gb::Emulator emulator;
+  std::unique_ptr<gb::MovieRecorder> recorder;
+  if (rom_path) {
+    std::ifstream file(rom_path, std::ios::binary);
+    if (!file) {
+      std::cerr << "Cannot open ROM: " << rom_path << std::endl;
+    } else {
+      std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+      emulator.LoadROM(rom);
+      if (movie_path) {
+        recorder = std::make_unique<gb::MovieRecorder>(emulator, rom);
+      }
+      std::string error;
+      if (aot_dir && !emulator.LoadAotPlugin(aot_dir, &error)) {
+        std::cerr << "No AOT code: " << error << std::endl;
+      }
+    }
+  }
 
+  uint8_t buttons = 0;
+  Uint32 frame_start_ms = SDL_GetTicks();
   bool running = true;
   while (running) {
+    // Input that arrived during the last frame is replayed at the same
+    // offset into the next one, so presses keep their sub-frame timing
+    // instead of all landing on the frame boundary
+    uint64_t frame_cycle = emulator.mmu().cycles();
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
       if (event.type == SDL_QUIT) {
         running = false;
+      } else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+        uint8_t button = ButtonForKey(event.key.keysym.sym);
+        if (!button || event.key.repeat) continue;
+        if (event.type == SDL_KEYDOWN) {
+          buttons |= button;
+        } else {
+          buttons &= static_cast<uint8_t>(~button);
+        }
+        double offset_ms = event.key.timestamp >= frame_start_ms
+                               ? event.key.timestamp - frame_start_ms
+                               : 0.0;
+        if (offset_ms > kFrameMs) offset_ms = kFrameMs;
+        auto offset = static_cast<uint32_t>(offset_ms / kFrameMs *
+                                            gb::kCyclesPerFrame);
+        if (recorder) {
+          recorder->QueueInput(offset, buttons);
+        } else {
+          emulator.QueueInput(frame_cycle + offset, buttons);
+        }
       }
     }
+    frame_start_ms = SDL_GetTicks();
+
+    if (recorder) {
+      recorder->RunFrame();
+    } else {
+      emulator.RunFrame();
+    }
 
     SDL_RenderClear(renderer);
 
@@ -52,9 +152,17 @@ int main() {
     SDL_Delay(16); // ~60 FPS
   }
 
+  if (recorder) {
+    std::vector<uint8_t> movie = recorder->movie().Serialize();
+    std::ofstream out(movie_path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(movie.data()),
+              static_cast<std::streamsize>(movie.size()));
+    if (!out) std::cerr << "Cannot write movie: " << movie_path << std::endl;
+  }
+
   SDL_DestroyRenderer(renderer);
   SDL_DestroyWindow(window);
   SDL_Quit();
 
   return 0;
-}
\ No newline at end of file
+}
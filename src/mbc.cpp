@@ -0,0 +1,55 @@
+#include "gb/mbc.h"
+
+namespace gb {
+
+MbcType MbcTypeFromHeader(uint8_t cartridge_type) {
+  switch (cartridge_type) {
+    case 0x01: // MBC1
+    case 0x02: // MBC1+RAM
+    case 0x03: // MBC1+RAM+BATTERY
+      return MbcType::kMbc1;
+    case 0x05: // MBC2
+    case 0x06: // MBC2+BATTERY
+      return MbcType::kMbc2;
+    case 0x0F: // MBC3+TIMER+BATTERY
+    case 0x10: // MBC3+TIMER+RAM+BATTERY
+    case 0x11: // MBC3
+    case 0x12: // MBC3+RAM
+    case 0x13: // MBC3+RAM+BATTERY
+      return MbcType::kMbc3;
+    case 0x19: // MBC5
+    case 0x1A: // MBC5+RAM
+    case 0x1B: // MBC5+RAM+BATTERY
+    case 0x1C: // MBC5+RUMBLE
+    case 0x1D: // MBC5+RUMBLE+RAM
+    case 0x1E: // MBC5+RUMBLE+RAM+BATTERY
+      return MbcType::kMbc5;
+    default: // ROM only, ROM+RAM and unsupported mappers
+      return MbcType::kNone;
+  }
+}
+
+bool CartridgeHasRtc(uint8_t cartridge_type) {
+  return cartridge_type == 0x0F || cartridge_type == 0x10;
+}
+
+size_t SramSizeFromHeader(MbcType type, uint8_t ram_size_code) {
+  // MBC2 always has its own 512 nibbles and reports 0 in the header
+  if (type == MbcType::kMbc2) return kMbc2RamSize;
+  switch (ram_size_code) {
+    case 0x01:
+      return 0x800; // 2 KiB (unofficial, used by a few homebrew carts)
+    case 0x02:
+      return 0x2000; // 8 KiB, 1 bank
+    case 0x03:
+      return 0x8000; // 32 KiB, 4 banks
+    case 0x04:
+      return kMaxSramSize; // 128 KiB, 16 banks
+    case 0x05:
+      return 0x10000; // 64 KiB, 8 banks
+    default:
+      return 0;
+  }
+}
+
+} // namespace gb
@@ -1,8 +1,11 @@
 #include "gb/mmu.h"
 
-#include <algorithm> // for std::copy
+#include <algorithm> // for std::copy, std::fill, std::max
 #include <cstring>   // for std::memcpy
 #include <iostream>
+#include <iterator>  // for std::prev
+
+#include "gb/hash.h"
 
 namespace gb {
 
@@ -13,169 +16,470 @@ MMU& MMU::Instance() {
 
 MMU::MMU() {
   // Clear all memory regions
-  vram_.fill(0);
-  ext_ram_.fill(0);
-  wram0_.fill(0);
-  wram1_.fill(0);
+  ram_storage_.fill(0);
   oam_.fill(0);
   io_regs_.fill(0);
   hram_.fill(0);
+  // No cartridge yet: open bus everywhere in ROM space
+  rom_.assign(2 * kBankSize, 0xFF);
+  SelectMapper(MbcType::kNone);
 }
 
-// Load ROM data into bank0 + bankN (TODO: MBC handling)
 void MMU::LoadROM(const std::vector<uint8_t>& rom_data) {
-  rom_ = rom_data;
+  // Pad to a power-of-two bank count so bank numbers wrap with a mask
+  size_t banks = 2;
+  while (banks * kBankSize < rom_data.size()) banks <<= 1;
+  rom_.assign(banks * kBankSize, 0xFF);
+  std::copy(rom_data.begin(), rom_data.end(), rom_.begin());
+
+  uint8_t cart_type = rom_data.size() > 0x0147 ? rom_data[0x0147] : 0x00;
+  uint8_t ram_code = rom_data.size() > 0x0149 ? rom_data[0x0149] : 0x00;
+  mbc_type_ = MbcTypeFromHeader(cart_type);
+  has_rtc_ = CartridgeHasRtc(cart_type);
+  sram_.assign(SramSizeFromHeader(mbc_type_, ram_code), 0);
+
   // Reset banking registers
-  ram_enable_ = false;
-  rom_bank_low5_ = 1;
-  rom_bank_high2_ = 0;
-  banking_mode_ = 0;
+  banks_ = BankState{};
+  banks_.rtc.Reset(cycles_);
+  banks_.rom_bank_mask = static_cast<uint32_t>(banks - 1);
+  banks_.ram_bank_mask =
+      sram_.size() > kExtRamSize
+          ? static_cast<uint32_t>(sram_.size() / kExtRamSize - 1)
+          : 0;
+  SelectMapper(mbc_type_);
 }
 
-uint8_t MMU::CurrentRomBank() const {
-  // Merge low5 + high2 bits
-  uint8_t bank = (rom_bank_high2_ << 5) | (rom_bank_low5_ & 0x1F);
-  if ((bank & 0x1F) == 0) bank |= 1;
-  // Wrap around the actual number of banks
-  uint8_t max_banks = static_cast<uint8_t>(rom_.size() / kBankSize);
-  return bank % max_banks;
+std::vector<uint8_t> MMU::SaveBattery(int64_t unix_time) const {
+  std::vector<uint8_t> data = sram_;
+  if (has_rtc_) banks_.rtc.Serialize(data, cycles_, unix_time);
+  return data;
 }
 
-uint8_t MMU::CurrentRamBank() const {
-  return (banking_mode_ == 0) ? 0 : (rom_bank_high2_ & 0x03);
+bool MMU::LoadBattery(const std::vector<uint8_t>& data, int64_t unix_time) {
+  if (data.size() < sram_.size()) return false;
+  std::copy(data.begin(), data.begin() + sram_.size(), sram_.begin());
+  size_t trailer = data.size() - sram_.size();
+  if (has_rtc_ && trailer > 0) {
+    banks_.rtc.Deserialize(data.data() + sram_.size(), trailer, cycles_,
+                           unix_time);
+  }
+  return true;
 }
 
-uint8_t MMU::Read(uint16_t address) const {
-  if (address < 0x4000) {
-    // Bank 0 is always first 16K
-    return (address < rom_.size()) ? rom_[address] : 0xFF;
-  }
-  if (address < 0x8000) {
-    // Switchable ROM bank
-    uint8_t bank = CurrentRomBank();
-    size_t  idx  = bank * kBankSize + (address - kBankSize);
-    return (idx < rom_.size()) ? rom_[idx] : 0xFF;
-  }
-  if (address < 0xA000) {
-    return vram_[address - 0x8000];
-  }
-  if (address < 0xC000) {
-    // External RAM (banked)
-    if (!ram_enable_) return 0xFF;
-    uint8_t rb = CurrentRamBank();
-    size_t  off = rb * kExtRamSize + (address - 0xA000);
-    return (off < ext_ram_.size()) ? ext_ram_[off] : 0xFF;
-  }
-  if (address < 0xD000) {
-    return wram0_[address - 0xC000];
-  }
-  if (address < 0xE000) {
-    return wram1_[address - 0xD000];
-  }
-  if (address < 0xFE00) {
-    // Echo
-    return Read(address - 0x2000);
-  }
-  if (address < 0xFEA0) {
-    return oam_[address - 0xFE00];
-  }
-  if (address < 0xFF00) {
-    return 0xFF;  // unusable
+void MMU::SelectMapper(MbcType type) {
+  switch (type) {
+    case MbcType::kMbc1:
+      read_ = &MMU::ReadFor<Mbc1>;
+      write_ = &MMU::WriteFor<Mbc1>;
+      break;
+    case MbcType::kMbc2:
+      read_ = &MMU::ReadFor<Mbc2>;
+      write_ = &MMU::WriteFor<Mbc2>;
+      break;
+    case MbcType::kMbc3:
+      read_ = &MMU::ReadFor<Mbc3>;
+      write_ = &MMU::WriteFor<Mbc3>;
+      break;
+    case MbcType::kMbc5:
+      read_ = &MMU::ReadFor<Mbc5>;
+      write_ = &MMU::WriteFor<Mbc5>;
+      break;
+    default:
+      read_ = &MMU::ReadFor<NoMbc>;
+      write_ = &MMU::WriteFor<NoMbc>;
+      break;
   }
-  if (address < 0xFF80) {
-    return io_regs_[address - 0xFF00];
-  }
-  if (address < 0xFFFF) {
-    return hram_[address - 0xFF80];
+}
+
+// DMG register layout. Unused bits and write-only fields read back as 1,
+// read-only fields ignore writes, and the unmapped holes read 0xFF.
+constexpr std::array<MMU::IoRegister, kIoSize> MMU::kIoRegisters = [] {
+  std::array<IoRegister, kIoSize> t{};
+  auto reg = [&t](uint16_t address) -> IoRegister& {
+    return t[address - 0xFF00];
+  };
+  auto set = [&reg](uint16_t address, uint8_t read_ones, uint8_t writable) {
+    reg(address).read_ones = read_ones;
+    reg(address).writable = writable;
+  };
+  auto unmapped = [&set](uint16_t first, uint16_t last) {
+    for (uint16_t address = first; address <= last; ++address) {
+      set(address, 0xFF, 0x00);
+    }
+  };
+
+  // Joypad and serial port
+  reg(0xFF00).read = &MMU::ReadJoypad;
+  reg(0xFF00).write = &MMU::WriteJoypad;
+  reg(0xFF01).read = &MMU::ReadSerialData;
+  reg(0xFF01).write = &MMU::WriteSerialData;
+  reg(0xFF02).read = &MMU::ReadSerialControl;
+  reg(0xFF02).write = &MMU::WriteSerialControl;
+  unmapped(0xFF03, 0xFF03);
+
+  // Timer and interrupt flags
+  set(0xFF07, 0xF8, 0x07); // TAC
+  unmapped(0xFF08, 0xFF0E);
+  set(kIfAddress, 0xE0, 0x1F);
+  reg(kIfAddress).write = &MMU::WriteInterruptFlags;
+
+  // Sound
+  set(0xFF10, 0x80, 0x7F); // NR10
+  set(0xFF11, 0x3F, 0xFF); // NR11: length is write-only
+  set(0xFF13, 0xFF, 0xFF); // NR13
+  set(0xFF14, 0xBF, 0xC7); // NR14
+  unmapped(0xFF15, 0xFF15);
+  set(0xFF16, 0x3F, 0xFF); // NR21
+  set(0xFF18, 0xFF, 0xFF); // NR23
+  set(0xFF19, 0xBF, 0xC7); // NR24
+  set(0xFF1A, 0x7F, 0x80); // NR30
+  set(0xFF1B, 0xFF, 0xFF); // NR31
+  set(0xFF1C, 0x9F, 0x60); // NR32
+  set(0xFF1D, 0xFF, 0xFF); // NR33
+  set(0xFF1E, 0xBF, 0xC7); // NR34
+  unmapped(0xFF1F, 0xFF1F);
+  set(0xFF20, 0xFF, 0x3F); // NR41
+  set(0xFF23, 0xBF, 0xC0); // NR44
+  set(0xFF26, 0x70, 0x80); // NR52: channel status is read-only
+  unmapped(0xFF27, 0xFF2F);
+
+  // LCD. OAM DMA is logged as the OAM writes it makes.
+  set(0xFF41, 0x80, 0x78); // STAT: mode and coincidence are read-only
+  set(0xFF44, 0x00, 0x00); // LY
+  reg(0xFF46).write = &MMU::WriteOamDma;
+  for (uint16_t address : {0xFF40, 0xFF42, 0xFF43, 0xFF47, 0xFF48, 0xFF49,
+                           0xFF4A, 0xFF4B}) {
+    reg(address).ppu = true; // LCDC, SCY, SCX, palettes, WY, WX
   }
-  return interrupt_enable_;
+  unmapped(0xFF4C, 0xFF7F);
+  return t;
+}();
+
+uint8_t MMU::ReadIo(uint16_t address) const {
+  const IoRegister& reg = kIoRegisters[address - 0xFF00];
+  if (reg.read) return (this->*reg.read)(address);
+  return io_regs_[address - 0xFF00] | reg.read_ones;
 }
 
-void MMU::Write(uint16_t address, uint8_t value) {
-  if (address < 0x2000) {
-    // RAM enable
-    ram_enable_ = ((value & 0x0F) == 0x0A);
+void MMU::WriteIo(uint16_t address, uint8_t value) {
+  const IoRegister& reg = kIoRegisters[address - 0xFF00];
+  if (reg.ppu) LogPpuWrite(address, value);
+  if (reg.write) {
+    (this->*reg.write)(address, value);
     return;
   }
-  if (address < 0x4000) {
-    // ROM bank low 5 bits
-    rom_bank_low5_ = value & 0x1F;
-    return;
+  uint8_t& byte = io_regs_[address - 0xFF00];
+  byte = static_cast<uint8_t>((byte & ~reg.writable) | (value & reg.writable));
+}
+
+uint8_t MMU::ReadJoypad(uint16_t) const { return joypad_.Read(); }
+
+void MMU::WriteJoypad(uint16_t, uint8_t value) {
+  // Selecting a line with a button held raises the interrupt
+  if (joypad_.WriteSelect(value)) RequestInterrupt(Interrupt::Joypad);
+}
+
+uint8_t MMU::ReadSerialData(uint16_t) const { return serial_.data(); }
+
+void MMU::WriteSerialData(uint16_t, uint8_t value) {
+  serial_.WriteData(value);
+}
+
+uint8_t MMU::ReadSerialControl(uint16_t) const { return serial_.control(); }
+
+void MMU::WriteSerialControl(uint16_t, uint8_t value) {
+  if (serial_.WriteControl(value)) {
+    scheduler_.Schedule(Event::kSerial, cycles_ + Serial::kCyclesPerByte);
+  } else {
+    scheduler_.Cancel(Event::kSerial);
   }
-  if (address < 0x6000) {
-    // ROM bank high 2 bits (or RAM bank in mode 1)
-    rom_bank_high2_ = value & 0x03;
-    return;
+}
+
+void MMU::WriteInterruptFlags(uint16_t address, uint8_t value) {
+  io_regs_[address - 0xFF00] = value & 0x1F;
+  UpdatePendingInterrupts();
+}
+
+void MMU::WriteOamDma(uint16_t address, uint8_t value) {
+  StartOamDma(value);
+  io_regs_[address - 0xFF00] = value;
+}
+
+void MMU::RunEvents() {
+  Event event;
+  uint64_t when;
+  while (scheduler_.PopDue(cycles_, &event, &when)) {
+    switch (event) {
+      case Event::kOamDma:
+        FinishOamDma();
+        break;
+      case Event::kSerial:
+        serial_.Complete();
+        RequestInterrupt(Interrupt::Serial);
+        break;
+      case Event::kJoypad:
+        ApplyInputs();
+        break;
+      case Event::kCount:
+        break;
+    }
   }
-  if (address < 0x8000) {
-    // Banking mode select
-    banking_mode_ = value & 0x01;
-    return;
+}
+
+void MMU::SetJoypad(uint8_t buttons) {
+  if (joypad_.SetPressed(buttons)) RequestInterrupt(Interrupt::Joypad);
+}
+
+void MMU::QueueInput(uint64_t cycle, uint8_t buttons) {
+  // Keep the queue sorted; events for the same cycle stay in call order
+  auto it = inputs_.end();
+  while (it != inputs_.begin() && std::prev(it)->cycle > cycle) --it;
+  inputs_.insert(it, InputEvent{cycle, buttons});
+  scheduler_.Schedule(Event::kJoypad, std::max(inputs_.front().cycle, cycles_));
+}
+
+void MMU::ApplyInputs() {
+  while (!inputs_.empty() && inputs_.front().cycle <= cycles_) {
+    SetJoypad(inputs_.front().buttons);
+    inputs_.pop_front();
   }
-  if (address < 0xA000) {
-    // VRAM
-    vram_[address - 0x8000] = value;
-    return;
+  if (!inputs_.empty()) {
+    scheduler_.Schedule(Event::kJoypad, inputs_.front().cycle);
   }
-  if (address < 0xC000) {
-    // External RAM (banked)
-    if (ram_enable_) {
-      uint8_t rb = CurrentRamBank();
-      size_t  off = rb * kExtRamSize + (address - 0xA000);
-      if (off < ext_ram_.size()) {
-        ext_ram_[off] = value;
-      }
+}
+
+void MMU::StartOamDma(uint8_t page) {
+  // Pages 0xE0-0xFF read the WRAM the echo area mirrors
+  if (page >= 0xE0) page -= 0x20;
+  dma_source_ = static_cast<uint16_t>(page) << 8;
+  dma_start_ = cycles_ + kOamDmaSetupCycles;
+  dma_active_ = true;
+  // Restarting a running transfer simply replaces it
+  scheduler_.Schedule(Event::kOamDma, dma_start_ + kOamDmaCycles);
+}
+
+void MMU::FinishOamDma() {
+  dma_active_ = false;
+  // The CPU cannot observe OAM or the source bus while the transfer runs,
+  // so copying the whole page at the end is indistinguishable from
+  // copying a byte per M-cycle.
+  if (const uint8_t* src = PagePointer(dma_source_)) {
+    std::memcpy(oam_.data(), src, kOamSize);
+  } else {
+    for (uint16_t i = 0; i < kOamSize; ++i) {
+      oam_[i] = Read(dma_source_ + i);
     }
-    return;
-  }
-  if (address < 0xD000) {
-    wram0_[address - 0xC000] = value;
-    return;
-  }
-  if (address < 0xE000) {
-    wram1_[address - 0xD000] = value;
-    return;
   }
-  if (address < 0xFE00) {
-    // Echo
-    Write(address - 0x2000, value);
-    return;
+  if (ppu_log_enabled_) {
+    // Stamped with the cycle the transfer ended, not when RunEvents() got
+    // to it
+    uint64_t end = dma_start_ + kOamDmaCycles;
+    for (uint16_t i = 0; i < kOamSize; ++i) {
+      ppu_log_.push_back(PpuWrite{end, static_cast<uint16_t>(0xFE00 + i),
+                                  oam_[i]});
+    }
   }
-  if (address < 0xFEA0) {
-    oam_[address - 0xFE00] = value;
-    return;
+}
+
+bool MMU::DmaConflicts(uint16_t address) const {
+  // DMG has two buses: VRAM, and the external bus (ROM, SRAM, WRAM)
+  bool dma_on_vram = (dma_source_ & 0xE000) == 0x8000;
+  bool access_on_vram = (address & 0xE000) == 0x8000;
+  return dma_on_vram == access_on_vram;
+}
+
+const uint8_t* MMU::PagePointer(uint16_t address) const {
+  if (address < 0x4000) return &rom_[banks_.rom0_offset + address];
+  if (address < 0x8000) return &rom_[banks_.romx_offset + address - kBankSize];
+  if (address < 0xA000) return &vram_[address - 0x8000];
+  if (address < 0xC000) return nullptr; // Mapper decides what SRAM reads
+  if (address < 0xD000) return &wram0_[address - 0xC000];
+  if (address < 0xE000) return &wram1_[address - 0xD000];
+  return nullptr;
+}
+
+const uint8_t* MMU::ReadableRange(uint16_t address, uint32_t length) const {
+  uint32_t end = address + length;
+  if (dma_active_ || length == 0) return nullptr;
+  if (end <= 0x4000) return &rom_[banks_.rom0_offset + address];
+  if (address >= 0x4000 && end <= 0x8000) {
+    return &rom_[banks_.romx_offset + address - kBankSize];
   }
-  if (address < 0xFF00) {
-    // Unusable
-    return;
+  if (address >= 0x8000 && end <= 0xA000) return &vram_[address - 0x8000];
+  if (address >= 0xC000 && end <= 0xE000) {
+    return wram0_.data() + (address - 0xC000);
   }
-  if (address < 0xFF80) {
-    // OAM DMA trigger?
-    if (address == 0xFF46) {
-      uint16_t src = static_cast<uint16_t>(value) << 8;
-      for (int i = 0; i < kOamSize; ++i) {
-        oam_[i] = Read(src + i);
-      }
-    }
-    io_regs_[address - 0xFF00] = value;
-    return;
+  return nullptr;
+}
+
+uint8_t* MMU::WritableRange(uint16_t address, uint32_t length) {
+  uint32_t end = address + length;
+  if (dma_active_ || length == 0) return nullptr;
+  // Logged VRAM writes have to go through Write()
+  if (address >= 0x8000 && end <= 0xA000) {
+    return ppu_log_enabled_ ? nullptr : &vram_[address - 0x8000];
   }
-  if (address < 0xFFFF) {
-    hram_[address - 0xFF80] = value;
-    return;
+  // WRAM1 follows WRAM0 in the RAM block, wherever that lives
+  if (address >= 0xC000 && end <= 0xE000) {
+    return wram0_.data() + (address - 0xC000);
   }
-  interrupt_enable_ = value;
+  return nullptr;
+}
+
+void MMU::UseRamBlock(uint8_t* block) {
+  if (block == nullptr) block = ram_storage_.data();
+  if (block == vram_.data()) return;
+  std::memcpy(block, vram_.data(), kVramSize);
+  std::memcpy(block + kVramSize, wram0_.data(), kWram0Size);
+  std::memcpy(block + kVramSize + kWram0Size, wram1_.data(), kWram1Size);
+  vram_ = std::span<uint8_t, kVramSize>(block, kVramSize);
+  wram0_ = std::span<uint8_t, kWram0Size>(block + kVramSize, kWram0Size);
+  wram1_ = std::span<uint8_t, kWram1Size>(block + kVramSize + kWram0Size,
+                                          kWram1Size);
 }
 
 void MMU::Reset() {
-  vram_.fill(0);
-  ext_ram_.fill(0);
-  wram0_.fill(0);
-  wram1_.fill(0);
+  std::fill(vram_.begin(), vram_.end(), 0);
+  std::fill(sram_.begin(), sram_.end(), 0);
+  std::fill(wram0_.begin(), wram0_.end(), 0);
+  std::fill(wram1_.begin(), wram1_.end(), 0);
   oam_.fill(0);
   io_regs_.fill(0);
   hram_.fill(0);
   interrupt_enable_ = 0;
+  pending_interrupts_ = 0;
+  dma_active_ = false;
+  scheduler_.Cancel(Event::kOamDma);
+  scheduler_.Cancel(Event::kSerial);
+  scheduler_.Cancel(Event::kJoypad);
+  serial_.Reset();
+  joypad_.Reset();
+  inputs_.clear();
+}
+
+void MMU::SaveState(StateWriter& w) const {
+  w.Write(mbc_type_);
+  w.Write(static_cast<uint32_t>(sram_.size()));
+  w.WriteBytes(sram_.data(), sram_.size());
+  w.WriteBytes(vram_.data(), vram_.size());
+  w.WriteBytes(wram0_.data(), wram0_.size());
+  w.WriteBytes(wram1_.data(), wram1_.size());
+  w.Write(oam_);
+  w.Write(io_regs_);
+  w.Write(hram_);
+  SaveControlState(w);
+}
+
+void MMU::SaveControlState(StateWriter& w) const {
+  w.Write(interrupt_enable_);
+  w.Write(cycles_);
+  for (size_t i = 0; i < static_cast<size_t>(Event::kCount); ++i) {
+    w.Write(scheduler_.When(static_cast<Event>(i)));
+  }
+  w.Write(dma_active_);
+  w.Write(dma_source_);
+  w.Write(dma_start_);
+  serial_.SaveState(w);
+  joypad_.SaveState(w);
+  w.Write(static_cast<uint32_t>(inputs_.size()));
+  for (const InputEvent& input : inputs_) {
+    w.Write(input.cycle);
+    w.Write(input.buttons);
+  }
+
+  // Mapper registers; the window offsets are recomputed on load
+  w.Write(banks_.ram_enable);
+  w.Write(banks_.rom_bank);
+  w.Write(banks_.bank_hi);
+  w.Write(banks_.ram_bank);
+  w.Write(banks_.mode);
+  w.Write(banks_.rtc_latch_last);
+  banks_.rtc.SaveState(w);
+}
+
+void MMU::HashRegions(StateHashes& hashes) const {
+  auto hash = [&](StateRegion region, const void* data, size_t size,
+                  uint64_t seed = 0) {
+    hashes[static_cast<size_t>(region)] = Hash64(data, size, seed);
+  };
+  hash(StateRegion::kVram, vram_.data(), vram_.size());
+  hash(StateRegion::kWram, wram1_.data(), wram1_.size(),
+       Hash64(wram0_.data(), wram0_.size()));
+  hash(StateRegion::kOam, oam_.data(), oam_.size());
+  hash(StateRegion::kIo, io_regs_.data(), io_regs_.size());
+  hash(StateRegion::kHram, hram_.data(), hram_.size());
+  hash(StateRegion::kSram, sram_.data(), sram_.size());
+  std::vector<uint8_t> control;
+  StateWriter w(control);
+  SaveControlState(w);
+  hash(StateRegion::kMmu, control.data(), control.size());
+}
+
+bool MMU::LoadState(StateReader& r) {
+  MbcType type = MbcType::kNone;
+  uint32_t sram_size = 0;
+  r.Read(&type);
+  r.Read(&sram_size);
+  if (!r.ok() || type != mbc_type_ || sram_size != sram_.size()) return false;
+  r.ReadBytes(sram_.data(), sram_.size());
+  r.ReadBytes(vram_.data(), vram_.size());
+  r.ReadBytes(wram0_.data(), wram0_.size());
+  r.ReadBytes(wram1_.data(), wram1_.size());
+  r.Read(&oam_);
+  r.Read(&io_regs_);
+  r.Read(&hram_);
+  r.Read(&interrupt_enable_);
+  UpdatePendingInterrupts();
+  r.Read(&cycles_);
+  scheduler_.Clear();
+  for (size_t i = 0; i < static_cast<size_t>(Event::kCount); ++i) {
+    uint64_t when = Scheduler::kNever;
+    r.Read(&when);
+    if (when != Scheduler::kNever) {
+      scheduler_.Schedule(static_cast<Event>(i), when);
+    }
+  }
+  r.Read(&dma_active_);
+  r.Read(&dma_source_);
+  r.Read(&dma_start_);
+  serial_.LoadState(r);
+  joypad_.LoadState(r);
+  uint32_t input_count = 0;
+  r.Read(&input_count);
+  inputs_.clear();
+  for (uint32_t i = 0; i < input_count && r.ok(); ++i) {
+    InputEvent input{};
+    r.Read(&input.cycle);
+    r.Read(&input.buttons);
+    inputs_.push_back(input);
+  }
+
+  r.Read(&banks_.ram_enable);
+  r.Read(&banks_.rom_bank);
+  r.Read(&banks_.bank_hi);
+  r.Read(&banks_.ram_bank);
+  r.Read(&banks_.mode);
+  r.Read(&banks_.rtc_latch_last);
+  banks_.rtc.LoadState(r);
+  // Rebuild the window offsets from the restored registers
+  switch (mbc_type_) {
+    case MbcType::kMbc1:
+      Mbc1::UpdateWindows(banks_);
+      break;
+    case MbcType::kMbc2:
+      Mbc2::UpdateWindows(banks_);
+      break;
+    case MbcType::kMbc3:
+      Mbc3::UpdateWindows(banks_);
+      break;
+    case MbcType::kMbc5:
+      Mbc5::UpdateWindows(banks_);
+      break;
+    default:
+      NoMbc::UpdateWindows(banks_);
+      break;
+  }
+  return r.ok();
 }
 
 } // namespace gb
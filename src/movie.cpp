@@ -0,0 +1,143 @@
+#include "gb/movie.h"
+
+#include <chrono>
+#include <iterator>
+
+#include "gb/hash.h"
+#include "gb/state.h"
+
+namespace gb {
+
+namespace {
+
+// "GBMV" followed by a format version. Version 2 switched the frame
+// hashes from FNV-1a over the save state to Emulator::StateHash().
+constexpr uint32_t kMovieMagic = 0x564D4247;
+constexpr uint32_t kMovieVersion = 2;
+
+} // namespace
+
+size_t QueueFrameInputs(Emulator& emu, const std::vector<MovieInput>& inputs,
+                        size_t index, uint32_t frame) {
+  uint64_t base = emu.mmu().cycles();
+  for (; index < inputs.size() && inputs[index].frame == frame; ++index) {
+    emu.QueueInput(base + inputs[index].offset, inputs[index].buttons);
+  }
+  return index;
+}
+
+uint64_t RomHash(const std::vector<uint8_t>& rom) {
+  return Fnv1a64(rom.data(), rom.size());
+}
+
+std::vector<uint8_t> Movie::Serialize() const {
+  std::vector<uint8_t> out;
+  StateWriter w(out);
+  w.Write(kMovieMagic);
+  w.Write(kMovieVersion);
+  w.Write(rom_hash);
+  w.Write(static_cast<uint32_t>(start_state.size()));
+  w.WriteBytes(start_state.data(), start_state.size());
+  w.Write(static_cast<uint32_t>(inputs.size()));
+  for (const MovieInput& input : inputs) {
+    w.Write(input.frame);
+    w.Write(input.offset);
+    w.Write(input.buttons);
+  }
+  w.Write(frames());
+  w.WriteBytes(frame_hashes.data(), frame_hashes.size() * sizeof(uint64_t));
+  return out;
+}
+
+bool Movie::Deserialize(const uint8_t* data, size_t size) {
+  StateReader r(data, size);
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  r.Read(&magic);
+  r.Read(&version);
+  if (!r.ok() || magic != kMovieMagic || version != kMovieVersion) {
+    return false;
+  }
+  r.Read(&rom_hash);
+
+  // Every count is checked against the bytes left before allocating
+  uint32_t count = 0;
+  r.Read(&count);
+  if (count > size) return false;
+  start_state.resize(count);
+  r.ReadBytes(start_state.data(), count);
+
+  r.Read(&count);
+  if (count > size) return false;
+  inputs.resize(count);
+  for (MovieInput& input : inputs) {
+    r.Read(&input.frame);
+    r.Read(&input.offset);
+    r.Read(&input.buttons);
+  }
+
+  r.Read(&count);
+  if (count > size) return false;
+  frame_hashes.resize(count);
+  r.ReadBytes(frame_hashes.data(), count * sizeof(uint64_t));
+  return r.done();
+}
+
+MovieRecorder::MovieRecorder(Emulator& emu, const std::vector<uint8_t>& rom,
+                             bool from_current_state)
+    : emu_(emu) {
+  movie_.rom_hash = RomHash(rom);
+  if (from_current_state) {
+    movie_.start_state = emu_.SaveState();
+  } else {
+    emu_.LoadROM(rom);
+  }
+}
+
+void MovieRecorder::QueueInput(uint32_t offset, uint8_t buttons) {
+  // Keep this frame's inputs ordered by offset
+  auto it = movie_.inputs.end();
+  auto first = movie_.inputs.begin() + first_pending_;
+  while (it != first && std::prev(it)->offset > offset) --it;
+  movie_.inputs.insert(it, MovieInput{movie_.frames(), offset, buttons});
+}
+
+void MovieRecorder::RunFrame() {
+  first_pending_ =
+      QueueFrameInputs(emu_, movie_.inputs, first_pending_, movie_.frames());
+  emu_.RunFrame();
+  movie_.frame_hashes.push_back(emu_.StateHash());
+}
+
+PlaybackResult PlayMovie(Emulator& emu, const std::vector<uint8_t>& rom,
+                         const Movie& movie, bool verify,
+                         const std::function<void(uint32_t)>& on_frame) {
+  PlaybackResult result;
+  result.rom_matches = RomHash(rom) == movie.rom_hash;
+  if (!result.rom_matches) return result;
+  emu.LoadROM(rom);
+  if (!movie.start_state.empty() &&
+      !emu.LoadState(movie.start_state.data(), movie.start_state.size())) {
+    result.first_desync = 0;
+    return result;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t next_input = 0;
+  for (uint32_t frame = 0; frame < movie.frames(); ++frame) {
+    next_input = QueueFrameInputs(emu, movie.inputs, next_input, frame);
+    emu.RunFrame();
+    ++result.frames;
+    if (on_frame) on_frame(frame);
+    if (verify && emu.StateHash() != movie.frame_hashes[frame]) {
+      result.first_desync = frame;
+      break;
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+} // namespace gb
@@ -0,0 +1,130 @@
+#include "gb/rtc.h"
+
+namespace gb {
+
+namespace {
+
+// Writable bits of each register (S, M, H, DL, DH)
+constexpr std::array<uint8_t, kRtcRegisterCount> kRtcMasks = {0x3F, 0x3F,
+                                                              0x1F, 0xFF,
+                                                              0xC1};
+
+void PutLe(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+uint64_t GetLe(const uint8_t* data, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+} // namespace
+
+Rtc::Registers Rtc::Advance(Registers regs, uint64_t seconds) {
+  if (seconds == 0) return regs;
+  uint64_t s = regs[kRtcSeconds] + seconds;
+  uint64_t m = regs[kRtcMinutes] + s / 60;
+  uint64_t h = regs[kRtcHours] + m / 60;
+  uint64_t days = ((static_cast<uint64_t>(regs[kRtcDaysHigh] & 0x01) << 8) |
+                   regs[kRtcDaysLow]) +
+                  h / 24;
+  regs[kRtcSeconds] = static_cast<uint8_t>(s % 60);
+  regs[kRtcMinutes] = static_cast<uint8_t>(m % 60);
+  regs[kRtcHours] = static_cast<uint8_t>(h % 24);
+  // The 9-bit day counter sets a sticky carry bit when it overflows
+  if (days > 0x1FF) {
+    regs[kRtcDaysHigh] |= 0x80;
+    days &= 0x1FF;
+  }
+  regs[kRtcDaysLow] = static_cast<uint8_t>(days & 0xFF);
+  regs[kRtcDaysHigh] = static_cast<uint8_t>((regs[kRtcDaysHigh] & 0xFE) |
+                                            (days >> 8));
+  return regs;
+}
+
+Rtc::Registers Rtc::RegistersAt(uint64_t now) const {
+  if (halted() || now <= base_cycles_) return base_;
+  return Advance(base_, (now - base_cycles_) / kCyclesPerSecond);
+}
+
+void Rtc::Rebase(uint64_t now) {
+  if (halted() || now <= base_cycles_) return;
+  uint64_t elapsed = (now - base_cycles_) / kCyclesPerSecond;
+  base_ = Advance(base_, elapsed);
+  base_cycles_ += elapsed * kCyclesPerSecond;
+}
+
+void Rtc::Reset(uint64_t now) {
+  base_.fill(0);
+  latched_.fill(0);
+  base_cycles_ = now;
+  halt_subsecond_ = 0;
+}
+
+void Rtc::Latch(uint64_t now) { latched_ = RegistersAt(now); }
+
+void Rtc::Write(uint8_t reg, uint8_t value, uint64_t now) {
+  Rebase(now);
+  bool was_halted = halted();
+  if (!was_halted && reg == kRtcDaysHigh && (value & 0x40)) {
+    // Stopping the clock freezes the prescaler where it is
+    halt_subsecond_ = now - base_cycles_;
+  }
+  base_[reg] = value & kRtcMasks[reg];
+  if (was_halted && !halted()) {
+    base_cycles_ = now - halt_subsecond_;
+  }
+  if (reg == kRtcSeconds) {
+    // Writing the seconds register resets the sub-second prescaler
+    base_cycles_ = now;
+    halt_subsecond_ = 0;
+  }
+}
+
+void Rtc::Serialize(std::vector<uint8_t>& out, uint64_t now,
+                    int64_t unix_time) const {
+  Registers live = RegistersAt(now);
+  for (uint8_t v : live) PutLe(out, v, 4);
+  for (uint8_t v : latched_) PutLe(out, v, 4);
+  PutLe(out, static_cast<uint64_t>(unix_time), 8);
+}
+
+bool Rtc::Deserialize(const uint8_t* data, size_t size, uint64_t now,
+                      int64_t unix_time) {
+  // Some emulators write a 32-bit timestamp (44 bytes total)
+  if (size != kRtcSaveSize && size != kRtcSaveSize - 4) return false;
+  for (int i = 0; i < kRtcRegisterCount; ++i) {
+    base_[i] = static_cast<uint8_t>(GetLe(data + 4 * i, 4)) & kRtcMasks[i];
+    latched_[i] =
+        static_cast<uint8_t>(GetLe(data + 20 + 4 * i, 4)) & kRtcMasks[i];
+  }
+  int64_t saved_time = static_cast<int64_t>(GetLe(data + 40, size - 40));
+  base_cycles_ = now;
+  halt_subsecond_ = 0;
+  // Catch up on the time the cartridge spent switched off
+  if (!halted() && unix_time > saved_time) {
+    base_ = Advance(base_, static_cast<uint64_t>(unix_time - saved_time));
+  }
+  return true;
+}
+
+void Rtc::SaveState(StateWriter& w) const {
+  w.Write(base_);
+  w.Write(latched_);
+  w.Write(base_cycles_);
+  w.Write(halt_subsecond_);
+}
+
+void Rtc::LoadState(StateReader& r) {
+  r.Read(&base_);
+  r.Read(&latched_);
+  r.Read(&base_cycles_);
+  r.Read(&halt_subsecond_);
+}
+
+} // namespace gb
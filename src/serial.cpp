@@ -0,0 +1,41 @@
+#include "gb/serial.h"
+
+namespace gb {
+
+bool Serial::WriteControl(uint8_t value) {
+  sc_ = value & 0x81;
+  if (!transferring()) return false;
+  outgoing_ = sb_;
+  return true;
+}
+
+void Serial::Complete() {
+  sb_ = 0xFF; // Nothing on the other end of the cable
+  sc_ &= 0x7F;
+  if (sink_) {
+    sink_(outgoing_);
+  } else {
+    output_.push_back(static_cast<char>(outgoing_));
+  }
+}
+
+void Serial::Reset() {
+  sb_ = 0;
+  sc_ = 0;
+  outgoing_ = 0;
+  output_.clear();
+}
+
+void Serial::SaveState(StateWriter& w) const {
+  w.Write(sb_);
+  w.Write(sc_);
+  w.Write(outgoing_);
+}
+
+void Serial::LoadState(StateReader& r) {
+  r.Read(&sb_);
+  r.Read(&sc_);
+  r.Read(&outgoing_);
+}
+
+} // namespace gb
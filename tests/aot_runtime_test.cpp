@@ -0,0 +1,201 @@
+#include "gb/aot_runtime.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <initializer_list>
+#include <utility>
+
+#include "gb/cpu.h"
+#include "gb/flat_bus.h"
+
+namespace gb {
+namespace {
+
+// Every upper-nibble flag combination
+constexpr uint8_t kAllFlags[] = {0x00, 0x10, 0x20, 0x30, 0x40, 0x50,
+                                 0x60, 0x70, 0x80, 0x90, 0xA0, 0xB0,
+                                 0xC0, 0xD0, 0xE0, 0xF0};
+
+// Each aot_runtime.h helper against the interpreter handler it stands in
+// for, over every operand (or a spread of 16-bit ones) and flag state
+class AotRuntimeTest : public ::testing::Test {
+ protected:
+  void SetUp() override { cpu_.Reset(); }
+
+  void Load(std::initializer_list<uint8_t> code) {
+    uint16_t address = 0x0100;
+    for (uint8_t byte : code) bus_.Write(address++, byte);
+  }
+
+  // Run the loaded instruction from `regs` on the interpreter and
+  // `helper` on a machine; true if they leave the same registers (but
+  // PC, which the generated code sets itself)
+  template <typename Helper>
+  bool Same(Registers regs, Helper helper) {
+    regs.pc = 0x0100;
+    cpu_.set_registers(regs);
+    cpu_.StepInstruction();
+    GbAotMachine m{regs.a, regs.f, regs.b, regs.c, regs.d, regs.e,
+                   regs.h, regs.l, regs.sp, regs.pc, 0, 0, 0, &bus_,
+                   [](void* bus, uint16_t address) {
+                     return static_cast<FlatBus*>(bus)->Read(address);
+                   },
+                   [](void* bus, uint16_t address, uint8_t value) {
+                     static_cast<FlatBus*>(bus)->Write(address, value);
+                   }};
+    helper(&m);
+    Registers compiled{m.a, m.f, m.b, m.c, m.d, m.e, m.h, m.l, m.sp,
+                       cpu_.pc()};
+    return compiled == cpu_.registers();
+  }
+
+  FlatBus bus_;
+  BasicCpu<FlatBus> cpu_{bus_};
+};
+
+Registers WithA(uint8_t a, uint8_t f, uint8_t b = 0) {
+  return Registers{a, f, b, 0, 0, 0, 0, 0, 0xFFFE, 0};
+}
+
+TEST_F(AotRuntimeTest, AluMatchesTheInterpreter) {
+  for (int op = 0; op < 8; ++op) {
+    Load({static_cast<uint8_t>(0x80 | op << 3)}); // <op> A,B
+    auto helper = [op](GbAotMachine* m) {
+      switch (op) {
+        case 0: aot::Add(m, m->b, false); break;
+        case 1: aot::Add(m, m->b, true); break;
+        case 2: aot::Sub(m, m->b, false); break;
+        case 3: aot::Sub(m, m->b, true); break;
+        case 4: aot::And(m, m->b); break;
+        case 5: aot::Xor(m, m->b); break;
+        case 6: aot::Or(m, m->b); break;
+        default: aot::Cp(m, m->b); break;
+      }
+    };
+    for (int a = 0; a < 0x100; ++a) {
+      for (int b = 0; b < 0x100; ++b) {
+        for (uint8_t f : {0x00, 0xF0}) {
+          ASSERT_TRUE(Same(WithA(a, f, b), helper))
+              << "op " << op << " A=" << a << " B=" << b << " F=" << +f;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(AotRuntimeTest, IncDecAndAccumulatorOpsMatchTheInterpreter) {
+  struct Case {
+    uint8_t opcode;
+    void (*helper)(GbAotMachine*);
+  };
+  const Case cases[] = {
+      {0x04, [](GbAotMachine* m) { m->b = aot::Inc(m, m->b); }},
+      {0x05, [](GbAotMachine* m) { m->b = aot::Dec(m, m->b); }},
+      {0x27, [](GbAotMachine* m) { aot::Daa(m); }},
+      {0x2F, [](GbAotMachine* m) { aot::Cpl(m); }},
+      {0x37, [](GbAotMachine* m) { aot::Scf(m); }},
+      {0x3F, [](GbAotMachine* m) { aot::Ccf(m); }},
+      {0x07, [](GbAotMachine* m) { aot::ShiftA<0>(m); }}, // RLCA
+      {0x0F, [](GbAotMachine* m) { aot::ShiftA<1>(m); }}, // RRCA
+      {0x17, [](GbAotMachine* m) { aot::ShiftA<2>(m); }}, // RLA
+      {0x1F, [](GbAotMachine* m) { aot::ShiftA<3>(m); }}, // RRA
+  };
+  for (const Case& c : cases) {
+    Load({c.opcode});
+    for (int value = 0; value < 0x100; ++value) {
+      for (uint8_t f : kAllFlags) {
+        ASSERT_TRUE(Same(WithA(value, f, value), c.helper))
+            << "opcode " << +c.opcode << " value " << value << " F=" << +f;
+      }
+    }
+  }
+}
+
+template <int kOp>
+void ShiftB(GbAotMachine* m) {
+  m->b = aot::Shift<kOp>(m, m->b);
+}
+
+TEST_F(AotRuntimeTest, CbShiftsAndBitMatchTheInterpreter) {
+  const auto shifts = []<int... kOps>(std::integer_sequence<int, kOps...>) {
+    return std::array<void (*)(GbAotMachine*), 8>{&ShiftB<kOps>...};
+  }(std::make_integer_sequence<int, 8>{});
+  for (int op = 0; op < 8; ++op) {
+    for (int target = 0; target < 2; ++target) {
+      // Rotate/shift B, or BIT <op>,B
+      uint8_t cb = static_cast<uint8_t>((target ? 0x40 : 0x00) | op << 3);
+      Load({0xCB, cb});
+      auto bit = [op](GbAotMachine* m) {
+        aot::Bit(m, static_cast<uint8_t>(1 << op), m->b);
+      };
+      for (int value = 0; value < 0x100; ++value) {
+        for (uint8_t f : kAllFlags) {
+          bool same = target ? Same(WithA(0, f, value), bit)
+                             : Same(WithA(0, f, value), shifts[op]);
+          ASSERT_TRUE(same) << "CB " << +cb << " B=" << value << " F=" << +f;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(AotRuntimeTest, SixteenBitArithmeticMatchesTheInterpreter) {
+  // ADD HL,BC over a spread that crosses every nibble carry
+  Load({0x09});
+  auto add_hl = [](GbAotMachine* m) {
+    aot::AddHl(m, aot::Pair(m->b, m->c));
+  };
+  for (uint32_t hl = 0; hl < 0x10000; hl += 0x3B) {
+    for (uint32_t bc = 0; bc < 0x10000; bc += 0x0F0F) {
+      for (uint8_t f : {0x00, 0xF0}) {
+        Registers regs{0, f, static_cast<uint8_t>(bc >> 8),
+                       static_cast<uint8_t>(bc), 0, 0,
+                       static_cast<uint8_t>(hl >> 8),
+                       static_cast<uint8_t>(hl), 0xFFFE, 0};
+        ASSERT_TRUE(Same(regs, add_hl)) << "HL=" << hl << " BC=" << bc;
+      }
+    }
+  }
+  // ADD SP,r8 and LD HL,SP+r8 for every offset
+  for (int offset = 0; offset < 0x100; ++offset) {
+    auto r8 = static_cast<int8_t>(offset);
+    auto add_sp = [r8](GbAotMachine* m) { m->sp = aot::AddSp(m, r8); };
+    auto ld_hl = [r8](GbAotMachine* m) {
+      aot::SetPair(m->h, m->l, aot::AddSp(m, r8));
+    };
+    for (uint32_t sp = 0; sp < 0x10000; sp += 0xF1) {
+      Registers regs{0, 0xF0, 0, 0, 0, 0, 0, 0, static_cast<uint16_t>(sp),
+                     0};
+      Load({0xE8, static_cast<uint8_t>(offset)});
+      ASSERT_TRUE(Same(regs, add_sp)) << "SP=" << sp << " r8=" << +r8;
+      Load({0xF8, static_cast<uint8_t>(offset)});
+      ASSERT_TRUE(Same(regs, ld_hl)) << "SP=" << sp << " r8=" << +r8;
+    }
+  }
+}
+
+TEST_F(AotRuntimeTest, StackOpsMatchTheInterpreter) {
+  Registers regs{0x12, 0x30, 0xBE, 0xEF, 0, 0, 0, 0, 0xC100, 0};
+  Load({0xC5}); // PUSH BC: the machine's write lands on the same bytes
+  EXPECT_TRUE(Same(regs, [](GbAotMachine* m) {
+    uint16_t sp = m->sp;
+    uint8_t high = aot::Read(m, sp - 1), low = aot::Read(m, sp - 2);
+    aot::Write(m, sp - 1, 0x00);
+    aot::Write(m, sp - 2, 0x00);
+    aot::Push(m, aot::Pair(m->b, m->c));
+    EXPECT_EQ(aot::Read(m, sp - 1), high);
+    EXPECT_EQ(aot::Read(m, sp - 2), low);
+  }));
+  EXPECT_EQ(bus_.Read(0xC0FF), 0xBE);
+  EXPECT_EQ(bus_.Read(0xC0FE), 0xEF);
+  bus_.Write(0xC100, 0x34);
+  bus_.Write(0xC101, 0x12);
+  Load({0xD1}); // POP DE
+  EXPECT_TRUE(Same(regs, [](GbAotMachine* m) {
+    aot::SetPair(m->d, m->e, aot::Pop(m));
+  }));
+}
+
+} // namespace
+} // namespace gb
@@ -0,0 +1,65 @@
+#include "gb/aot.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aot_test_rom.h"
+#include "gb/emulator.h"
+#include "gb/movie.h"
+
+namespace gb {
+namespace {
+
+// The build recompiles MakeAotTestRom() into the plugin at
+// GB_AOT_TEST_PLUGIN. Put it where LoadAotPlugin() looks for `rom`'s.
+std::filesystem::path PluginDirectory(const std::vector<uint8_t>& rom) {
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "gameboy-emu-aot-test";
+  std::filesystem::create_directories(dir);
+  std::filesystem::copy_file(
+      GB_AOT_TEST_PLUGIN, dir / AotPlugin::FileName(RomHash(rom)),
+      std::filesystem::copy_options::overwrite_existing);
+  return dir;
+}
+
+TEST(Aot, CompiledBlocksMatchTheInterpreter) {
+  std::vector<uint8_t> rom = MakeAotTestRom();
+  auto plain = std::make_unique<Emulator>();
+  auto compiled = std::make_unique<Emulator>();
+  plain->LoadROM(rom);
+  compiled->LoadROM(rom);
+  std::string error;
+  ASSERT_TRUE(compiled->LoadAotPlugin(PluginDirectory(rom).string(), &error))
+      << error;
+  for (int frame = 0; frame < 60; ++frame) {
+    plain->RunFrame();
+    compiled->RunFrame();
+    ASSERT_EQ(compiled->StateHash(), plain->StateHash()) << "frame " << frame;
+  }
+  // Serial interrupts kept landing, and most of the code ran compiled
+  EXPECT_GT(compiled->mmu().serial().output().size(), 100u);
+  uint64_t instructions = compiled->cpu().aot_instructions();
+  EXPECT_GT(instructions, 100000u);
+  EXPECT_EQ(plain->cpu().aot_instructions(), 0u);
+}
+
+TEST(Aot, PluginsOnlyLoadForTheirRom) {
+  std::vector<uint8_t> rom = MakeAotTestRom();
+  rom[0x0150] ^= 1;
+  auto emu = std::make_unique<Emulator>();
+  emu->LoadROM(rom);
+  std::string error;
+  EXPECT_FALSE(emu->LoadAotPlugin("/nonexistent", &error));
+  EXPECT_FALSE(error.empty());
+  // Even under this ROM's name, the plugin knows what it was built from
+  EXPECT_FALSE(emu->LoadAotPlugin(PluginDirectory(rom).string(), &error));
+  EXPECT_NE(error.find("another ROM"), std::string::npos) << error;
+  EXPECT_EQ(emu->aot_plugin(), nullptr);
+}
+
+} // namespace
+} // namespace gb
@@ -0,0 +1,21 @@
+// Writes the AOT test ROM (aot_test_rom.h) for the build to recompile.
+//
+//   gameboy-emu-aot-test-rom <out.gb>
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "aot_test_rom.h"
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <out.gb>\n";
+    return 2;
+  }
+  std::vector<uint8_t> rom = gb::MakeAotTestRom();
+  std::ofstream out(argv[1], std::ios::binary);
+  out.write(reinterpret_cast<const char*>(rom.data()),
+            static_cast<std::streamsize>(rom.size()));
+  return out ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace gb {
+
+// Deterministic pseudo-random program for checking AOT-compiled code
+// against the interpreter. An MBC1 cartridge whose main loop calls
+// random functions in bank 0 and in banks 1-3 (through a jump table at
+// 0x4000), one reached only through JP HL, and a RET it writes to RAM,
+// then HALTs. The functions mix register and memory instructions with
+// forward branches, calls, RSTs, PUSH/POP, ADD SP, DI/EI, counted loops
+// and a copy loop. A serial transfer kept running by its interrupt
+// handler keeps interrupts landing all over the code. Memory accesses
+// stay in WRAM and HRAM, so the program never leaves its own code.
+// tests/aot_test_rom.cpp writes it out for gameboy-emu-recompile.
+class AotTestRomBuilder {
+ public:
+  static std::vector<uint8_t> Build() { return AotTestRomBuilder().rom_; }
+
+ private:
+  static constexpr size_t kBanks = 4;
+  static constexpr uint16_t kLoopCounter = 0xFFFE; // HRAM
+
+  AotTestRomBuilder() : rom_(kBanks * 0x4000, 0x00) {
+    rom_[0x0147] = 0x01; // MBC1
+    rom_[0x0148] = 0x01; // 64 KiB
+    for (uint16_t vector = 0; vector < 0x40; vector += 8) rom_[vector] = 0xC9;
+    for (uint16_t vector = 0x40; vector <= 0x60; vector += 8) {
+      rom_[vector] = 0xD9; // RETI
+    }
+    // Serial: start the next transfer
+    At(0, 0x0058);
+    Emit({0xF5, 0x3E, 0x81, 0xE0, 0x02, 0xF1, 0xD9});
+    At(0, 0x0100);
+    Emit({0x00, 0xC3, 0x50, 0x01}); // NOP; JP 0x0150
+
+    At(0, 0x0200);
+    for (uint16_t& leaf : leaves_) {
+      leaf = here_;
+      for (uint32_t i = Next(4); i > 0; --i) RegisterOp();
+      Emit({0xC9});
+    }
+    trampoline_ = here_;
+    Emit({0xE9}); // JP HL
+    hidden_ = here_;
+    Function();
+    std::vector<uint16_t> functions;
+    for (int i = 0; i < 6; ++i) {
+      functions.push_back(here_);
+      Function();
+    }
+    for (size_t bank = 1; bank < kBanks; ++bank) {
+      // Jump table, then the functions it points at
+      At(bank, 0x4000);
+      for (int i = 0; i < 3; ++i) Emit({0xC3, 0x00, 0x00});
+      for (int i = 0; i < 3; ++i) {
+        Patch16(bank * 0x4000 + 3 * i + 1, here_);
+        Function();
+      }
+    }
+
+    At(0, 0x0150);
+    Emit({0x31, 0xF0, 0xDF});       // LD SP,0xDFF0
+    Emit({0x3E, 0x08, 0xE0, 0xFF}); // IE = serial
+    Emit({0x3E, 0x81, 0xE0, 0x02}); // Start a transfer
+    Emit({0xFB});                   // EI
+    uint16_t loop = here_;
+    for (uint16_t function : functions) Call(function);
+    for (uint8_t bank = 1; bank < kBanks; ++bank) {
+      Emit({0x3E, bank, 0xEA, 0x00, 0x20}); // LD A,bank; LD (0x2000),A
+      for (uint16_t i = 0; i < 3; ++i) Call(0x4000 + 3 * i);
+    }
+    Emit({0x21, Low(hidden_), High(hidden_)}); // LD HL,hidden
+    Call(trampoline_);
+    Emit({0x3E, 0xC9, 0xEA, 0x00, 0xD0}); // LD A,RET; LD (0xD000),A
+    Call(0xD000);
+    Emit({0x76, 0x00});                       // HALT; NOP
+    Emit({0xC3, Low(loop), High(loop)});      // JP loop
+  }
+
+  static uint8_t Low(uint16_t word) { return static_cast<uint8_t>(word); }
+  static uint8_t High(uint16_t word) { return static_cast<uint8_t>(word >> 8); }
+
+  // splitmix64
+  uint32_t Next(uint32_t bound) {
+    state_ += 0x9E3779B97F4A7C15ull;
+    uint64_t z = state_;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<uint32_t>((z ^ (z >> 31)) % bound);
+  }
+  uint8_t Byte() { return static_cast<uint8_t>(Next(256)); }
+
+  void At(size_t bank, uint16_t address) {
+    bank_ = bank;
+    here_ = address;
+  }
+  size_t Offset(uint16_t address) const {
+    return address < 0x4000 ? address : bank_ * 0x4000 + address - 0x4000;
+  }
+  void Emit(std::initializer_list<uint8_t> bytes) {
+    for (uint8_t byte : bytes) rom_[Offset(here_++)] = byte;
+  }
+  void Patch16(size_t offset, uint16_t word) {
+    rom_[offset] = Low(word);
+    rom_[offset + 1] = High(word);
+  }
+  void Call(uint16_t target) { Emit({0xCD, Low(target), High(target)}); }
+
+  // A register field other than (HL)
+  uint32_t Register() {
+    uint32_t r = Next(7);
+    return r == 6 ? 7 : r;
+  }
+
+  // An instruction that only touches registers (and HL, which memory
+  // operations set up for themselves)
+  void RegisterOp() {
+    switch (Next(8)) {
+      case 0: {
+        auto op = static_cast<uint8_t>(0x40 | Register() << 3 | Register());
+        Emit({op == 0x40 ? uint8_t{0x41} : op}); // LD B,B is a breakpoint
+        break;
+      }
+      case 1:
+        Emit({static_cast<uint8_t>(0x80 | Next(8) << 3 | Register())});
+        break;
+      case 2:
+        Emit({static_cast<uint8_t>(0xC6 | Next(8) << 3), Byte()});
+        break;
+      case 3:
+        Emit({static_cast<uint8_t>(Register() << 3 | (4 + Next(2)))});
+        break;
+      case 4:
+        Emit({static_cast<uint8_t>(Register() << 3 | 6), Byte()});
+        break;
+      case 5: {
+        // Rotates, DAA, CPL, SCF, CCF; INC/DEC rr and ADD HL,rr (bar SP)
+        static const uint8_t kOps[] = {0x07, 0x0F, 0x17, 0x1F, 0x27, 0x2F,
+                                       0x37, 0x3F, 0x03, 0x0B, 0x13, 0x1B,
+                                       0x23, 0x2B, 0x09, 0x19, 0x29, 0x39};
+        Emit({kOps[Next(sizeof(kOps))]});
+        break;
+      }
+      case 6: {
+        uint8_t cb = Byte();
+        Emit({0xCB, (cb & 7) == 6 ? static_cast<uint8_t>(cb | 7) : cb});
+        break;
+      }
+      default:
+        // ADD/SUB d8 then DAA; LD HL,SP+r8
+        if (Next(3)) {
+          Emit({Next(2) ? uint8_t{0xC6} : uint8_t{0xD6}, Byte(), 0x27});
+        } else {
+          Emit({0xF8, Byte()});
+        }
+        break;
+    }
+  }
+
+  // An instruction that reads or writes WRAM or HRAM, with the address
+  // it uses loaded first
+  void MemoryOp() {
+    uint16_t wram = static_cast<uint16_t>(0xC000 + Next(0x800));
+    auto hram = static_cast<uint8_t>(0x80 + Next(0x7E));
+    switch (Next(6)) {
+      case 0: {
+        Emit({0x21, Low(wram), High(wram)}); // LD HL,wram
+        static const uint8_t kOps[] = {0x34, 0x35, 0x22, 0x32, 0x2A, 0x3A};
+        switch (Next(6)) {
+          case 0:
+            Emit({static_cast<uint8_t>(0x70 | Register())});
+            break;
+          case 1:
+            Emit({static_cast<uint8_t>(0x46 | Register() << 3)});
+            break;
+          case 2:
+            Emit({static_cast<uint8_t>(0x86 | Next(8) << 3)});
+            break;
+          case 3:
+            Emit({0xCB, static_cast<uint8_t>((Byte() & 0xF8) | 6)});
+            break;
+          case 4:
+            Emit({0x36, Byte()});
+            break;
+          default:
+            Emit({kOps[Next(sizeof(kOps))]});
+            break;
+        }
+        break;
+      }
+      case 1: {
+        // Through BC or DE
+        uint8_t pair = Next(2) ? 0x10 : 0x00;
+        Emit({static_cast<uint8_t>(0x01 | pair), Low(wram), High(wram),
+              static_cast<uint8_t>((Next(2) ? 0x02 : 0x0A) | pair)});
+        break;
+      }
+      case 2:
+        Emit({Next(2) ? uint8_t{0xE0} : uint8_t{0xF0}, hram});
+        break;
+      case 3:
+        Emit({0x0E, hram, Next(2) ? uint8_t{0xE2} : uint8_t{0xF2}});
+        break;
+      case 4: {
+        static const uint8_t kOps[] = {0xEA, 0xFA, 0x08};
+        Emit({kOps[Next(3)], Low(wram), High(wram)});
+        break;
+      }
+      default:
+        // PUSH one pair, POP another
+        Emit({static_cast<uint8_t>(0xC5 | Next(4) << 4),
+              static_cast<uint8_t>(0xC1 | Next(4) << 4)});
+        break;
+    }
+  }
+
+  void StraightOp() {
+    if (Next(5) < 3) {
+      RegisterOp();
+    } else {
+      MemoryOp();
+    }
+  }
+
+  // A run of straight-line instructions JR or JP cc jumps over
+  void SkippedOps(bool relative) {
+    auto condition = static_cast<uint8_t>(Next(4) << 3);
+    uint16_t patch = here_;
+    if (relative) {
+      Emit({static_cast<uint8_t>(0x20 | condition), 0x00});
+    } else {
+      Emit({static_cast<uint8_t>(0xC2 | condition), 0x00, 0x00});
+    }
+    for (uint32_t i = Next(4) + 1; i > 0; --i) StraightOp();
+    if (relative) {
+      rom_[Offset(patch + 1)] = static_cast<uint8_t>(here_ - (patch + 2));
+    } else {
+      Patch16(Offset(patch + 1), here_);
+    }
+  }
+
+  void Function() {
+    for (uint32_t item = 20 + Next(20); item > 0; --item) {
+      switch (Next(16)) {
+        case 0:
+        case 1:
+          SkippedOps(Next(3) != 0);
+          break;
+        case 2: {
+          uint16_t leaf = leaves_[Next(2)];
+          if (Next(2)) {
+            Call(leaf);
+          } else {
+            Emit({static_cast<uint8_t>(0xC4 | Next(4) << 3), Low(leaf),
+                  High(leaf)});
+          }
+          break;
+        }
+        case 3:
+          // RST to a RET; RET cc
+          if (Next(4)) {
+            Emit({static_cast<uint8_t>(0xC7 | Next(8) << 3)});
+          } else {
+            Emit({static_cast<uint8_t>(0xC0 | Next(4) << 3)});
+          }
+          break;
+        case 4: {
+          // Counted loop, the count kept in HRAM
+          Emit({0x3E, static_cast<uint8_t>(1 + Next(6)), 0xE0,
+                Low(kLoopCounter)});
+          uint16_t head = here_;
+          for (uint32_t i = Next(4) + 1; i > 0; --i) StraightOp();
+          Emit({0xF0, Low(kLoopCounter), 0x3D, 0xE0, Low(kLoopCounter)});
+          Emit({0x20, static_cast<uint8_t>(head - (here_ + 2))});
+          break;
+        }
+        case 5: {
+          // Copy loop from the low half of WRAM to the high half
+          auto from = static_cast<uint16_t>(0xC000 + Next(0x400));
+          auto to = static_cast<uint16_t>(0xC800 + Next(0x400));
+          Emit({0x21, Low(from), High(from), 0x11, Low(to), High(to), 0x06,
+                static_cast<uint8_t>(1 + Next(64))});
+          Emit({0x2A, 0x12, 0x13, 0x05, 0x20, 0xFA});
+          break;
+        }
+        case 6:
+          // ADD SP,-2 around an instruction, or DI/EI
+          if (Next(2)) {
+            Emit({0xE8, 0xFE});
+            RegisterOp();
+            Emit({0xE8, 0x02});
+          } else {
+            Emit({0xF3});
+            StraightOp();
+            Emit({0xFB});
+          }
+          break;
+        default:
+          StraightOp();
+          break;
+      }
+    }
+    Emit({0xC9});
+  }
+
+  std::vector<uint8_t> rom_;
+  uint64_t state_ = 0x2545F4914F6CDD1Dull;
+  size_t bank_ = 0;
+  uint16_t here_ = 0;
+  uint16_t leaves_[2] = {};
+  uint16_t trampoline_ = 0;
+  uint16_t hidden_ = 0;
+};
+
+inline std::vector<uint8_t> MakeAotTestRom() {
+  return AotTestRomBuilder::Build();
+}
+
+} // namespace gb
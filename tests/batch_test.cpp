@@ -0,0 +1,56 @@
+#include "gb/batch.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace gb {
+namespace {
+
+// Each instance stores its own id at 0xC000 and then spins
+std::vector<uint8_t> StoreIdRom(uint8_t id) {
+  std::vector<uint8_t> rom(2 * kBankSize, 0x00);
+  const uint8_t code[] = {0x3E, id,         // LD A,id
+                          0xEA, 0x00, 0xC0, // LD (0xC000),A
+                          0x18, 0xFE};      // JR -2
+  std::copy(std::begin(code), std::end(code), rom.begin() + 0x0100);
+  return rom;
+}
+
+TEST(BatchRunner, StepsEveryInstanceOneFrame) {
+  constexpr size_t kCount = 37; // Not a multiple of the worker count
+  std::vector<std::unique_ptr<Emulator>> owned;
+  std::vector<Emulator*> emus;
+  for (size_t i = 0; i < kCount; ++i) {
+    owned.push_back(std::make_unique<Emulator>());
+    owned.back()->LoadROM(StoreIdRom(static_cast<uint8_t>(i)));
+    emus.push_back(owned.back().get());
+  }
+
+  BatchRunner runner(4, /*pin=*/false);
+  std::vector<uint8_t> frames(kCount * kFrameBytes, 0xAA);
+  runner.RunFrame(emus.data(), emus.size(), frames.data());
+  runner.RunFrame(emus.data(), emus.size(), nullptr);
+
+  for (size_t i = 0; i < kCount; ++i) {
+    EXPECT_EQ(emus[i]->frame_count(), 2u);
+    EXPECT_EQ(emus[i]->mmu().Read(0xC000), i);
+  }
+  // Every slot of the tensor was overwritten with a (blank) frame
+  for (uint8_t pixel : frames) ASSERT_EQ(pixel, 0);
+}
+
+TEST(BatchRunner, HandlesFewerInstancesThanWorkers) {
+  Emulator emu;
+  emu.LoadROM(StoreIdRom(7));
+  Emulator* emus[] = {&emu};
+  BatchRunner runner(8);
+  runner.RunFrame(emus, 1, nullptr);
+  runner.RunFrame(emus, 0, nullptr);
+  EXPECT_EQ(emu.frame_count(), 1u);
+  EXPECT_EQ(emu.mmu().Read(0xC000), 7);
+}
+
+} // namespace
+} // namespace gb
@@ -2,20 +2,23 @@
 
 #include <gtest/gtest.h>
 
-#include "gb/mmu.h"
+#include "gb/flat_bus.h"
 
 namespace gb {
 namespace {
 
+// Runs the CPU on flat RAM so test code can be written anywhere, ROM
+// addresses included, without MMU side effects such as MBC writes
 class CpuTest : public ::testing::Test {
  protected:
   void SetUp() override {
-    // Reset both MMU and CPU to a known state
-    gb::MMU::Instance().Reset();
     cpu_.Reset();
+    // One instruction per Step()
+    cpu_.set_skip_dead_flags(false);
   }
 
-  CPU cpu_;
+  FlatBus bus_;
+  BasicCpu<FlatBus> cpu_{bus_};
 };
 
 // Verify Reset() puts the CPU into the correct initial state.
@@ -36,8 +39,7 @@ TEST_F(CpuTest, ResetInitializesRegistersAndFlags) {
 
 // Writing a NOP (0x00) at 0x0100 and stepping should simply increment PC.
 TEST_F(CpuTest, StepExecutesNopAndIncrementsPc) {
-  auto& mmu = MMU::Instance();
-  mmu.Write(0x0100, 0x00);
+  bus_.Write(0x0100, 0x00);
 
   uint16_t before = cpu_.pc();
   cpu_.Step();
@@ -46,9 +48,8 @@ TEST_F(CpuTest, StepExecutesNopAndIncrementsPc) {
 
 // Even unknown opcodes should advance PC by 1 (and not crash).
 TEST_F(CpuTest, StepUnknownOpcodeStillAdvancesPc) {
-  auto& mmu = MMU::Instance();
-  const uint8_t kInvalid = 0xFF;
-  mmu.Write(0x0100, kInvalid);
+  const uint8_t kInvalid = 0xD3; // Unused on the SM83 (0xFF is RST 38H)
+  bus_.Write(0x0100, kInvalid);
 
   uint16_t before = cpu_.pc();
   EXPECT_NO_FATAL_FAILURE(cpu_.Step());
@@ -58,10 +59,9 @@ TEST_F(CpuTest, StepUnknownOpcodeStillAdvancesPc) {
 // You can add more opcode‐specific tests as you implement them.
 // e.g. LD A, d8 (0x3E): load immediate into A, pc should advance by 2
 TEST_F(CpuTest, LdAImmediateLoadsAndAdvancesPc) {
-  auto& mmu = MMU::Instance();
   // Opcode 0x3E, immediate value 0x42
-  mmu.Write(0x0100, 0x3E);
-  mmu.Write(0x0101, 0x42);
+  bus_.Write(0x0100, 0x3E);
+  bus_.Write(0x0101, 0x42);
 
   uint16_t before = cpu_.pc();
   cpu_.Step();
@@ -70,5 +70,60 @@ TEST_F(CpuTest, LdAImmediateLoadsAndAdvancesPc) {
   EXPECT_EQ(cpu_.pc(), before + 2);
 }
 
+// BIT sets Z from the tested bit, clears N, sets H and keeps C
+TEST_F(CpuTest, CbBitTestsOneBitAndKeepsCarry) {
+  const uint8_t code[] = {0x06, 0x80,  // LD B,0x80
+                          0x37,        // SCF
+                          0xCB, 0x78,  // BIT 7,B
+                          0xCB, 0x70}; // BIT 6,B
+  for (size_t i = 0; i < sizeof(code); ++i) bus_.Write(0x0100 + i, code[i]);
+  for (int i = 0; i < 3; ++i) cpu_.Step();
+  EXPECT_EQ(cpu_.f(), kHalfCarryFlagMask | kCarryFlagMask);
+  cpu_.Step();
+  EXPECT_EQ(cpu_.f(), kZeroFlagMask | kHalfCarryFlagMask | kCarryFlagMask);
+  EXPECT_EQ(cpu_.b(), 0x80);
+  EXPECT_EQ(cpu_.pc(), 0x0107);
+}
+
+// RES/SET work on registers and on memory through (HL)
+TEST_F(CpuTest, CbResAndSetModifyRegistersAndMemory) {
+  const uint8_t code[] = {0x21, 0x00, 0xC0,  // LD HL,0xC000
+                          0xCB, 0xDE,        // SET 3,(HL)
+                          0xCB, 0xFF,        // SET 7,A
+                          0xCB, 0x87,        // RES 0,A
+                          0xCB, 0x86};       // RES 0,(HL)
+  for (size_t i = 0; i < sizeof(code); ++i) bus_.Write(0x0100 + i, code[i]);
+  cpu_.set_registers(Registers{0x01, 0, 0, 0, 0, 0, 0, 0, 0xFFFE, 0x0100});
+  bus_.Write(0xC000, 0x01);
+  for (int i = 0; i < 5; ++i) cpu_.Step();
+  EXPECT_EQ(cpu_.a(), 0x80);
+  EXPECT_EQ(bus_.Read(0xC000), 0x08);
+  EXPECT_EQ(cpu_.f(), 0); // RES/SET leave flags alone
+}
+
+// Rotates and shifts set Z from the result and C from the bit shifted out
+TEST_F(CpuTest, CbRotatesAndShiftsSetZeroAndCarry) {
+  const uint8_t code[] = {0xCB, 0x11,  // RL C    (C flag in, bit 7 out)
+                          0xCB, 0x28,  // SRA B   (sign kept)
+                          0xCB, 0x32,  // SWAP D
+                          0xCB, 0x3B}; // SRL E
+  for (size_t i = 0; i < sizeof(code); ++i) bus_.Write(0x0100 + i, code[i]);
+  cpu_.set_registers(
+      Registers{0, kCarryFlagMask, 0x81, 0x80, 0xA5, 0x01, 0, 0, 0xFFFE,
+                0x0100});
+  cpu_.Step();
+  EXPECT_EQ(cpu_.c(), 0x01);
+  EXPECT_EQ(cpu_.f(), kCarryFlagMask);
+  cpu_.Step();
+  EXPECT_EQ(cpu_.b(), 0xC0);
+  EXPECT_EQ(cpu_.f(), kCarryFlagMask);
+  cpu_.Step();
+  EXPECT_EQ(cpu_.d(), 0x5A);
+  EXPECT_EQ(cpu_.f(), 0);
+  cpu_.Step();
+  EXPECT_EQ(cpu_.e(), 0x00);
+  EXPECT_EQ(cpu_.f(), kZeroFlagMask | kCarryFlagMask);
+}
+
 } // namespace
-} // namespace gb
\ No newline at end of file
+} // namespace gb
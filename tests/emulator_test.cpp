@@ -0,0 +1,532 @@
+#include "gb/emulator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace gb {
+namespace {
+
+// ROM-only cartridge with `code` placed at the 0x0100 entry point
+std::vector<uint8_t> MakeRom(const std::vector<uint8_t>& code) {
+  std::vector<uint8_t> rom(2 * kBankSize, 0x00);
+  std::copy(code.begin(), code.end(), rom.begin() + 0x0100);
+  return rom;
+}
+
+TEST(Emulator, RunFrameAdvancesOneFrameOfCycles) {
+  Emulator emu;
+  emu.LoadROM(MakeRom({0x18, 0xFE})); // JR -2
+  uint64_t start = emu.mmu().cycles();
+  emu.RunFrame();
+  EXPECT_EQ(emu.frame_count(), 1u);
+  EXPECT_GE(emu.mmu().cycles() - start, kCyclesPerFrame);
+  emu.RunFrame();
+  EXPECT_GE(emu.mmu().cycles() - start, 2 * kCyclesPerFrame);
+}
+
+TEST(Emulator, CapturesSerialOutput) {
+  std::vector<uint8_t> code;
+  for (char c : std::string("Passed")) {
+    code.insert(code.end(), {0x3E, static_cast<uint8_t>(c), // LD A,c
+                             0xE0, 0x01,                    // LDH (SB),A
+                             0x3E, 0x81,                    // LD A,0x81
+                             0xE0, 0x02,                    // LDH (SC),A
+                             0xF0, 0x02,                    // LDH A,(SC)
+                             0xE6, 0x80,                    // AND 0x80
+                             0x20, 0xFA});                  // JR NZ,-6
+  }
+  code.insert(code.end(), {0x18, 0xFE}); // JR -2
+  Emulator emu;
+  emu.LoadROM(MakeRom(code));
+  emu.RunFrame();
+  EXPECT_EQ(emu.mmu().serial().output(), "Passed");
+}
+
+TEST(Emulator, SerialTransferTakesOneByteTimeAndRaisesInterrupt) {
+  Emulator emu;
+  emu.LoadROM(MakeRom({0x18, 0xFE}));
+  MMU& mmu = emu.mmu();
+  mmu.Write(0xFF01, 'x');
+  mmu.Write(0xFF02, 0x81);
+  EXPECT_EQ(mmu.Read(0xFF02), 0xFF); // Transfer in progress
+
+  mmu.Tick(Serial::kCyclesPerByte - 4);
+  EXPECT_EQ(mmu.Read(0xFF02) & 0x80, 0x80);
+  EXPECT_EQ(mmu.Read(kIfAddress) & InterruptMask(Interrupt::Serial), 0);
+
+  mmu.Tick(4);
+  EXPECT_EQ(mmu.Read(0xFF02), 0x7F);
+  EXPECT_EQ(mmu.Read(0xFF01), 0xFF);
+  EXPECT_NE(mmu.Read(kIfAddress) & InterruptMask(Interrupt::Serial), 0);
+  EXPECT_EQ(mmu.serial().output(), "x");
+}
+
+TEST(Emulator, SerialSinkCanStopTheFrame) {
+  std::vector<uint8_t> code = {0x3E, 'P',  // LD A,'P'
+                               0xE0, 0x01, // LDH (SB),A
+                               0x3E, 0x81, // LD A,0x81
+                               0xE0, 0x02, // LDH (SC),A
+                               0x18, 0xFE};
+  Emulator emu;
+  emu.LoadROM(MakeRom(code));
+  std::string seen;
+  emu.mmu().serial().set_sink([&](uint8_t byte) {
+    seen.push_back(static_cast<char>(byte));
+    emu.Stop();
+  });
+  uint64_t start = emu.mmu().cycles();
+  emu.RunFrame();
+  EXPECT_EQ(seen, "P");
+  EXPECT_TRUE(emu.stopped());
+  EXPECT_EQ(emu.frame_count(), 0u);
+  EXPECT_LT(emu.mmu().cycles() - start, Serial::kCyclesPerByte + 64);
+  EXPECT_TRUE(emu.mmu().serial().output().empty());
+}
+
+TEST(Emulator, LdBBSetsBreakpoint) {
+  Emulator emu;
+  emu.LoadROM(MakeRom({0x06, 0x03, 0x40, 0x18, 0xFE})); // LD B,3; LD B,B
+  emu.RunFrame();
+  EXPECT_TRUE(emu.cpu().breakpoint());
+  EXPECT_EQ(emu.cpu().b(), 3);
+}
+
+TEST(Emulator, CanStopOnBreakpoint) {
+  Emulator emu;
+  emu.LoadROM(MakeRom({0x06, 0x03,    // LD B,3
+                       0x40,          // LD B,B
+                       0x06, 0x04,    // LD B,4
+                       0x18, 0xFE})); // JR -2
+  emu.set_stop_on_breakpoint(true);
+  EXPECT_FALSE(emu.RunFrameFor(1000));
+  EXPECT_TRUE(emu.cpu().breakpoint());
+  EXPECT_EQ(emu.cpu().b(), 3);
+  EXPECT_EQ(emu.frame_count(), 0u);
+}
+
+TEST(Emulator, RunsTheCpuBuiltForTheCartridgesMapper) {
+  // MBC1 cartridge: select ROM bank 2 and read its first byte
+  std::vector<uint8_t> mbc1 = MakeRom({0x3E, 0x02,       // LD A,2
+                                       0xEA, 0x00, 0x20, // LD (0x2000),A
+                                       0xFA, 0x00, 0x40, // LD A,(0x4000)
+                                       0x47,             // LD B,A
+                                       0x40,             // LD B,B
+                                       0x18, 0xFE});     // JR -2
+  mbc1.resize(4 * kBankSize, 0x00);
+  mbc1[0x0147] = 0x01;
+  mbc1[2 * kBankSize] = 0x42;
+
+  Emulator emu;
+  emu.cpu().set_superinstructions(false);
+  emu.LoadROM(mbc1);
+  EXPECT_EQ(emu.mmu().mbc_type(), MbcType::kMbc1);
+  emu.RunFrame();
+  EXPECT_TRUE(emu.cpu().breakpoint());
+  EXPECT_EQ(emu.cpu().b(), 0x42);
+
+  // Switching CPUs between carts keeps the options and the clock
+  uint64_t cycles = emu.cpu().cycles();
+  emu.LoadROM(MakeRom({0x18, 0xFE}));
+  EXPECT_FALSE(emu.cpu().superinstructions());
+  EXPECT_EQ(emu.cpu().cycles(), cycles);
+  EXPECT_FALSE(emu.cpu().breakpoint());
+  emu.RunFrame();
+  EXPECT_EQ(emu.frame_count(), 1u);
+}
+
+TEST(Emulator, InstancesAreIndependent) {
+  Emulator a, b;
+  a.LoadROM(MakeRom({0x3E, 0x11, 0xEA, 0x00, 0xC0, 0x18, 0xFE}));
+  b.LoadROM(MakeRom({0x3E, 0x22, 0xEA, 0x00, 0xC0, 0x18, 0xFE}));
+  a.RunFrame();
+  b.RunFrame();
+  EXPECT_EQ(a.mmu().Read(0xC000), 0x11);
+  EXPECT_EQ(b.mmu().Read(0xC000), 0x22);
+}
+
+// Polls SC until each serial byte is out, then spins on JR -2
+std::vector<uint8_t> SerialPollRom() {
+  std::vector<uint8_t> code;
+  for (char c : std::string("idle")) {
+    code.insert(code.end(), {0x3E, static_cast<uint8_t>(c), // LD A,c
+                             0xE0, 0x01,                    // LDH (SB),A
+                             0x3E, 0x81,                    // LD A,0x81
+                             0xE0, 0x02,                    // LDH (SC),A
+                             0xF0, 0x02,                    // LDH A,(SC)
+                             0xE6, 0x80,                    // AND 0x80
+                             0x20, 0xFA});                  // JR NZ,-6
+  }
+  code.insert(code.end(), {0x18, 0xFE}); // JR -2
+  return MakeRom(code);
+}
+
+TEST(Emulator, IdleLoopSkipLeavesTheMachineUnchanged) {
+  Emulator fast, slow;
+  fast.LoadROM(SerialPollRom());
+  slow.LoadROM(SerialPollRom());
+  slow.cpu().set_idle_skip(false);
+  for (int frame = 0; frame < 3; ++frame) {
+    fast.RunFrame();
+    slow.RunFrame();
+    ASSERT_EQ(fast.StateHash(), slow.StateHash()) << "frame " << frame;
+  }
+  EXPECT_EQ(fast.mmu().cycles(), slow.mmu().cycles());
+  EXPECT_EQ(fast.mmu().serial().output(), "idle");
+  EXPECT_EQ(slow.cpu().skipped_cycles(), 0u);
+  // Nearly all of the second and third frames is the final JR -2
+  EXPECT_GT(fast.cpu().skipped_cycles(), 2u * kCyclesPerFrame - 1000);
+}
+
+TEST(Emulator, HaltFastForwardsToTheWakingEvent) {
+  // Enable the serial interrupt, start a transfer and HALT until it ends
+  std::vector<uint8_t> rom = MakeRom({0x3E, 0x08,       // LD A,0x08
+                                      0xE0, 0xFF,       // LDH (IE),A
+                                      0x3E, 'h',        // LD A,'h'
+                                      0xE0, 0x01,       // LDH (SB),A
+                                      0x3E, 0x81,       // LD A,0x81
+                                      0xE0, 0x02,       // LDH (SC),A
+                                      0xFB,             // EI
+                                      0x76,             // HALT
+                                      0xEA, 0x00, 0xC0, // LD (0xC000),A
+                                      0x76});           // HALT
+  rom[0x58] = 0xD9; // RETI
+  Emulator fast, slow;
+  fast.LoadROM(rom);
+  slow.LoadROM(rom);
+  slow.cpu().set_idle_skip(false);
+  for (int frame = 0; frame < 2; ++frame) {
+    fast.RunFrame();
+    slow.RunFrame();
+    ASSERT_EQ(fast.StateHash(), slow.StateHash()) << "frame " << frame;
+  }
+  EXPECT_EQ(fast.mmu().Read(0xC000), 0x81);
+  EXPECT_EQ(fast.mmu().serial().output(), "h");
+  EXPECT_EQ(slow.cpu().skipped_cycles(), 0u);
+  EXPECT_GT(fast.cpu().skipped_cycles(),
+            2u * kCyclesPerFrame - Serial::kCyclesPerByte);
+}
+
+TEST(Emulator, SuperinstructionsKeepInterruptTiming) {
+  // A copy loop made of fused pairs, interrupted by a serial transfer
+  std::vector<uint8_t> rom = MakeRom({0x3E, 0x08,       // LD A,0x08
+                                      0xE0, 0xFF,       // LDH (IE),A
+                                      0x3E, 'f',        // LD A,'f'
+                                      0xE0, 0x01,       // LDH (SB),A
+                                      0x3E, 0x81,       // LD A,0x81
+                                      0xE0, 0x02,       // LDH (SC),A
+                                      0xFB,             // EI
+                                      0x21, 0x00, 0x02, // LD HL,0x0200
+                                      0x11, 0x00, 0xC0, // LD DE,0xC000
+                                      0x06, 0xFF,       // LD B,255
+                                      0x2A,             // LD A,(HL+)
+                                      0x12,             // LD (DE),A
+                                      0x13,             // INC DE
+                                      0x05,             // DEC B
+                                      0x20, 0xFA,       // JR NZ,-6
+                                      0x18, 0xFE});     // JR -2
+  rom[0x58] = 0xD9; // RETI
+  for (int i = 0; i < 0x100; ++i) rom[0x200 + i] = static_cast<uint8_t>(~i);
+  Emulator fused, plain;
+  fused.LoadROM(rom);
+  plain.LoadROM(rom);
+  for (Emulator* emu : {&fused, &plain}) {
+    emu->cpu().set_idle_skip(false);
+    emu->cpu().set_bulk_loops(false);
+  }
+  plain.cpu().set_superinstructions(false);
+  for (int frame = 0; frame < 2; ++frame) {
+    fused.RunFrame();
+    plain.RunFrame();
+    ASSERT_EQ(fused.StateHash(), plain.StateHash()) << "frame " << frame;
+  }
+  EXPECT_EQ(fused.mmu().Read(0xC0FE), static_cast<uint8_t>(~0xFE));
+  EXPECT_EQ(plain.cpu().fused_pairs(), 0u);
+  // Both pairs of (nearly) every iteration
+  EXPECT_GE(fused.cpu().fused_pairs(), 2u * 250);
+
+  // A fused pair whose second half starts the transfer, timed by a
+  // polling loop whose count lands in B
+  rom = MakeRom({0x21, 0x00, 0x02, // LD HL,0x0200
+                 0x11, 0x02, 0xFF, // LD DE,SC
+                 0x06, 0x00,       // LD B,0
+                 0x2A,             // loop: LD A,(HL+)
+                 0x12,             // LD (DE),A
+                 0x0E, 0x00,       // LD C,0
+                 0x0C,             // wait: INC C
+                 0xF0, 0x0F,       // LDH A,(IF)
+                 0xE6, 0x08,       // AND 0x08
+                 0x28, 0xF9,       // JR Z,wait
+                 0xAF,             // XOR A
+                 0xE0, 0x0F,       // LDH (IF),A
+                 0x79,             // LD A,C
+                 0x80,             // ADD A,B
+                 0x47,             // LD B,A
+                 0x18, 0xED});     // JR loop
+  std::fill(rom.begin() + 0x200, rom.begin() + 0x300, 0x81);
+  Emulator fused_sc, plain_sc;
+  fused_sc.LoadROM(rom);
+  plain_sc.LoadROM(rom);
+  plain_sc.cpu().set_superinstructions(false);
+  for (int frame = 0; frame < 3; ++frame) {
+    fused_sc.RunFrame();
+    plain_sc.RunFrame();
+    ASSERT_EQ(fused_sc.cpu().registers(), plain_sc.cpu().registers());
+    ASSERT_EQ(fused_sc.StateHash(), plain_sc.StateHash()) << "frame " << frame;
+  }
+  EXPECT_GT(fused_sc.cpu().fused_pairs(), 40u);
+}
+
+TEST(Emulator, SkippedFlagsStayInvisibleToInterrupts) {
+  // ALU blocks with dead flags, interrupted by serial transfers whose
+  // handler pushes AF (and restarts the transfer)
+  std::vector<uint8_t> rom = MakeRom({0x3E, 0x08, // LD A,0x08
+                                      0xE0, 0xFF, // LDH (IE),A
+                                      0x3E, 0x81, // LD A,0x81
+                                      0xE0, 0x02, // LDH (SC),A
+                                      0xFB,       // EI
+                                      0x80,       // loop: ADD A,B
+                                      0xA9,       // XOR C
+                                      0x04,       // INC B
+                                      0xD6, 0x03, // SUB 3
+                                      0xE6, 0x7F, // AND 0x7F
+                                      0xB3,       // OR E
+                                      0xB8,       // CP B
+                                      0x0D,       // DEC C
+                                      0x20, 0xF4, // JR NZ,loop
+                                      0x18, 0xF2}); // JR loop
+  const uint8_t handler[] = {0xF5,       // PUSH AF
+                             0x3E, 0x81, // LD A,0x81
+                             0xE0, 0x02, // LDH (SC),A
+                             0xF1,       // POP AF
+                             0xD9};      // RETI
+  std::copy(std::begin(handler), std::end(handler), rom.begin() + 0x58);
+  Emulator skipping, plain;
+  skipping.LoadROM(rom);
+  plain.LoadROM(rom);
+  plain.cpu().set_skip_dead_flags(false);
+  for (int frame = 0; frame < 3; ++frame) {
+    skipping.RunFrame();
+    plain.RunFrame();
+    ASSERT_EQ(skipping.StateHash(), plain.StateHash()) << "frame " << frame;
+  }
+  EXPECT_EQ(plain.cpu().dead_flag_instructions(), 0u);
+  EXPECT_GT(skipping.cpu().dead_flag_instructions(), 10000u);
+}
+
+TEST(Emulator, SkippedFlagBlocksWriteOnTheirOwnCycle) {
+  // Each block of INCs ends in the write that starts a serial transfer,
+  // timed by a polling loop whose count lands in B
+  std::vector<uint8_t> rom = MakeRom({0x11, 0x02, 0xFF, // LD DE,SC
+                                      0x06, 0x00,       // LD B,0
+                                      0x3E, 0x7D,       // loop: LD A,0x7D
+                                      0x3C, 0x3C,       // INC A; INC A
+                                      0x3C, 0x3C,       // INC A; INC A
+                                      0x12,             // LD (DE),A
+                                      0x0E, 0x00,       // LD C,0
+                                      0x0C,             // wait: INC C
+                                      0xF0, 0x0F,       // LDH A,(IF)
+                                      0xE6, 0x08,       // AND 0x08
+                                      0x28, 0xF9,       // JR Z,wait
+                                      0xAF,             // XOR A
+                                      0xE0, 0x0F,       // LDH (IF),A
+                                      0x79,             // LD A,C
+                                      0x80,             // ADD A,B
+                                      0x47,             // LD B,A
+                                      0x18, 0xE8});     // JR loop
+  Emulator skipping, plain;
+  skipping.LoadROM(rom);
+  plain.LoadROM(rom);
+  for (Emulator* emu : {&skipping, &plain}) {
+    emu->cpu().set_superinstructions(false);
+  }
+  plain.cpu().set_skip_dead_flags(false);
+  for (int frame = 0; frame < 3; ++frame) {
+    skipping.RunFrame();
+    plain.RunFrame();
+    ASSERT_EQ(skipping.cpu().registers(), plain.cpu().registers());
+    ASSERT_EQ(skipping.StateHash(), plain.StateHash()) << "frame " << frame;
+  }
+  EXPECT_GT(skipping.cpu().dead_flag_instructions(), 3u * 40);
+}
+
+TEST(Emulator, BulkLoopsMatchTheInterpreter) {
+  // One loop of each kind, the first interrupted by a serial transfer
+  const std::vector<uint8_t> code = {
+      0x3E, 0x08,       // LD A,0x08
+      0xE0, 0xFF,       // LDH (IE),A
+      0x3E, 'b',        // LD A,'b'
+      0xE0, 0x01,       // LDH (SB),A
+      0x3E, 0x81,       // LD A,0x81
+      0xE0, 0x02,       // LDH (SC),A
+      0xFB,             // EI
+      0x21, 0x00, 0x02, // LD HL,0x0200
+      0x11, 0x00, 0xC0, // LD DE,0xC000
+      0x01, 0x00, 0x03, // LD BC,0x0300
+      0x2A,             // LD A,(HL+)
+      0x12,             // LD (DE),A
+      0x13,             // INC DE
+      0x0B,             // DEC BC
+      0x78,             // LD A,B
+      0xB1,             // OR C
+      0x20, 0xF8,       // JR NZ,-8
+      0x21, 0xFF, 0x9F, // LD HL,0x9FFF
+      0x3E, 0x5A,       // LD A,0x5A
+      0x06, 0x00,       // LD B,0
+      0x32,             // LD (HL-),A
+      0x05,             // DEC B
+      0x20, 0xFC,       // JR NZ,-4
+      0x21, 0x00, 0xC0, // LD HL,0xC000
+      0x11, 0x01, 0xC0, // LD DE,0xC001
+      0x0E, 0x80,       // LD C,0x80
+      0x2A,             // LD A,(HL+)
+      0x12,             // LD (DE),A
+      0x13,             // INC DE
+      0x0D,             // DEC C
+      0x20, 0xFA,       // JR NZ,-6
+      0x18, 0xFE,       // JR -2
+  };
+  std::vector<uint8_t> rom = MakeRom(code);
+  rom[0x58] = 0xD9; // RETI
+  for (int i = 0; i < 0x300; ++i) rom[0x200 + i] = static_cast<uint8_t>(i * 7);
+  Emulator bulk, plain;
+  bulk.LoadROM(rom);
+  plain.LoadROM(rom);
+  plain.cpu().set_bulk_loops(false);
+  for (int frame = 0; frame < 2; ++frame) {
+    bulk.RunFrame();
+    plain.RunFrame();
+    ASSERT_EQ(bulk.cpu().registers(), plain.cpu().registers());
+    ASSERT_EQ(bulk.StateHash(), plain.StateHash()) << "frame " << frame;
+  }
+  EXPECT_EQ(bulk.mmu().Read(0xC2FF), static_cast<uint8_t>(0x2FF * 7));
+  EXPECT_EQ(bulk.mmu().Read(0x9F00), 0x5A);
+  // The overlapping copy smears the first byte
+  EXPECT_EQ(bulk.mmu().Read(0xC080), 0x00);
+  EXPECT_EQ(plain.cpu().bulk_iterations(), 0u);
+  // All but the last iteration of each loop, less a few around the
+  // interrupt
+  EXPECT_GT(bulk.cpu().bulk_iterations(), 0x300u + 0xFF + 0x7F - 8);
+}
+
+TEST(Emulator, BulkLoopsLetAnInterruptCutInAtItsOwnIteration) {
+  // A fill loop with the joypad interrupt enabled and a press queued for
+  // each cycle across it: the press lands in the bus catch-up before a
+  // jump back, and the ISR must still see the B of that iteration
+  std::vector<uint8_t> rom = MakeRom({0x3E, 0x10,       // LD A,0x10
+                                      0xE0, 0xFF,       // LDH (IE),A
+                                      0xE0, 0x00,       // LDH (P1),A
+                                      0xFB,             // EI
+                                      0x21, 0x00, 0xC0, // LD HL,0xC000
+                                      0x06, 0x80,       // LD B,0x80
+                                      0x22,             // LD (HL+),A
+                                      0x05,             // DEC B
+                                      0x20, 0xFC,       // JR NZ,-4
+                                      0x18, 0xFE});     // JR -2
+  const uint8_t isr[] = {0x78,             // LD A,B
+                         0xEA, 0x00, 0xD0, // LD (0xD000),A
+                         0xD9};            // RETI
+  std::copy(std::begin(isr), std::end(isr), rom.begin() + 0x60);
+  for (uint64_t delay = 40; delay < 400; ++delay) {
+    Emulator bulk, plain;
+    plain.cpu().set_bulk_loops(false);
+    for (Emulator* emu : {&bulk, &plain}) {
+      emu->LoadROM(rom);
+      emu->QueueInput(emu->mmu().cycles() + delay, kButtonA);
+      emu->RunFrame();
+    }
+    ASSERT_EQ(bulk.mmu().Read(0xD000), plain.mmu().Read(0xD000))
+        << "press at " << delay;
+    ASSERT_EQ(bulk.StateHash(), plain.StateHash()) << "press at " << delay;
+  }
+}
+
+TEST(Emulator, PpuLogSeesBulkLoopWrites) {
+  // A VRAM fill loop, then a scroll write
+  std::vector<uint8_t> rom = MakeRom({0x21, 0xFF, 0x9F, // LD HL,0x9FFF
+                                      0x3E, 0x5A,       // LD A,0x5A
+                                      0x06, 0x00,       // LD B,0
+                                      0x32,             // LD (HL-),A
+                                      0x05,             // DEC B
+                                      0x20, 0xFC,       // JR NZ,-4
+                                      0x3E, 0x07,       // LD A,7
+                                      0xE0, 0x43,       // LDH (SCX),A
+                                      0x18, 0xFE});     // JR -2
+  Emulator bulk, plain;
+  bulk.LoadROM(rom);
+  plain.LoadROM(rom);
+  plain.cpu().set_bulk_loops(false);
+  for (Emulator* emu : {&bulk, &plain}) {
+    emu->mmu().set_ppu_log(true);
+    emu->RunFrame();
+  }
+  ASSERT_EQ(bulk.mmu().ppu_log().size(), 0x100u + 1);
+  EXPECT_EQ(bulk.mmu().ppu_log(), plain.mmu().ppu_log());
+  EXPECT_EQ(bulk.mmu().ppu_log().back().address, 0xFF43);
+  EXPECT_EQ(bulk.StateHash(), plain.StateHash());
+}
+
+TEST(Emulator, PpuLogIsTheSameHoweverStepsRun) {
+  // A VRAM copy loop of fused pairs, a dead-flag block ending in a
+  // scroll write, and a serial interrupt whose handler writes SCY
+  std::vector<uint8_t> rom = MakeRom({0x3E, 0x08,       // LD A,0x08
+                                      0xE0, 0xFF,       // LDH (IE),A
+                                      0x3E, 0x81,       // LD A,0x81
+                                      0xE0, 0x02,       // LDH (SC),A
+                                      0xFB,             // EI
+                                      0x21, 0x00, 0x02, // loop: LD HL,0x0200
+                                      0x11, 0x00, 0x80, // LD DE,0x8000
+                                      0x06, 0x00,       // LD B,0
+                                      0x2A,             // LD A,(HL+)
+                                      0x12,             // LD (DE),A
+                                      0x13,             // INC DE
+                                      0x05,             // DEC B
+                                      0x20, 0xFA,       // JR NZ,-6
+                                      0x3C, 0x3C,       // INC A; INC A
+                                      0x3C, 0x3C,       // INC A; INC A
+                                      0xE0, 0x43,       // LDH (SCX),A
+                                      0x18, 0xEA});     // JR loop
+  const uint8_t handler[] = {0xF5,       // PUSH AF
+                             0x3E, 0x81, // LD A,0x81
+                             0xE0, 0x02, // LDH (SC),A
+                             0xE0, 0x42, // LDH (SCY),A
+                             0xF1,       // POP AF
+                             0xD9};      // RETI
+  std::copy(std::begin(handler), std::end(handler), rom.begin() + 0x58);
+  for (int i = 0; i < 0x100; ++i) rom[0x200 + i] = static_cast<uint8_t>(i * 3);
+  Emulator plain;
+  plain.LoadROM(rom);
+  plain.cpu().set_superinstructions(false);
+  plain.cpu().set_skip_dead_flags(false);
+  plain.mmu().set_ppu_log(true);
+  for (int frame = 0; frame < 3; ++frame) plain.RunFrame();
+  ASSERT_GT(plain.mmu().ppu_log().size(), 3u * 1000);
+  for (bool fuse : {false, true}) {
+    for (bool skip : {false, true}) {
+      Emulator emu;
+      emu.LoadROM(rom);
+      emu.cpu().set_superinstructions(fuse);
+      emu.cpu().set_skip_dead_flags(skip);
+      emu.mmu().set_ppu_log(true);
+      for (int frame = 0; frame < 3; ++frame) emu.RunFrame();
+      EXPECT_EQ(emu.mmu().ppu_log(), plain.mmu().ppu_log())
+          << "superinstructions " << fuse << ", dead flags " << skip;
+    }
+  }
+}
+
+TEST(Emulator, LoopsThatWriteAreNotSkipped) {
+  Emulator emu;
+  emu.LoadROM(MakeRom({0x21, 0x00, 0xC0, // LD HL,0xC000
+                       0x7E,             // LD A,(HL)
+                       0x77,             // LD (HL),A
+                       0x18, 0xFC}));    // JR -4
+  emu.RunFrame();
+  EXPECT_EQ(emu.cpu().skipped_cycles(), 0u);
+}
+
+} // namespace
+} // namespace gb
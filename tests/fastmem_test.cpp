@@ -0,0 +1,125 @@
+#include "gb/fastmem.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "gb/cpu.h"
+
+namespace gb {
+namespace {
+
+// MBC1 cartridge with `code` at the entry point and each switchable bank
+// starting with its bank number
+std::vector<uint8_t> MakeRom(const std::vector<uint8_t>& code) {
+  std::vector<uint8_t> rom(4 * kBankSize, 0x00);
+  rom[0x0147] = 0x01;
+  for (size_t bank = 1; bank < 4; ++bank) {
+    rom[bank * kBankSize] = static_cast<uint8_t>(bank);
+  }
+  std::copy(code.begin(), code.end(), rom.begin() + 0x0100);
+  return rom;
+}
+
+class FastmemTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!FastmemBus::Supported()) GTEST_SKIP() << "no fastmem on this host";
+  }
+};
+
+TEST_F(FastmemTest, RamAndEchoShareStorageWithTheMmu) {
+  auto mmu = std::make_unique<MMU>();
+  mmu->LoadROM(MakeRom({0x18, 0xFE})); // JR -2
+  mmu->Write(0xC123, 0x42);
+  FastmemBus bus(*mmu);
+  ASSERT_TRUE(bus.ok());
+  EXPECT_EQ(bus.Read(0xC123), 0x42);
+  EXPECT_EQ(bus.Read(0xE123), 0x42);
+  bus.Write(0xE456, 0x17);
+  EXPECT_EQ(mmu->Read(0xC456), 0x17);
+  bus.Write(0x8001, 0x99);
+  EXPECT_EQ(mmu->Read(0x8001), 0x99);
+  EXPECT_EQ(bus.faults(), 0u);
+}
+
+TEST_F(FastmemTest, ProtectedPagesFaultIntoTheMmu) {
+  auto mmu = std::make_unique<MMU>();
+  mmu->LoadROM(MakeRom({0x18, 0xFE})); // JR -2
+  FastmemBus bus(*mmu);
+  ASSERT_TRUE(bus.ok());
+  EXPECT_EQ(bus.Read(0x4000), 1);
+  bus.Write(0x2000, 3); // Select ROM bank 3
+  EXPECT_EQ(bus.Read(0x4000), 3);
+  bus.Write(0xFF80, 0x5A); // HRAM
+  EXPECT_EQ(bus.Read(0xFF80), 0x5A);
+  EXPECT_EQ(mmu->Read(0xFF80), 0x5A);
+  bus.Write(kIeAddress, 0x1F);
+  EXPECT_EQ(bus.pending_interrupts(), 0);
+  EXPECT_EQ(bus.faults(), 4u);
+}
+
+TEST_F(FastmemTest, LoggedVramWritesGoThroughTheMmu) {
+  auto mmu = std::make_unique<MMU>();
+  mmu->LoadROM(MakeRom({0x18, 0xFE})); // JR -2
+  FastmemBus bus(*mmu);
+  ASSERT_TRUE(bus.ok());
+  mmu->set_ppu_log(true);
+  bus.Sync();
+  bus.Write(0x8001, 0x99);
+  EXPECT_EQ(bus.Read(0x8001), 0x99);
+  EXPECT_EQ(bus.faults(), 1u);
+  ASSERT_EQ(mmu->ppu_log().size(), 1u);
+  EXPECT_EQ(mmu->ppu_log()[0].address, 0x8001);
+
+  mmu->set_ppu_log(false);
+  bus.Sync();
+  bus.Write(0x8002, 0x98);
+  EXPECT_EQ(bus.faults(), 1u);
+  EXPECT_EQ(mmu->ppu_log().size(), 1u);
+}
+
+TEST_F(FastmemTest, RunsTheSameProgramAsTheMmu) {
+  // Send a serial byte, then read the switchable bank through a bank
+  // switch and store what it holds
+  const std::vector<uint8_t> code = {
+      0x3E, 'k',        // LD A,'k'
+      0xE0, 0x01,       // LDH (SB),A
+      0x3E, 0x81,       // LD A,0x81
+      0xE0, 0x02,       // LDH (SC),A
+      0xF0, 0x02,       // LDH A,(SC)
+      0xE6, 0x80,       // AND 0x80
+      0x20, 0xFA,       // JR NZ,-6
+      0x21, 0x00, 0xC0, // LD HL,0xC000
+      0x3E, 0x02,       // LD A,2
+      0xEA, 0x00, 0x20, // LD (0x2000),A
+      0xFA, 0x00, 0x40, // LD A,(0x4000)
+      0x22,             // LD (HL+),A
+      0x3C,             // INC A
+      0x22,             // LD (HL+),A
+      0x18, 0xFE,       // JR -2
+  };
+  auto reference = std::make_unique<MMU>();
+  auto fast = std::make_unique<MMU>();
+  reference->LoadROM(MakeRom(code));
+  fast->LoadROM(MakeRom(code));
+  CPU cpu(*reference);
+  FastmemBus bus(*fast);
+  ASSERT_TRUE(bus.ok());
+  BasicCpu<FastmemBus> fast_cpu(bus);
+  cpu.Reset();
+  fast_cpu.Reset();
+  for (int i = 0; i < 20000; ++i) {
+    cpu.Step();
+    fast_cpu.Step();
+  }
+  EXPECT_EQ(fast_cpu.registers(), cpu.registers());
+  EXPECT_EQ(fast_cpu.cycles(), cpu.cycles());
+  EXPECT_EQ(fast->serial().output(), "k");
+  EXPECT_EQ(fast->Read(0xC000), 2);
+  EXPECT_EQ(fast->Read(0xC001), 3);
+}
+
+} // namespace
+} // namespace gb
@@ -0,0 +1,133 @@
+#include "gb/gbcore.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+// ROM-only cartridge: increment (0xC000) forever
+//   0x0100: LD HL,0xC000; INC (HL); JR -3
+std::vector<uint8_t> CounterRom() {
+  std::vector<uint8_t> rom(0x8000, 0x00);
+  const uint8_t code[] = {0x21, 0x00, 0xC0, 0x34, 0x18, 0xFD};
+  std::copy(std::begin(code), std::end(code), rom.begin() + 0x0100);
+  return rom;
+}
+
+uint8_t Peek(const gb_emulator* emu, uint16_t address) {
+  uint8_t value = 0;
+  gb_read_memory(emu, address, &value, 1);
+  return value;
+}
+
+TEST(GbCore, RunsFramesAndExposesMemory) {
+  gb_emulator* emu = gb_create();
+  ASSERT_NE(emu, nullptr);
+  std::vector<uint8_t> rom = CounterRom();
+  ASSERT_EQ(gb_load_rom(emu, rom.data(), rom.size()), 0);
+
+  const uint8_t* fb = gb_framebuffer(emu);
+  ASSERT_NE(fb, nullptr);
+  gb_run_frames(emu, 2);
+  EXPECT_EQ(gb_frame_count(emu), 2u);
+  EXPECT_EQ(gb_framebuffer(emu), fb); // Zero-copy: stable pointer
+  EXPECT_NE(Peek(emu, 0xC000), 0);
+
+  const uint8_t data[] = {0xAA, 0xBB};
+  gb_write_memory(emu, 0xD000, data, 2);
+  EXPECT_EQ(Peek(emu, 0xD000), 0xAA);
+  EXPECT_EQ(Peek(emu, 0xD001), 0xBB);
+  gb_destroy(emu);
+}
+
+TEST(GbCore, JoypadIsVisibleThroughP1) {
+  gb_emulator* emu = gb_create();
+  gb_set_joypad(emu, GB_BUTTON_START | GB_BUTTON_UP);
+
+  uint8_t select_buttons = 0x10; // P15 low: action buttons
+  gb_write_memory(emu, 0xFF00, &select_buttons, 1);
+  EXPECT_EQ(Peek(emu, 0xFF00) & 0x0F, 0x07); // Start held
+  uint8_t select_dpad = 0x20; // P14 low: d-pad
+  gb_write_memory(emu, 0xFF00, &select_dpad, 1);
+  EXPECT_EQ(Peek(emu, 0xFF00) & 0x0F, 0x0B); // Up held
+  gb_destroy(emu);
+}
+
+TEST(GbCore, SaveStateRoundTrips) {
+  gb_emulator* emu = gb_create();
+  std::vector<uint8_t> rom = CounterRom();
+  gb_load_rom(emu, rom.data(), rom.size());
+  gb_run_frames(emu, 1);
+
+  size_t size = gb_save_state(emu, nullptr, 0);
+  ASSERT_GT(size, 0u);
+  std::vector<uint8_t> state(size);
+  ASSERT_EQ(gb_save_state(emu, state.data(), state.size()), size);
+  uint8_t counter = Peek(emu, 0xC000);
+
+  gb_run_frames(emu, 3);
+  EXPECT_NE(Peek(emu, 0xC000), counter);
+  ASSERT_EQ(gb_load_state(emu, state.data(), state.size()), 0);
+  EXPECT_EQ(Peek(emu, 0xC000), counter);
+  EXPECT_EQ(gb_frame_count(emu), 1u);
+
+  // Replaying from the snapshot is deterministic
+  gb_run_frames(emu, 1);
+  std::vector<uint8_t> again(size);
+  gb_save_state(emu, again.data(), again.size());
+  gb_load_state(emu, state.data(), state.size());
+  gb_run_frames(emu, 1);
+  std::vector<uint8_t> replay(size);
+  gb_save_state(emu, replay.data(), replay.size());
+  EXPECT_EQ(again, replay);
+  gb_destroy(emu);
+}
+
+TEST(GbCore, RejectsBadStateWithoutSideEffects) {
+  gb_emulator* emu = gb_create();
+  std::vector<uint8_t> rom = CounterRom();
+  gb_load_rom(emu, rom.data(), rom.size());
+  gb_run_frames(emu, 1);
+  std::vector<uint8_t> state(gb_save_state(emu, nullptr, 0));
+  gb_save_state(emu, state.data(), state.size());
+
+  // Truncated snapshot
+  EXPECT_EQ(gb_load_state(emu, state.data(), state.size() - 1), -1);
+  std::vector<uint8_t> after(state.size());
+  gb_save_state(emu, after.data(), after.size());
+  EXPECT_EQ(after, state);
+
+  // Snapshot from a cartridge with different SRAM
+  rom[0x0147] = 0x03; // MBC1+RAM+BATTERY
+  rom[0x0149] = 0x02; // 8 KiB
+  gb_emulator* other = gb_create();
+  gb_load_rom(other, rom.data(), rom.size());
+  EXPECT_EQ(gb_load_state(other, state.data(), state.size()), -1);
+  gb_destroy(other);
+  gb_destroy(emu);
+}
+
+TEST(GbCore, BatchRunsInstancesIntoOneTensor) {
+  std::vector<uint8_t> rom = CounterRom();
+  std::vector<gb_emulator*> emus;
+  for (int i = 0; i < 5; ++i) {
+    emus.push_back(gb_create());
+    gb_load_rom(emus.back(), rom.data(), rom.size());
+  }
+  gb_batch* batch = gb_batch_create(2, 0);
+  ASSERT_NE(batch, nullptr);
+  std::vector<uint8_t> frames(emus.size() * GB_SCREEN_WIDTH *
+                              GB_SCREEN_HEIGHT, 0xFF);
+  ASSERT_EQ(gb_batch_run_frame(batch, emus.data(), emus.size(),
+                               frames.data()),
+            0);
+  for (gb_emulator* emu : emus) {
+    EXPECT_EQ(gb_frame_count(emu), 1u);
+    gb_destroy(emu);
+  }
+  EXPECT_EQ(frames.back(), 0);
+  gb_batch_destroy(batch);
+}
+
+} // namespace
@@ -0,0 +1,69 @@
+#include "gb/hash.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+#include "gb/emulator.h"
+
+namespace gb {
+namespace {
+
+TEST(Hash64, FlippingAnyBitChangesTheHash) {
+  // Long enough for several scramble blocks plus a partial stripe
+  std::vector<uint8_t> data(3 * 1024 + 37);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(i);
+  const uint64_t base = Hash64(data.data(), data.size());
+  EXPECT_EQ(Hash64(data.data(), data.size()), base);
+
+  std::set<uint64_t> seen{base};
+  for (size_t i = 0; i < data.size(); i += 7) {
+    data[i] ^= 0x10;
+    seen.insert(Hash64(data.data(), data.size()));
+    data[i] ^= 0x10;
+  }
+  EXPECT_EQ(seen.size(), 1 + (data.size() + 6) / 7);
+}
+
+TEST(Hash64, DependsOnOrderLengthAndSeed) {
+  std::vector<uint8_t> data(256, 0);
+  data[0] = 1;
+  std::vector<uint8_t> swapped(256, 0);
+  swapped[64] = 1; // Same bytes, first two stripes swapped
+  EXPECT_NE(Hash64(data.data(), 128), Hash64(swapped.data(), 128));
+  // Trailing zeros are not the same as the zero padding of the tail
+  EXPECT_NE(Hash64(data.data(), 100), Hash64(data.data(), 101));
+  EXPECT_NE(Hash64(data.data(), 0), Hash64(data.data(), 0, 1));
+  EXPECT_NE(Hash64(data.data(), 256), Hash64(data.data(), 256, 1));
+}
+
+TEST(StateHash, RegionHashesPinpointWhatChanged) {
+  std::vector<uint8_t> rom(2 * kBankSize, 0x00);
+  rom[0x0100] = 0x18; // JR -2
+  rom[0x0101] = 0xFE;
+  Emulator emu;
+  emu.LoadROM(rom);
+  emu.RunFrame();
+  const StateHashes before = emu.RegionHashes();
+  const uint64_t hash = emu.StateHash();
+
+  emu.mmu().Write(0xD123, 0x42);
+  StateHashes after = emu.RegionHashes();
+  for (size_t i = 0; i < kStateRegionCount; ++i) {
+    EXPECT_EQ(after[i] != before[i],
+              static_cast<StateRegion>(i) == StateRegion::kWram)
+        << StateRegionName(static_cast<StateRegion>(i));
+  }
+  EXPECT_NE(emu.StateHash(), hash);
+
+  // A machine restored from a snapshot hashes the same
+  std::vector<uint8_t> state = emu.SaveState();
+  Emulator copy;
+  copy.LoadROM(rom);
+  ASSERT_TRUE(copy.LoadState(state.data(), state.size()));
+  EXPECT_EQ(copy.RegionHashes(), after);
+}
+
+} // namespace
+} // namespace gb
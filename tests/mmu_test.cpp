@@ -33,5 +33,357 @@ TEST(MMU, VRAMandWRAM) {
   mmu.Write(0xE000, 0xCC);
   EXPECT_EQ(mmu.Read(0xC000), 0xCC);
 }
+namespace {
 
-} // namespace gb
\ No newline at end of file
+// Build a ROM whose every bank starts with its own bank number (low byte)
+// and a marker of its high bits, with the given header type and RAM size.
+std::vector<uint8_t> MakeBankedRom(uint8_t cart_type, size_t banks,
+                                   uint8_t ram_code) {
+  std::vector<uint8_t> rom(banks * kBankSize, 0);
+  for (size_t b = 0; b < banks; ++b) {
+    rom[b * kBankSize] = static_cast<uint8_t>(b & 0xFF);
+    rom[b * kBankSize + 1] = static_cast<uint8_t>(b >> 8);
+  }
+  rom[0x0147] = cart_type;
+  rom[0x0149] = ram_code;
+  return rom;
+}
+
+} // namespace
+
+TEST(MMU, HeaderSelectsMapper) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x00, 2, 0x00));
+  EXPECT_EQ(mmu.mbc_type(), MbcType::kNone);
+  mmu.LoadROM(MakeBankedRom(0x03, 4, 0x03));
+  EXPECT_EQ(mmu.mbc_type(), MbcType::kMbc1);
+  EXPECT_EQ(mmu.sram().size(), 0x8000u);
+  mmu.LoadROM(MakeBankedRom(0x06, 4, 0x00));
+  EXPECT_EQ(mmu.mbc_type(), MbcType::kMbc2);
+  EXPECT_EQ(mmu.sram().size(), kMbc2RamSize);
+  mmu.LoadROM(MakeBankedRom(0x10, 4, 0x03));
+  EXPECT_EQ(mmu.mbc_type(), MbcType::kMbc3);
+  mmu.LoadROM(MakeBankedRom(0x1B, 4, 0x04));
+  EXPECT_EQ(mmu.mbc_type(), MbcType::kMbc5);
+  EXPECT_EQ(mmu.sram().size(), kMaxSramSize);
+}
+
+TEST(MMU, Mbc1RomAndRamBanking) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x03, 128, 0x03));
+
+  // Bank 0 maps as bank 1
+  mmu.Write(0x2000, 0x00);
+  EXPECT_EQ(mmu.Read(0x4000), 1);
+  mmu.Write(0x2000, 0x05);
+  EXPECT_EQ(mmu.Read(0x4000), 5);
+
+  // Upper bits extend the bank number
+  mmu.Write(0x4000, 0x02);
+  EXPECT_EQ(mmu.Read(0x4000), 0x45);
+  EXPECT_EQ(mmu.Read(0x0000), 0);
+
+  // Mode 1 also remaps the 0x0000 window and selects the RAM bank
+  mmu.Write(0x6000, 0x01);
+  EXPECT_EQ(mmu.Read(0x0000), 0x40);
+
+  mmu.Write(0x0000, 0x0A);
+  mmu.Write(0xA000, 0x22);
+  mmu.Write(0x4000, 0x01);
+  EXPECT_NE(mmu.Read(0xA000), 0x22);
+  mmu.Write(0x4000, 0x02);
+  EXPECT_EQ(mmu.Read(0xA000), 0x22);
+
+  // Disabled RAM reads as open bus
+  mmu.Write(0x0000, 0x00);
+  EXPECT_EQ(mmu.Read(0xA000), 0xFF);
+}
+
+TEST(MMU, Mbc2NibbleRam) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x06, 16, 0x00));
+
+  // Address bit 8 set selects the ROM bank register
+  mmu.Write(0x2100, 0x07);
+  EXPECT_EQ(mmu.Read(0x4000), 7);
+
+  // Bit 8 clear is RAM enable; RAM only keeps the low nibble and echoes
+  mmu.Write(0x0000, 0x0A);
+  mmu.Write(0xA010, 0xAB);
+  EXPECT_EQ(mmu.Read(0xA010), 0xFB);
+  EXPECT_EQ(mmu.Read(0xA210), 0xFB);
+}
+
+TEST(MMU, Mbc3BanksAndRtcRegisters) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x10, 128, 0x03));
+
+  mmu.Write(0x2000, 0x7F);
+  EXPECT_EQ(mmu.Read(0x4000), 0x7F);
+
+  mmu.Write(0x0000, 0x0A);
+  mmu.Write(0x4000, 0x03);
+  mmu.Write(0xA000, 0x33);
+  mmu.Write(0x4000, 0x00);
+  EXPECT_NE(mmu.Read(0xA000), 0x33);
+  mmu.Write(0x4000, 0x03);
+  EXPECT_EQ(mmu.Read(0xA000), 0x33);
+
+  // Writing the minutes register only becomes visible after a latch
+  mmu.Write(0x4000, 0x09);
+  mmu.Write(0xA000, 42);
+  mmu.Write(0x6000, 0x00);
+  mmu.Write(0x6000, 0x01);
+  EXPECT_EQ(mmu.Read(0xA000), 42);
+}
+
+TEST(MMU, Mbc5NineBitBankAndLargeSram) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x1B, 512, 0x04));
+
+  // Bank 0 is selectable on MBC5
+  mmu.Write(0x2000, 0x00);
+  EXPECT_EQ(mmu.Read(0x4000), 0);
+  mmu.Write(0x2000, 0x2A);
+  mmu.Write(0x3000, 0x01);
+  EXPECT_EQ(mmu.Read(0x4000), 0x2A);
+  EXPECT_EQ(mmu.Read(0x4001), 0x01);
+
+  // All 16 RAM banks of a 128 KiB cartridge are distinct
+  mmu.Write(0x0000, 0x0A);
+  for (uint8_t bank = 0; bank < 16; ++bank) {
+    mmu.Write(0x4000, bank);
+    mmu.Write(0xBFFF, bank + 0x10);
+  }
+  for (uint8_t bank = 0; bank < 16; ++bank) {
+    mmu.Write(0x4000, bank);
+    EXPECT_EQ(mmu.Read(0xBFFF), bank + 0x10);
+  }
+}
+
+TEST(MMU, Mbc3ClockFollowsEmulatedCycles) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x10, 4, 0x03));
+  mmu.Write(0x0000, 0x0A);
+
+  // Start the clock at 23:59:58 on day 0x1FF
+  const uint8_t start[] = {58, 59, 23, 0xFF, 0x01};
+  for (uint8_t reg = 0; reg < 5; ++reg) {
+    mmu.Write(0x4000, 0x08 + reg);
+    mmu.Write(0xA000, start[reg]);
+  }
+
+  // Three emulated seconds later the day counter overflows and sets carry
+  mmu.Tick(3 * Rtc::kCyclesPerSecond);
+  mmu.Write(0x6000, 0x00);
+  mmu.Write(0x6000, 0x01);
+  const uint8_t expected[] = {1, 0, 0, 0x00, 0x80};
+  for (uint8_t reg = 0; reg < 5; ++reg) {
+    mmu.Write(0x4000, 0x08 + reg);
+    EXPECT_EQ(mmu.Read(0xA000), expected[reg]) << "register " << int(reg);
+  }
+
+  // Halting (DH bit 6) freezes the counter
+  mmu.Write(0x4000, 0x0C);
+  mmu.Write(0xA000, 0x40);
+  mmu.Tick(10 * Rtc::kCyclesPerSecond);
+  mmu.Write(0x6000, 0x00);
+  mmu.Write(0x6000, 0x01);
+  mmu.Write(0x4000, 0x08);
+  EXPECT_EQ(mmu.Read(0xA000), 1);
+}
+
+TEST(MMU, BatteryRoundTripsSramAndRtcTrailer) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x10, 4, 0x02));
+  mmu.Write(0x0000, 0x0A);
+  mmu.Write(0x4000, 0x00);
+  mmu.Write(0xA123, 0x5A);
+  mmu.Write(0x4000, 0x09); // minutes
+  mmu.Write(0xA000, 10);
+
+  std::vector<uint8_t> sav = mmu.SaveBattery(1000);
+  ASSERT_EQ(sav.size(), kExtRamSize + kRtcSaveSize);
+
+  // Reload 90 wall-clock seconds later: the clock catches up
+  mmu.LoadROM(MakeBankedRom(0x10, 4, 0x02));
+  ASSERT_TRUE(mmu.LoadBattery(sav, 1090));
+  mmu.Write(0x0000, 0x0A);
+  mmu.Write(0x4000, 0x00);
+  EXPECT_EQ(mmu.Read(0xA123), 0x5A);
+  mmu.Write(0x6000, 0x00);
+  mmu.Write(0x6000, 0x01);
+  mmu.Write(0x4000, 0x09);
+  EXPECT_EQ(mmu.Read(0xA000), 11);
+  mmu.Write(0x4000, 0x08);
+  EXPECT_EQ(mmu.Read(0xA000), 30);
+}
+
+TEST(MMU, OamDmaCompletesAfter160MachineCycles) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x00, 2, 0x00));
+  for (uint16_t i = 0; i < kOamSize; ++i) {
+    mmu.Write(0xC100 + i, static_cast<uint8_t>(i ^ 0x5A));
+    mmu.Write(0xFE00 + i, 0x00);
+  }
+  mmu.Write(0xFF80, 0x77);
+
+  mmu.Write(0xFF46, 0xC1);
+  EXPECT_TRUE(mmu.dma_active());
+  // OAM is locked and HRAM stays reachable while the transfer runs
+  EXPECT_EQ(mmu.Read(0xFE00), 0xFF);
+  EXPECT_EQ(mmu.Read(0xFF80), 0x77);
+  mmu.Write(0xFE00, 0x99);
+
+  mmu.Tick(kOamDmaSetupCycles + kOamDmaCycles - 4);
+  EXPECT_TRUE(mmu.dma_active());
+  mmu.Tick(4);
+  EXPECT_FALSE(mmu.dma_active());
+  for (uint16_t i = 0; i < kOamSize; ++i) {
+    EXPECT_EQ(mmu.Read(0xFE00 + i), static_cast<uint8_t>(i ^ 0x5A));
+  }
+}
+
+TEST(MMU, OamDmaBusConflicts) {
+  auto& mmu = gb::MMU::Instance();
+  mmu.LoadROM(MakeBankedRom(0x00, 2, 0x00));
+  for (uint16_t i = 0; i < kOamSize; ++i) {
+    mmu.Write(0xC000 + i, static_cast<uint8_t>(0x80 + i));
+  }
+  mmu.Write(0xD000, 0x11);
+  mmu.Write(0x8000, 0x22);
+
+  // DMA from WRAM: external-bus reads see the byte in flight, VRAM is free
+  mmu.Write(0xFF46, 0xC0);
+  mmu.Tick(kOamDmaSetupCycles + 10 * 4);
+  EXPECT_EQ(mmu.Read(0xD000), 0x80 + 10);
+  EXPECT_EQ(mmu.Read(0x8000), 0x22);
+  // Conflicting writes are dropped
+  mmu.Write(0xD000, 0x33);
+  mmu.Tick(kOamDmaCycles);
+  EXPECT_FALSE(mmu.dma_active());
+  EXPECT_EQ(mmu.Read(0xD000), 0x11);
+}
+
+TEST(MMU, JoypadSelectsGroupsAndRaisesInterruptOnPress) {
+  MMU mmu;
+  const uint8_t joypad_bit = InterruptMask(Interrupt::Joypad);
+  mmu.Write(0xFF00, 0x20); // Select the d-pad
+  EXPECT_EQ(mmu.Read(0xFF00), 0xEF);
+
+  // Pressing an unselected button changes nothing visible
+  mmu.SetJoypad(kButtonA);
+  EXPECT_EQ(mmu.Read(0xFF00) & 0x0F, 0x0F);
+  EXPECT_EQ(mmu.Read(kIfAddress) & joypad_bit, 0);
+
+  mmu.SetJoypad(kButtonA | kButtonLeft);
+  EXPECT_EQ(mmu.Read(0xFF00) & 0x0F, 0x0D);
+  EXPECT_NE(mmu.Read(kIfAddress) & joypad_bit, 0);
+
+  // Selecting the buttons group with A held is also a falling edge
+  mmu.Write(kIfAddress, 0x00);
+  mmu.Write(0xFF00, 0x10);
+  EXPECT_EQ(mmu.Read(0xFF00) & 0x0F, 0x0E);
+  EXPECT_NE(mmu.Read(kIfAddress) & joypad_bit, 0);
+}
+
+TEST(MMU, QueuedInputAppliesAtItsCycle) {
+  MMU mmu;
+  mmu.Write(0xFF00, 0x10); // Select the buttons
+  uint64_t start = mmu.cycles();
+  // Queued out of order; applied in cycle order
+  mmu.QueueInput(start + 400, 0);
+  mmu.QueueInput(start + 100, kButtonStart);
+  EXPECT_EQ(mmu.pending_inputs(), 2u);
+
+  mmu.Tick(96);
+  EXPECT_EQ(mmu.Read(0xFF00) & 0x0F, 0x0F);
+  mmu.Tick(4);
+  EXPECT_EQ(mmu.Read(0xFF00) & 0x0F, 0x07);
+  EXPECT_NE(mmu.Read(kIfAddress) & InterruptMask(Interrupt::Joypad), 0);
+  mmu.Tick(300);
+  EXPECT_EQ(mmu.Read(0xFF00) & 0x0F, 0x0F);
+  EXPECT_EQ(mmu.pending_inputs(), 0u);
+
+  // Events already in the past land on the next tick
+  mmu.QueueInput(start, kButtonB);
+  mmu.Tick(4);
+  EXPECT_EQ(mmu.joypad().pressed(), kButtonB);
+}
+
+TEST(MMU, IoRegistersApplyTheirMasks) {
+  MMU mmu;
+  // Plain storage: every bit reads back
+  mmu.Write(0xFF42, 0x5A);
+  EXPECT_EQ(mmu.Read(0xFF42), 0x5A);
+  // IF: upper bits unused, read as 1, and do not reach the pending mask
+  mmu.Write(kIeAddress, 0xFF);
+  mmu.Write(kIfAddress, 0xE4);
+  EXPECT_EQ(mmu.Read(kIfAddress), 0xE4);
+  EXPECT_EQ(mmu.pending_interrupts(), 0x04);
+  mmu.Write(kIfAddress, 0xE0);
+  EXPECT_EQ(mmu.Read(kIfAddress), 0xE0);
+  EXPECT_EQ(mmu.pending_interrupts(), 0x00);
+  // TAC keeps three bits
+  mmu.Write(0xFF07, 0xFD);
+  EXPECT_EQ(mmu.Read(0xFF07), 0xFD);
+  mmu.Write(0xFF07, 0x00);
+  EXPECT_EQ(mmu.Read(0xFF07), 0xF8);
+  // STAT mode bits and LY are read-only
+  mmu.Write(0xFF41, 0xFF);
+  EXPECT_EQ(mmu.Read(0xFF41), 0xF8);
+  mmu.Write(0xFF44, 0x90);
+  EXPECT_EQ(mmu.Read(0xFF44), 0x00);
+  // Write-only frequency bits read as 1
+  mmu.Write(0xFF13, 0x12);
+  EXPECT_EQ(mmu.Read(0xFF13), 0xFF);
+  // Unmapped registers read 0xFF
+  mmu.Write(0xFF03, 0x00);
+  EXPECT_EQ(mmu.Read(0xFF03), 0xFF);
+  mmu.Write(0xFF7F, 0x00);
+  EXPECT_EQ(mmu.Read(0xFF7F), 0xFF);
+}
+
+TEST(MMU, PpuLogRecordsWhatThePpuReads) {
+  MMU mmu;
+  mmu.LoadROM(MakeBankedRom(0x00, 2, 0x00));
+  mmu.Write(0xFF43, 0x01); // Before the log is on
+  mmu.set_ppu_log(true);
+  uint64_t start = mmu.cycles();
+  mmu.Tick(100);
+  mmu.Write(0xFF43, 0x12); // SCX
+  mmu.Write(0xFF41, 0x40); // STAT and plain RAM are not logged
+  mmu.Write(0xC000, 0x33);
+  mmu.Tick(456);
+  mmu.Write(0xFF47, 0xE4); // BGP
+  mmu.Write(0x9800, 0x05);
+  mmu.Write(0xFE03, 0x07);
+  const std::vector<PpuWrite> expected = {{start + 100, 0xFF43, 0x12},
+                                          {start + 556, 0xFF47, 0xE4},
+                                          {start + 556, 0x9800, 0x05},
+                                          {start + 556, 0xFE03, 0x07}};
+  EXPECT_EQ(mmu.ppu_log(), expected);
+
+  // Bulk writes cannot bypass it; WRAM is still fair game
+  EXPECT_EQ(mmu.WritableRange(0x8000, 16), nullptr);
+  EXPECT_NE(mmu.WritableRange(0xC000, 16), nullptr);
+
+  // OAM DMA logs all of OAM as of the cycle it ended
+  std::vector<PpuWrite> frame;
+  mmu.TakePpuLog(&frame);
+  EXPECT_EQ(frame, expected);
+  EXPECT_TRUE(mmu.ppu_log().empty());
+  mmu.Write(0xC001, 0x44);
+  mmu.Write(0xFF46, 0xC0);
+  uint64_t end = mmu.cycles() + kOamDmaSetupCycles + kOamDmaCycles;
+  mmu.Tick(kOamDmaSetupCycles + kOamDmaCycles + 8);
+  ASSERT_EQ(mmu.ppu_log().size(), kOamSize);
+  EXPECT_EQ(mmu.ppu_log()[1], (PpuWrite{end, 0xFE01, 0x44}));
+
+  mmu.set_ppu_log(false);
+  mmu.Write(0xFF42, 0x20);
+  EXPECT_EQ(mmu.ppu_log().size(), kOamSize);
+  EXPECT_NE(mmu.WritableRange(0x8000, 16), nullptr);
+}
+
+} // namespace gb
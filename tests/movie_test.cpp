@@ -0,0 +1,110 @@
+#include "gb/movie.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace gb {
+namespace {
+
+// Counts in E every loop iteration with Right held, so the result depends
+// on exactly when inside a frame the button changed
+std::vector<uint8_t> CountRightRom() {
+  std::vector<uint8_t> rom(2 * kBankSize, 0x00);
+  const uint8_t code[] = {0x3E, 0x20,       // LD A,0x20 (select d-pad)
+                          0xE0, 0x00,       // LDH (P1),A
+                          0xF0, 0x00,       // loop: LDH A,(P1)
+                          0xE6, 0x01,       // AND 0x01 (Right, active low)
+                          0x20, 0x01,       // JR NZ,+1
+                          0x1C,             // INC E
+                          0x18, 0xF7};      // JR loop
+  std::copy(std::begin(code), std::end(code), rom.begin() + 0x0100);
+  return rom;
+}
+
+Movie RecordSample(const std::vector<uint8_t>& rom) {
+  Emulator emu;
+  MovieRecorder recorder(emu, rom);
+  for (int frame = 0; frame < 8; ++frame) {
+    if (frame == 2) recorder.QueueInput(30000, kButtonRight);
+    if (frame == 2) recorder.QueueInput(1000, kButtonRight | kButtonA);
+    if (frame == 5) recorder.QueueInput(50000, 0);
+    recorder.RunFrame();
+  }
+  return recorder.movie();
+}
+
+TEST(Movie, RecorderKeepsInputsOrderedWithinAFrame) {
+  Movie movie = RecordSample(CountRightRom());
+  ASSERT_EQ(movie.frames(), 8u);
+  ASSERT_EQ(movie.inputs.size(), 3u);
+  EXPECT_EQ(movie.inputs[0].frame, 2u);
+  EXPECT_EQ(movie.inputs[0].offset, 1000u);
+  EXPECT_EQ(movie.inputs[1].offset, 30000u);
+  EXPECT_EQ(movie.inputs[2].frame, 5u);
+}
+
+TEST(Movie, PlaybackReproducesEveryFrame) {
+  std::vector<uint8_t> rom = CountRightRom();
+  Movie movie = RecordSample(rom);
+
+  Emulator emu;
+  PlaybackResult result = PlayMovie(emu, rom, movie);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(result.frames, 8u);
+  EXPECT_NE(emu.cpu().e(), 0);
+}
+
+TEST(Movie, PlaybackStopsAtTheFirstDivergentFrame) {
+  std::vector<uint8_t> rom = CountRightRom();
+  Movie movie = RecordSample(rom);
+  movie.inputs[0].offset += 100; // Press a little later than recorded
+
+  Emulator emu;
+  PlaybackResult result = PlayMovie(emu, rom, movie);
+  EXPECT_FALSE(result.ok());
+  EXPECT_EQ(result.first_desync, 2);
+  EXPECT_EQ(result.frames, 3u);
+
+  rom[0x0150] ^= 1;
+  EXPECT_FALSE(PlayMovie(emu, rom, movie).rom_matches);
+}
+
+TEST(Movie, RecordingFromASavedStateReplays) {
+  std::vector<uint8_t> rom = CountRightRom();
+  Emulator emu;
+  emu.LoadROM(rom);
+  emu.SetJoypad(kButtonRight);
+  emu.RunFrame();
+
+  MovieRecorder recorder(emu, rom, /*from_current_state=*/true);
+  recorder.QueueInput(2000, 0);
+  recorder.RunFrame();
+  recorder.RunFrame();
+
+  Emulator replay;
+  EXPECT_TRUE(PlayMovie(replay, rom, recorder.movie()).ok());
+  EXPECT_EQ(replay.StateHash(), emu.StateHash());
+}
+
+TEST(Movie, SerializeRoundTrips) {
+  Movie movie = RecordSample(CountRightRom());
+  movie.start_state = {1, 2, 3};
+  std::vector<uint8_t> bytes = movie.Serialize();
+
+  Movie loaded;
+  ASSERT_TRUE(loaded.Deserialize(bytes.data(), bytes.size()));
+  EXPECT_EQ(loaded.rom_hash, movie.rom_hash);
+  EXPECT_EQ(loaded.start_state, movie.start_state);
+  EXPECT_EQ(loaded.frame_hashes, movie.frame_hashes);
+  ASSERT_EQ(loaded.inputs.size(), movie.inputs.size());
+  EXPECT_EQ(loaded.inputs[1].offset, movie.inputs[1].offset);
+  EXPECT_EQ(loaded.inputs[1].buttons, movie.inputs[1].buttons);
+
+  EXPECT_FALSE(loaded.Deserialize(bytes.data(), bytes.size() - 1));
+  bytes[0] ^= 0xFF;
+  EXPECT_FALSE(loaded.Deserialize(bytes.data(), bytes.size()));
+}
+
+} // namespace
+} // namespace gb
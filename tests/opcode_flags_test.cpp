@@ -0,0 +1,92 @@
+#include "gb/opcode_flags.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "gb/cpu.h"
+#include "gb/flat_bus.h"
+
+namespace gb {
+namespace {
+
+constexpr uint8_t kAll = 0xF0;
+
+TEST(OpcodeFlags, TableFollowsTheMnemonics) {
+  EXPECT_EQ(kOpcodeFlags[0x80].writes, kAll);                // ADD A,B
+  EXPECT_EQ(kOpcodeFlags[0x8E].reads, kCarryFlagMask);       // ADC A,(HL)
+  EXPECT_EQ(kOpcodeFlags[0x04].writes, 0xE0);                // INC B
+  EXPECT_EQ(kOpcodeFlags[0x35].writes, 0xE0);                // DEC (HL)
+  EXPECT_EQ(kOpcodeFlags[0x03].writes, 0);                   // INC BC
+  EXPECT_EQ(kOpcodeFlags[0x09].writes, 0x70);                // ADD HL,BC
+  EXPECT_EQ(kOpcodeFlags[0xE8].writes, kAll);                // ADD SP,r8
+  EXPECT_EQ(kOpcodeFlags[0x17].reads, kCarryFlagMask);       // RLA
+  EXPECT_EQ(kOpcodeFlags[0x27].reads, 0x70);                 // DAA
+  EXPECT_EQ(kOpcodeFlags[0x20].reads, kZeroFlagMask);        // JR NZ
+  EXPECT_EQ(kOpcodeFlags[0xD8].reads, kCarryFlagMask);       // RET C
+  EXPECT_EQ(kOpcodeFlags[0xCA].reads, kZeroFlagMask);        // JP Z
+  EXPECT_EQ(kOpcodeFlags[0xC3].reads, 0);                    // JP a16
+  EXPECT_EQ(kOpcodeFlags[0xF5].reads, kAll);                 // PUSH AF
+  EXPECT_EQ(kOpcodeFlags[0xF1].writes, kAll);                // POP AF
+  EXPECT_EQ(kOpcodeFlags[0x0E].writes, 0);                   // LD C,d8
+
+  EXPECT_TRUE(FlagsDeadAfter(0x80, 0xA9));  // ADD A,B; XOR C
+  EXPECT_FALSE(FlagsDeadAfter(0xA9, 0x04)); // XOR C; INC B keeps C
+  EXPECT_TRUE(FlagsDeadAfter(0x04, 0xD6));  // INC B; SUB d8
+  EXPECT_FALSE(FlagsDeadAfter(0x80, 0x88)); // ADD A,B; ADC A,B reads C
+  EXPECT_FALSE(FlagsDeadAfter(0x3D, 0x20)); // DEC A; JR NZ
+}
+
+// Every instruction pair whose first flags the table calls dead runs to
+// the same registers with dead flags skipped as without
+TEST(OpcodeFlags, SkippedFlagsAreNeverObserved) {
+  auto bus = std::make_unique<FlatBus>();
+  BasicCpu<FlatBus> skipping(*bus);
+  auto plain_bus = std::make_unique<FlatBus>();
+  BasicCpu<FlatBus> plain(*plain_bus);
+  plain.set_skip_dead_flags(false);
+  for (BasicCpu<FlatBus>* cpu : {&skipping, &plain}) {
+    cpu->set_superinstructions(false);
+  }
+  const Registers kSeeds[] = {
+      {0x0F, 0x00, 0x01, 0xFF, 0x80, 0x7F, 0xC1, 0x00, 0xD000, 0x0100},
+      {0x80, 0xF0, 0xFF, 0x01, 0x0F, 0x10, 0xC1, 0xFF, 0xD000, 0x0100},
+      {0x00, 0x10, 0x00, 0x00, 0xFF, 0xFF, 0xC1, 0x80, 0xD000, 0x0100},
+  };
+  uint64_t pairs = 0;
+  for (int first = 0; first < 256; ++first) {
+    for (int second = 0; second < 256; ++second) {
+      auto x = static_cast<uint8_t>(first);
+      auto y = static_cast<uint8_t>(second);
+      if (!FlagsDeadAfter(x, y)) continue;
+      ++pairs;
+      for (const Registers& seed : kSeeds) {
+        for (FlatBus* memory : {bus.get(), plain_bus.get()}) {
+          memory->memory().fill(0);
+          // The d8 forms take 0x3C as operand
+          bool d8 = (x & 0xC7) == 0xC6;
+          memory->Write(0x0100, x);
+          memory->Write(0x0101, d8 ? 0x3C : y);
+          memory->Write(0x0102, d8 ? y : 0x00);
+          memory->Write(0xC100, 0x5A);
+          memory->Write(0xC1FF, 0xA5);
+        }
+        skipping.Reset();
+        plain.Reset();
+        skipping.set_registers(seed);
+        plain.set_registers(seed);
+        skipping.Step();
+        while (plain.cycles() < skipping.cycles()) plain.Step();
+        ASSERT_EQ(skipping.registers(), plain.registers())
+            << std::hex << first << " " << second;
+        ASSERT_EQ(skipping.cycles(), plain.cycles());
+      }
+    }
+  }
+  EXPECT_GT(pairs, 1000u);
+  EXPECT_GT(skipping.dead_flag_instructions(), 1000u);
+  EXPECT_EQ(plain.dead_flag_instructions(), 0u);
+}
+
+} // namespace
+} // namespace gb
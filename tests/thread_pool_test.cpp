@@ -0,0 +1,48 @@
+#include "gb/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace gb {
+namespace {
+
+TEST(ThreadPool, RunsEverySubmittedTask) {
+  ThreadPool pool(4);
+  std::vector<std::atomic<int>> hits(1000);
+  for (size_t i = 0; i < hits.size(); ++i) {
+    pool.Submit([&hits, i] { ++hits[i]; });
+  }
+  pool.Wait();
+  for (const auto& hit : hits) EXPECT_EQ(hit.load(), 1);
+}
+
+TEST(ThreadPool, IdleWorkersStealFromBusyOnes) {
+  ThreadPool pool(2);
+  std::atomic<int> finished{0};
+  // One long task lands on each worker first; the short ones queued
+  // behind the long task must still finish on the other worker
+  pool.Submit([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ++finished;
+  });
+  for (int i = 0; i < 50; ++i) pool.Submit([&] { ++finished; });
+  pool.Wait();
+  EXPECT_EQ(finished.load(), 51);
+}
+
+TEST(ThreadPool, WaitCanBeCalledRepeatedly) {
+  ThreadPool pool(3);
+  std::atomic<int> count{0};
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 10; ++i) pool.Submit([&] { ++count; });
+    pool.Wait();
+    EXPECT_EQ(count.load(), (round + 1) * 10);
+  }
+}
+
+} // namespace
+} // namespace gb
@@ -0,0 +1,97 @@
+#include "gb/opcode_timing.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include "gb/cpu.h"
+#include "gb/flat_bus.h"
+
+namespace gb {
+namespace {
+
+// Reference T-cycle counts (branch not taken), written out from the
+// hardware opcode tables independently of opcode_list.h. 0 marks the
+// undefined opcodes.
+// clang-format off
+constexpr uint8_t kReference[256] = {
+//  x0  x1  x2  x3  x4  x5  x6  x7  x8  x9  xA  xB  xC  xD  xE  xF
+     4, 12,  8,  8,  4,  4,  8,  4, 20,  8,  8,  8,  4,  4,  8,  4, // 0x
+     4, 12,  8,  8,  4,  4,  8,  4, 12,  8,  8,  8,  4,  4,  8,  4, // 1x
+     8, 12,  8,  8,  4,  4,  8,  4,  8,  8,  8,  8,  4,  4,  8,  4, // 2x
+     8, 12,  8,  8, 12, 12, 12,  4,  8,  8,  8,  8,  4,  4,  8,  4, // 3x
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 4x
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 5x
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 6x
+     8,  8,  8,  8,  8,  8,  4,  8,  4,  4,  4,  4,  4,  4,  8,  4, // 7x
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 8x
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 9x
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // Ax
+     4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // Bx
+     8, 12, 12, 16, 12, 16,  8, 16,  8, 16, 12,  4, 12, 24,  8, 16, // Cx
+     8, 12, 12,  0, 12, 16,  8, 16,  8, 16, 12,  0, 12,  0,  8, 16, // Dx
+    12, 12,  8,  0,  0, 16,  8, 16, 16,  4, 16,  0,  0,  0,  8, 16, // Ex
+    12, 12,  8,  4,  0, 16,  8, 16, 12,  8, 16,  4,  0,  0,  8, 16, // Fx
+};
+// clang-format on
+
+// Cost of the conditional branches when taken
+uint8_t ReferenceTaken(uint8_t opcode) {
+  switch (opcode) {
+    case 0x20: case 0x28: case 0x30: case 0x38: return 12; // JR cc
+    case 0xC2: case 0xCA: case 0xD2: case 0xDA: return 16; // JP cc
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC: return 24; // CALL cc
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8: return 20; // RET cc
+    default: return kReference[opcode];
+  }
+}
+
+TEST(OpcodeTiming, PrimaryTableMatchesReference) {
+  for (int op = 0; op < 256; ++op) {
+    if (kReference[op] == 0) continue;
+    EXPECT_EQ(kOpcodeTiming[op].cycles, kReference[op]) << "opcode " << op;
+    EXPECT_EQ(kOpcodeTiming[op].taken, ReferenceTaken(op)) << "opcode " << op;
+  }
+}
+
+TEST(OpcodeTiming, CbTableMatchesReference) {
+  for (int op = 0; op < 256; ++op) {
+    bool hl = (op & 7) == 6;
+    uint8_t want = !hl ? 8 : (op >= 0x40 && op < 0x80) ? 12 : 16;
+    EXPECT_EQ(kOpcodeTiming[kCbTimingBase + op].cycles, want) << "CB " << op;
+    EXPECT_EQ(kOpcodeTiming[kCbTimingBase + op].taken, want) << "CB " << op;
+  }
+}
+
+// Every opcode, run on the CPU with each flag combination, is charged
+// exactly its table entry: both entries for conditional branches, the
+// one fixed cost otherwise
+TEST(OpcodeTiming, StepChargesEveryOpcodeFromTheTable) {
+  FlatBus bus;
+  BasicCpu<FlatBus> cpu(bus);
+  cpu.set_skip_dead_flags(false); // One instruction per Step()
+  for (int index = 0; index < 512; ++index) {
+    bool cb = index >= static_cast<int>(kCbTimingBase);
+    uint8_t op = static_cast<uint8_t>(index);
+    if (!cb && (kReference[op] == 0 || op == 0xCB)) continue;
+
+    std::set<uint64_t> charged;
+    for (uint8_t flags : {0x00, 0xF0}) {
+      cpu.Reset();
+      cpu.set_registers(
+          Registers{0, flags, 0, 0, 0, 0, 0xC0, 0x00, 0xD000, 0x0100});
+      bus.Write(0x0100, cb ? 0xCB : op);
+      bus.Write(0x0101, cb ? op : 0x00);
+      bus.Write(0x0102, 0x00);
+      uint64_t start = cpu.cycles();
+      cpu.Step();
+      charged.insert(cpu.cycles() - start);
+    }
+    const OpcodeTiming& want = kOpcodeTiming[index];
+    std::set<uint64_t> expected{want.cycles, want.taken};
+    EXPECT_EQ(charged, expected) << (cb ? "CB " : "") << int(op);
+  }
+}
+
+} // namespace
+} // namespace gb
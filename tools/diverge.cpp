@@ -0,0 +1,279 @@
+// State-divergence finder.
+//
+//   trace <rom> <out> [--frames N] [--movie M]
+//     Runs the ROM (replaying a movie's input if given) and writes the
+//     per-region state hashes of every frame. Traces written by two builds
+//     of the core can then be compared with `diff`.
+//   diff <trace-a> <trace-b>
+//     Reports the first frame and the regions where two traces differ.
+//   lockstep <rom> [--frames N]
+//     Runs the ROM on the plain interpreter and on the lockstep engine side
+//     by side and reports the first frame and regions that differ.
+//   speedups <rom> [--frames N] [--movie M] [--aot DIR]
+//     Runs the ROM (replaying a movie's input if given) with every CPU
+//     speedup off (idle skipping, superinstructions, dead-flag skipping,
+//     bulk loops, AOT) and with all of them on, side by side, and reports
+//     the first frame and regions that differ. --aot loads the ROM's
+//     compiled blocks from DIR for the second run.
+//
+// Exits 1 on a divergence, 2 on usage or I/O errors.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "gb/lockstep.h"
+#include "gb/movie.h"
+
+namespace {
+
+// "GBHT", version, region count, then one StateHashes per frame
+constexpr uint32_t kTraceMagic = 0x54484247;
+constexpr uint32_t kTraceVersion = 1;
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  data->assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+
+bool WriteFile(const char* path, const std::vector<uint8_t>& data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size()));
+  return static_cast<bool>(out);
+}
+
+bool LoadTrace(const char* path, std::vector<gb::StateHashes>* frames) {
+  std::vector<uint8_t> data;
+  if (!ReadFile(path, &data)) return false;
+  gb::StateReader r(data.data(), data.size());
+  uint32_t magic = 0, version = 0, regions = 0;
+  r.Read(&magic);
+  r.Read(&version);
+  r.Read(&regions);
+  if (!r.ok() || magic != kTraceMagic || version != kTraceVersion ||
+      regions != gb::kStateRegionCount) {
+    return false;
+  }
+  frames->resize((data.size() - 3 * sizeof(uint32_t)) /
+                 sizeof(gb::StateHashes));
+  for (gb::StateHashes& hashes : *frames) r.Read(&hashes);
+  return r.done();
+}
+
+// Print the regions that differ; returns true if any do
+bool Report(uint64_t frame, const gb::StateHashes& a,
+            const gb::StateHashes& b) {
+  if (a == b) return false;
+  std::cout << "first divergence at frame " << frame << ":";
+  for (size_t i = 0; i < gb::kStateRegionCount; ++i) {
+    if (a[i] != b[i]) {
+      std::cout << " " << gb::StateRegionName(static_cast<gb::StateRegion>(i));
+    }
+  }
+  std::cout << std::endl;
+  return true;
+}
+
+bool LoadMovie(const char* path, gb::Movie* movie) {
+  std::vector<uint8_t> bytes;
+  if (!ReadFile(path, &bytes) ||
+      !movie->Deserialize(bytes.data(), bytes.size())) {
+    std::cerr << path << ": not a movie file" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int Trace(const char* rom_path, const char* out_path, uint32_t frames,
+          const char* movie_path) {
+  std::vector<uint8_t> rom;
+  if (!ReadFile(rom_path, &rom)) {
+    std::cerr << "could not read " << rom_path << std::endl;
+    return 2;
+  }
+  std::vector<uint8_t> out;
+  gb::StateWriter w(out);
+  w.Write(kTraceMagic);
+  w.Write(kTraceVersion);
+  w.Write(static_cast<uint32_t>(gb::kStateRegionCount));
+
+  gb::Emulator emu;
+  if (movie_path) {
+    gb::Movie movie;
+    if (!LoadMovie(movie_path, &movie)) return 2;
+    // Keep going past a hash mismatch: finding where is the point
+    gb::PlaybackResult result =
+        gb::PlayMovie(emu, rom, movie, /*verify=*/false, [&](uint32_t) {
+          w.Write(emu.RegionHashes());
+        });
+    if (!result.rom_matches) {
+      std::cerr << "movie was recorded with a different ROM" << std::endl;
+      return 2;
+    }
+  } else {
+    emu.LoadROM(rom);
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      emu.RunFrame();
+      w.Write(emu.RegionHashes());
+    }
+  }
+  if (!WriteFile(out_path, out)) {
+    std::cerr << "could not write " << out_path << std::endl;
+    return 2;
+  }
+  return 0;
+}
+
+int Diff(const char* a_path, const char* b_path) {
+  std::vector<gb::StateHashes> a, b;
+  if (!LoadTrace(a_path, &a) || !LoadTrace(b_path, &b)) {
+    std::cerr << "could not load both traces" << std::endl;
+    return 2;
+  }
+  size_t common = std::min(a.size(), b.size());
+  for (size_t frame = 0; frame < common; ++frame) {
+    if (Report(frame, a[frame], b[frame])) return 1;
+  }
+  if (a.size() != b.size()) {
+    std::cout << "traces agree for " << common << " frames but differ in "
+              << "length (" << a.size() << " vs " << b.size() << ")"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "traces agree for all " << common << " frames" << std::endl;
+  return 0;
+}
+
+int Lockstep(const char* rom_path, uint32_t frames) {
+  std::vector<uint8_t> rom;
+  if (!ReadFile(rom_path, &rom)) {
+    std::cerr << "could not read " << rom_path << std::endl;
+    return 2;
+  }
+  gb::Emulator reference, lane;
+  reference.LoadROM(rom);
+  lane.LoadROM(rom);
+  gb::LockstepEngine engine({&lane});
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    reference.RunFrame();
+    engine.RunFrame();
+    if (Report(frame, reference.RegionHashes(), lane.RegionHashes())) {
+      return 1;
+    }
+  }
+  std::cout << "interpreter and lockstep engine agree for " << frames
+            << " frames" << std::endl;
+  return 0;
+}
+
+int Speedups(const char* rom_path, uint32_t frames, const char* movie_path,
+             const char* aot_dir) {
+  std::vector<uint8_t> rom;
+  if (!ReadFile(rom_path, &rom)) {
+    std::cerr << "could not read " << rom_path << std::endl;
+    return 2;
+  }
+  gb::Movie movie;
+  if (movie_path) {
+    if (!LoadMovie(movie_path, &movie)) return 2;
+    if (gb::RomHash(rom) != movie.rom_hash) {
+      std::cerr << "movie was recorded with a different ROM" << std::endl;
+      return 2;
+    }
+    frames = movie.frames();
+  }
+  gb::Emulator plain, fast;
+  for (gb::Emulator* emu : {&plain, &fast}) {
+    emu->LoadROM(rom);
+    if (!movie.start_state.empty() &&
+        !emu->LoadState(movie.start_state.data(), movie.start_state.size())) {
+      std::cerr << movie_path << ": start state does not load" << std::endl;
+      return 2;
+    }
+  }
+  gb::CpuState& cpu = plain.cpu();
+  cpu.set_idle_skip(false);
+  cpu.set_superinstructions(false);
+  cpu.set_skip_dead_flags(false);
+  cpu.set_bulk_loops(false);
+  if (aot_dir) {
+    std::string error;
+    if (!fast.LoadAotPlugin(aot_dir, &error)) {
+      std::cerr << error << std::endl;
+      return 2;
+    }
+  }
+  size_t next_input = 0;
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    gb::QueueFrameInputs(plain, movie.inputs, next_input, frame);
+    next_input = gb::QueueFrameInputs(fast, movie.inputs, next_input, frame);
+    plain.RunFrame();
+    fast.RunFrame();
+    if (Report(frame, plain.RegionHashes(), fast.RegionHashes())) return 1;
+  }
+  std::cout << "plain interpreter and all speedups agree for " << frames
+            << " frames" << std::endl;
+  return 0;
+}
+
+void PrintUsage(const char* argv0) {
+  std::cerr << "usage: " << argv0
+            << " trace <rom> <out> [--frames N] [--movie M]\n"
+            << "       " << argv0 << " diff <trace-a> <trace-b>\n"
+            << "       " << argv0 << " lockstep <rom> [--frames N]\n"
+            << "       " << argv0
+            << " speedups <rom> [--frames N] [--movie M] [--aot DIR]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  std::string command = argv[1];
+  std::vector<const char*> positional;
+  uint32_t frames = 60 * 60; // One emulated minute
+  const char* movie = nullptr;
+  const char* aot = nullptr;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--movie" && i + 1 < argc) {
+      movie = argv[++i];
+    } else if (arg == "--aot" && i + 1 < argc) {
+      aot = argv[++i];
+    } else if (!arg.empty() && arg[0] != '-') {
+      positional.push_back(argv[i]);
+    } else {
+      PrintUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (command == "trace" && positional.size() == 2) {
+    return Trace(positional[0], positional[1], frames, movie);
+  }
+  if (command == "diff" && positional.size() == 2) {
+    return Diff(positional[0], positional[1]);
+  }
+  if (command == "lockstep" && positional.size() == 1) {
+    return Lockstep(positional[0], frames);
+  }
+  if (command == "speedups" && positional.size() == 1) {
+    return Speedups(positional[0], frames, movie, aot);
+  }
+  PrintUsage(argv[0]);
+  return 2;
+}
@@ -0,0 +1,144 @@
+// Input movie player/recorder.
+//
+//   play <rom> <movie> [--no-verify]
+//     Replays a movie as fast as possible and reports wall time, frames per
+//     second and emulated clock rate. With verification on (the default)
+//     every frame's state hash is checked; a desync exits non-zero and
+//     names the first divergent frame.
+//   record <rom> <movie> --frames N [--seed S]
+//     Records a movie of N frames with pseudo-random button changes, for
+//     repeatable end-to-end benchmarks.
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gb/movie.h"
+
+namespace {
+
+// Clock rate of the DMG in T-cycles per second
+constexpr double kClockHz = 4194304.0;
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  data->assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+
+bool WriteFile(const char* path, const std::vector<uint8_t>& data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size()));
+  return static_cast<bool>(out);
+}
+
+void PrintUsage(const char* argv0) {
+  std::cerr << "usage: " << argv0 << " play <rom> <movie> [--no-verify]\n"
+            << "       " << argv0
+            << " record <rom> <movie> --frames N [--seed S]\n";
+}
+
+int Play(const char* rom_path, const char* movie_path, bool verify) {
+  std::vector<uint8_t> rom, bytes;
+  if (!ReadFile(rom_path, &rom) || !ReadFile(movie_path, &bytes)) {
+    std::cerr << "could not read ROM or movie" << std::endl;
+    return 2;
+  }
+  gb::Movie movie;
+  if (!movie.Deserialize(bytes.data(), bytes.size())) {
+    std::cerr << movie_path << ": not a movie file" << std::endl;
+    return 2;
+  }
+
+  gb::Emulator emu;
+  gb::PlaybackResult result = gb::PlayMovie(emu, rom, movie, verify);
+  if (!result.rom_matches) {
+    std::cerr << "movie was recorded with a different ROM" << std::endl;
+    return 1;
+  }
+  double emulated = result.frames * double(gb::kCyclesPerFrame) / kClockHz;
+  std::cout << result.frames << " frames in " << result.seconds << " s: "
+            << result.frames / result.seconds << " fps, "
+            << emulated / result.seconds << "x realtime, "
+            << result.frames * double(gb::kCyclesPerFrame) / result.seconds /
+                   1e6
+            << " MHz" << std::endl;
+  uint64_t skipped = emu.cpu().skipped_cycles();
+  std::cout << "idle loops skipped " << skipped << " T-cycles ("
+            << 100.0 * skipped / (result.frames * double(gb::kCyclesPerFrame))
+            << "% of emulated time)" << std::endl;
+  if (result.first_desync >= 0) {
+    std::cout << "desync at frame " << result.first_desync << std::endl;
+    return 1;
+  }
+  if (verify) std::cout << "all frame hashes match" << std::endl;
+  return 0;
+}
+
+int Record(const char* rom_path, const char* movie_path, uint32_t frames,
+           uint32_t seed) {
+  std::vector<uint8_t> rom;
+  if (!ReadFile(rom_path, &rom)) {
+    std::cerr << "could not read " << rom_path << std::endl;
+    return 2;
+  }
+  gb::Emulator emu;
+  gb::MovieRecorder recorder(emu, rom);
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<uint32_t> offset(0, gb::kCyclesPerFrame - 1);
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    // About one button change every eight frames
+    if (rng() % 8 == 0) {
+      recorder.QueueInput(offset(rng), static_cast<uint8_t>(rng()));
+    }
+    recorder.RunFrame();
+  }
+  if (!WriteFile(movie_path, recorder.movie().Serialize())) {
+    std::cerr << "could not write " << movie_path << std::endl;
+    return 2;
+  }
+  std::cout << frames << " frames, " << recorder.movie().inputs.size()
+            << " inputs written to " << movie_path << std::endl;
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  std::string command = argv[1];
+  bool verify = true;
+  uint32_t frames = 0;
+  uint32_t seed = 1;
+  for (int i = 4; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--no-verify") {
+      verify = false;
+    } else if (arg == "--frames" && i + 1 < argc) {
+      frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+      PrintUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (command == "play") return Play(argv[2], argv[3], verify);
+  if (command == "record" && frames > 0) {
+    return Record(argv[2], argv[3], frames, seed);
+  }
+  PrintUsage(argv[0]);
+  return 2;
+}
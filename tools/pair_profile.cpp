@@ -0,0 +1,230 @@
+// Opcode-pair profiler for choosing superinstructions.
+//
+//   gameboy-emu-pairs <rom>[=<movie>]... [--frames N] [--top N]
+//
+// Runs each ROM (driven by its input movie, if given) for N frames with
+// superinstructions off, counting every pair of consecutively executed
+// opcodes, and prints the most frequent pairs over the whole corpus with
+// the ones superinstruction_list.h already fuses marked. It then runs
+// the corpus again with fusion off and on and reports the dispatches
+// saved and the wall-time speedup. Idle-loop skipping is off throughout
+// so every instruction is counted and timed; a movie caps the frame count
+// at its length.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gb/emulator.h"
+#include "gb/movie.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Input {
+  std::string rom_path;
+  std::vector<uint8_t> rom;
+  gb::Movie movie;
+  bool has_movie = false;
+};
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>* data) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  data->assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+
+const char* Mnemonic(uint8_t opcode) {
+  static const std::array<const char*, 256> kNames = [] {
+    std::array<const char*, 256> t;
+    t.fill("-");
+#define OPCODE(name, code, cycles, taken) t[code] = #name;
+#include "gb/opcode_list.h"
+#undef OPCODE
+    return t;
+  }();
+  return kNames[opcode];
+}
+
+bool IsFused(uint8_t first, uint8_t second) {
+#define SUPERINSTRUCTION(a, b) \
+  if (first == (a) && second == (b)) return true;
+#include "gb/superinstruction_list.h"
+#undef SUPERINSTRUCTION
+  return false;
+}
+
+// Power on and go to the movie's starting point
+bool Start(gb::Emulator& emu, const Input& input) {
+  emu.LoadROM(input.rom);
+  const std::vector<uint8_t>& state = input.movie.start_state;
+  return state.empty() || emu.LoadState(state.data(), state.size());
+}
+
+// Queue the movie's inputs for `frame`, continuing from `index`
+size_t QueueInputs(gb::Emulator& emu, const Input& input, size_t index,
+                   uint32_t frame) {
+  const std::vector<gb::MovieInput>& inputs = input.movie.inputs;
+  uint64_t base = emu.mmu().cycles();
+  for (; index < inputs.size() && inputs[index].frame == frame; ++index) {
+    emu.QueueInput(base + inputs[index].offset, inputs[index].buttons);
+  }
+  return index;
+}
+
+uint32_t FramesFor(const Input& input, uint32_t frames) {
+  return input.has_movie ? std::min(frames, input.movie.frames()) : frames;
+}
+
+// Count executed opcode pairs, stepping the CPU one instruction at a time
+uint64_t Profile(const Input& input, uint32_t frames,
+                 std::vector<uint64_t>* pairs) {
+  auto emu = std::make_unique<gb::Emulator>();
+  if (!Start(*emu, input)) return 0;
+  gb::CpuState& cpu = emu->cpu();
+  cpu.set_superinstructions(false);
+  cpu.set_idle_skip(false);
+  uint64_t instructions = 0;
+  int previous = -1;
+  size_t next_input = 0;
+  for (uint32_t frame = 0; frame < FramesFor(input, frames); ++frame) {
+    next_input = QueueInputs(*emu, input, next_input, frame);
+    while (!emu->frame_done()) {
+      if (cpu.halted()) {
+        previous = -1;
+      } else {
+        uint8_t opcode = emu->mmu().Read(cpu.pc());
+        if (previous >= 0) ++(*pairs)[previous << 8 | opcode];
+        previous = opcode;
+        ++instructions;
+      }
+      emu->Step();
+    }
+    emu->EndFrame();
+  }
+  return instructions;
+}
+
+struct Timing {
+  double seconds = 0;
+  uint64_t fused = 0;
+};
+
+Timing Time(const Input& input, uint32_t frames, bool fuse) {
+  auto emu = std::make_unique<gb::Emulator>();
+  Timing timing;
+  if (!Start(*emu, input)) return timing;
+  emu->cpu().set_superinstructions(fuse);
+  emu->cpu().set_idle_skip(false);
+  size_t next_input = 0;
+  auto start = Clock::now();
+  for (uint32_t frame = 0; frame < FramesFor(input, frames); ++frame) {
+    next_input = QueueInputs(*emu, input, next_input, frame);
+    emu->RunFrame();
+  }
+  timing.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  timing.fused = emu->cpu().fused_pairs();
+  return timing;
+}
+
+void PrintUsage(const char* argv0) {
+  std::cerr << "usage: " << argv0
+            << " <rom>[=<movie>]... [--frames N] [--top N]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t frames = 3600;
+  size_t top = 40;
+  std::vector<Input> inputs;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--top" && i + 1 < argc) {
+      top = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!arg.empty() && arg[0] == '-') {
+      PrintUsage(argv[0]);
+      return 2;
+    } else {
+      Input input;
+      size_t split = arg.find('=');
+      input.rom_path = arg.substr(0, split);
+      if (!ReadFile(input.rom_path, &input.rom)) {
+        std::cerr << "could not read " << input.rom_path << std::endl;
+        return 2;
+      }
+      if (split != std::string::npos) {
+        std::vector<uint8_t> bytes;
+        if (!ReadFile(arg.substr(split + 1), &bytes) ||
+            !input.movie.Deserialize(bytes.data(), bytes.size()) ||
+            input.movie.rom_hash != gb::RomHash(input.rom)) {
+          std::cerr << arg << ": missing movie or made for another ROM"
+                    << std::endl;
+          return 2;
+        }
+        input.has_movie = true;
+      }
+      inputs.push_back(std::move(input));
+    }
+  }
+  if (inputs.empty()) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+
+  std::vector<uint64_t> pairs(256 * 256, 0);
+  uint64_t instructions = 0;
+  for (const Input& input : inputs) {
+    instructions += Profile(input, frames, &pairs);
+  }
+  std::vector<uint32_t> order(pairs.size());
+  for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+  top = std::min(top, order.size());
+  std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                    [&](uint32_t a, uint32_t b) { return pairs[a] > pairs[b]; });
+
+  std::cout << instructions << " instructions\n"
+            << "   count   share  pair\n";
+  for (size_t i = 0; i < top && pairs[order[i]] > 0; ++i) {
+    auto first = static_cast<uint8_t>(order[i] >> 8);
+    auto second = static_cast<uint8_t>(order[i]);
+    std::cout << std::setw(8) << pairs[order[i]] << std::fixed
+              << std::setprecision(2) << std::setw(7)
+              << 100.0 * pairs[order[i]] / instructions << "%  "
+              << std::hex << std::setfill('0') << std::setw(2) << int(first)
+              << " " << std::setw(2) << int(second) << std::dec
+              << std::setfill(' ') << "  " << Mnemonic(first) << "; "
+              << Mnemonic(second) << (IsFused(first, second) ? "  [fused]" : "")
+              << "\n";
+  }
+
+  Timing plain, fused;
+  for (const Input& input : inputs) {
+    Timing off = Time(input, frames, false);
+    Timing on = Time(input, frames, true);
+    plain.seconds += off.seconds;
+    fused.seconds += on.seconds;
+    fused.fused += on.fused;
+  }
+  std::cout << std::setprecision(2) << "superinstructions: " << fused.fused
+            << " pairs fused, "
+            << 100.0 * fused.fused / std::max<uint64_t>(instructions, 1)
+            << "% fewer dispatches, " << plain.seconds / fused.seconds
+            << "x speedup (" << plain.seconds << " s -> " << fused.seconds
+            << " s)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,545 @@
+// Ahead-of-time recompiler: ROM to C++ for an AOT plugin (gb/aot.h).
+//
+//   gameboy-emu-recompile <rom> [-o <out.cpp>] [--all-banks]
+//
+// Disassembles the ROM by following control flow from the entry point,
+// the RST vectors and the interrupt vectors, and writes C++ with one
+// function per straight-line run of instructions plus the
+// gb_aot_module() table, tagged with the ROM's hash. Built as a shared
+// library under the name it prints (AotPlugin::FileName), the emulator
+// loads it for that ROM (Emulator::LoadAotPlugin, gameboy-emu --aot).
+//
+// Code in the switchable window that bank 0 jumps to is taken to be in
+// bank 1, or with --all-banks in every bank; code within a bank stays in
+// it. Everything the walk cannot see (JP HL targets such as jump tables,
+// code in RAM, banks nothing was followed into) is left to the
+// interpreter, as are HALT, STOP, EI, DI, RETI and LD B,B.
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gb/aot.h"
+#include "gb/mbc.h"
+#include "gb/movie.h"
+#include "gb/opcode_timing.h"
+
+namespace {
+
+// Where an instruction lives: ROM bank (0 below 0x4000) and address
+using Location = std::pair<uint16_t, uint16_t>;
+
+enum class Kind {
+  kNext,   // Falls through to the next instruction
+  kWrite,  // Writes memory; the block returns after it
+  kBranch, // Unconditional transfer; the block returns after it
+  kIf,     // Conditional transfer; falls through when not taken
+  kNone,   // Left to the interpreter
+};
+
+struct Instruction {
+  uint8_t length = 1;
+  Kind kind = Kind::kNone;
+  std::string mnemonic;
+  // Statements for kNext/kWrite; what the taken path does for
+  // kBranch/kIf, with `condition` guarding it for kIf
+  std::string code;
+  std::string condition;
+  uint8_t cycles = 4;
+  uint8_t taken = 4;
+  // Addresses control can reach next (other than through JP HL)
+  std::vector<uint16_t> successors;
+};
+
+const char* Mnemonic(uint8_t opcode) {
+  static const std::array<const char*, 256> kNames = [] {
+    std::array<const char*, 256> t;
+    t.fill("ILLEGAL");
+#define OPCODE(name, code, cycles, taken) t[code] = #name;
+#include "gb/opcode_list.h"
+#undef OPCODE
+    return t;
+  }();
+  return kNames[opcode];
+}
+
+std::string Hex(unsigned value, int digits) {
+  char text[16];
+  std::snprintf(text, sizeof(text), "0x%0*X", digits, value);
+  return text;
+}
+
+// Operand of an 8-bit register field; 6 is (HL)
+const char* const kRegisters[] = {"m->b", "m->c", "m->d", "m->e",
+                                  "m->h", "m->l", nullptr, "m->a"};
+const char* const kPairs[] = {"Pair(m->b, m->c)", "Pair(m->d, m->e)",
+                              "Pair(m->h, m->l)", "m->sp"};
+const char* const kSetPairs[] = {"SetPair(m->b, m->c, ", "SetPair(m->d, m->e, ",
+                                 "SetPair(m->h, m->l, "};
+const char* const kConditions[] = {"!(m->f & kZ)", "(m->f & kZ)",
+                                   "!(m->f & kC)", "(m->f & kC)"};
+
+std::string Source(int r) {
+  return r == 6 ? "Read(m, Pair(m->h, m->l))" : kRegisters[r];
+}
+
+// ADD, ADC, SUB, SBC, AND, XOR, OR or CP with A
+std::string Alu(int op, const std::string& operand) {
+  static const char* const kNames[] = {"Add", "Add", "Sub", "Sub",
+                                       "And", "Xor", "Or",  "Cp"};
+  std::string carry = op >= 4 ? "" : (op & 1) ? ", true" : ", false";
+  return std::string(kNames[op]) + "(m, " + operand + carry + ");";
+}
+
+// `r` = f(`r`) for a register field, as a read-modify-write for (HL)
+std::string Modify(int r, const std::string& f, Kind* kind) {
+  if (r != 6) return std::string(kRegisters[r]) + " = " + f + "(m, " +
+                     kRegisters[r] + ");";
+  *kind = Kind::kWrite;
+  return "{ uint16_t hl = Pair(m->h, m->l); Write(m, hl, " + f +
+         "(m, Read(m, hl))); }";
+}
+
+class Recompiler {
+ public:
+  Recompiler(std::vector<uint8_t> rom, bool all_banks)
+      : rom_(std::move(rom)), all_banks_(all_banks) {
+    // Padded the way MMU::LoadROM pads it
+    size_t banks = 2;
+    while (banks * gb::kBankSize < rom_.size()) banks <<= 1;
+    rom_.resize(banks * gb::kBankSize, 0xFF);
+  }
+
+  void Walk();
+  void Emit(std::ostream& out, uint64_t rom_hash) const;
+
+  size_t instructions() const { return compiled_; }
+  size_t functions() const { return functions_; }
+
+ private:
+  uint8_t Byte(Location at, uint16_t offset) const {
+    uint16_t address = static_cast<uint16_t>(at.second + offset);
+    size_t base = at.first * size_t{gb::kBankSize};
+    return rom_[base + address % gb::kBankSize];
+  }
+  size_t bank_count() const { return rom_.size() / gb::kBankSize; }
+  Instruction Decode(Location at) const;
+  // Queue the code at `target`, reached from bank `from`
+  void Follow(uint16_t from, uint16_t target);
+
+  std::vector<uint8_t> rom_;
+  bool all_banks_;
+  std::map<Location, Instruction> code_;
+  std::vector<Location> pending_;
+  size_t compiled_ = 0;
+  mutable size_t functions_ = 0;
+};
+
+Instruction Recompiler::Decode(Location at) const {
+  Instruction in;
+  const uint8_t op = Byte(at, 0);
+  const std::string name = Mnemonic(op);
+  in.mnemonic = name;
+  auto has = [&](const char* operand) {
+    return name.find(operand) != std::string::npos;
+  };
+  if (has("d16") || has("a16")) {
+    in.length = 3;
+  } else if (has("d8") || has("r8") || has("a8") || name == "STOP" ||
+             name == "PREFIX_CB") {
+    in.length = 2;
+  }
+  // All of it must sit in the window the bank is mapped at
+  uint16_t window_end = at.first == 0 ? gb::kBankSize : 2 * gb::kBankSize;
+  if (at.second + in.length > window_end) return in;
+  const uint8_t n8 = Byte(at, 1);
+  const uint16_t n16 = static_cast<uint16_t>(n8 | Byte(at, 2) << 8);
+  const auto next = static_cast<uint16_t>(at.second + in.length);
+  const auto relative = static_cast<uint16_t>(next + static_cast<int8_t>(n8));
+  const int x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+  in.cycles = gb::kOpcodeTiming[op].cycles;
+  in.taken = gb::kOpcodeTiming[op].taken;
+  in.kind = Kind::kNext;
+  in.successors = {next};
+  std::string& code = in.code;
+  auto branch = [&](Kind kind, const std::string& action) {
+    in.kind = kind;
+    in.code = action;
+    if (kind == Kind::kIf) in.condition = kConditions[y & 3];
+  };
+
+  if (x == 0) {
+    switch (z) {
+      case 0:
+        if (y == 0) {
+          // NOP
+        } else if (y == 1) {
+          in.kind = Kind::kWrite;
+          code = "Write(m, " + Hex(n16, 4) +
+                 ", static_cast<uint8_t>(m->sp)); Write(m, " +
+                 Hex(static_cast<uint16_t>(n16 + 1), 4) +
+                 ", static_cast<uint8_t>(m->sp >> 8));";
+        } else if (y == 2) {
+          in.kind = Kind::kNone; // STOP
+        } else {
+          branch(y == 3 ? Kind::kBranch : Kind::kIf,
+                 "m->pc = " + Hex(relative, 4) + ";");
+          in.successors = {relative};
+          if (y != 3) in.successors.push_back(next);
+        }
+        break;
+      case 1:
+        if (q == 0) {
+          code = p == 3 ? "m->sp = " + Hex(n16, 4) + ";"
+                        : kSetPairs[p] + Hex(n16, 4) + ");";
+        } else {
+          code = std::string("AddHl(m, ") + kPairs[p] + ");";
+        }
+        break;
+      case 2: {
+        // (BC), (DE), (HL+), (HL-)
+        static const char* const kAddress[] = {"Pair(m->b, m->c)",
+                                               "Pair(m->d, m->e)", "hl", "hl"};
+        std::string step = p < 2 ? ""
+                           : p == 2
+                               ? " SetPair(m->h, m->l, static_cast<uint16_t>(hl + 1));"
+                               : " SetPair(m->h, m->l, static_cast<uint16_t>(hl - 1));";
+        std::string access =
+            q == 0 ? std::string("Write(m, ") + kAddress[p] + ", m->a);"
+                   : std::string("m->a = Read(m, ") + kAddress[p] + ");";
+        code = p < 2 ? access
+                     : "{ uint16_t hl = Pair(m->h, m->l); " + access + step +
+                           " }";
+        if (q == 0) in.kind = Kind::kWrite;
+        break;
+      }
+      case 3: {
+        const char* delta = q == 0 ? " + 1" : " - 1";
+        code = p == 3 ? (q == 0 ? "++m->sp;" : "--m->sp;")
+                      : kSetPairs[p] + std::string("static_cast<uint16_t>(") +
+                            kPairs[p] + delta + "));";
+        break;
+      }
+      case 4:
+        code = Modify(y, "Inc", &in.kind);
+        break;
+      case 5:
+        code = Modify(y, "Dec", &in.kind);
+        break;
+      case 6:
+        if (y == 6) {
+          in.kind = Kind::kWrite;
+          code = "Write(m, Pair(m->h, m->l), " + Hex(n8, 2) + ");";
+        } else {
+          code = std::string(kRegisters[y]) + " = " + Hex(n8, 2) + ";";
+        }
+        break;
+      case 7: {
+        static const char* const kMisc[] = {
+            "ShiftA<0>(m);", "ShiftA<1>(m);", "ShiftA<2>(m);", "ShiftA<3>(m);",
+            "Daa(m);",       "Cpl(m);",       "Scf(m);",       "Ccf(m);"};
+        code = kMisc[y];
+        break;
+      }
+    }
+  } else if (x == 1) {
+    if (op == 0x76 || op == 0x40) {
+      in.kind = Kind::kNone; // HALT; LD B,B is the test-ROM breakpoint
+    } else if (y == 6) {
+      in.kind = Kind::kWrite;
+      code = "Write(m, Pair(m->h, m->l), " + Source(z) + ");";
+    } else {
+      code = std::string(kRegisters[y]) + " = " + Source(z) + ";";
+    }
+  } else if (x == 2) {
+    code = Alu(y, Source(z));
+  } else {
+    switch (z) {
+      case 0:
+        if (y < 4) {
+          branch(Kind::kIf, "m->pc = Pop(m);");
+        } else if (y == 4) {
+          in.kind = Kind::kWrite;
+          code = "Write(m, " + Hex(0xFF00 | n8, 4) + ", m->a);";
+        } else if (y == 6) {
+          code = "m->a = Read(m, " + Hex(0xFF00 | n8, 4) + ");";
+        } else {
+          std::string sum =
+              "AddSp(m, " + std::to_string(static_cast<int8_t>(n8)) + ")";
+          code = y == 5 ? "m->sp = " + sum + ";"
+                        : "SetPair(m->h, m->l, " + sum + ");";
+        }
+        break;
+      case 1:
+        if (q == 0) {
+          code = p == 3 ? "{ uint16_t af = Pop(m); m->a = "
+                          "static_cast<uint8_t>(af >> 8); m->f = af & 0xF0; }"
+                        : kSetPairs[p] + std::string("Pop(m));");
+        } else if (p == 0) {
+          branch(Kind::kBranch, "m->pc = Pop(m);");
+          in.successors.clear();
+        } else if (p == 1) {
+          in.kind = Kind::kNone; // RETI
+          in.successors.clear();
+        } else if (p == 2) {
+          branch(Kind::kBranch, "m->pc = Pair(m->h, m->l);");
+          in.successors.clear();
+        } else {
+          code = "m->sp = Pair(m->h, m->l);";
+        }
+        break;
+      case 2:
+        if (y < 4) {
+          branch(Kind::kIf, "m->pc = " + Hex(n16, 4) + ";");
+          in.successors.push_back(n16);
+        } else {
+          // LD (C),A; LD (a16),A; LD A,(C); LD A,(a16)
+          std::string address = (y & 1) ? Hex(n16, 4) : "0xFF00 | m->c";
+          if (y < 6) {
+            in.kind = Kind::kWrite;
+            code = "Write(m, " + address + ", m->a);";
+          } else {
+            code = "m->a = Read(m, " + address + ");";
+          }
+        }
+        break;
+      case 3:
+        if (y == 0) {
+          branch(Kind::kBranch, "m->pc = " + Hex(n16, 4) + ";");
+          in.successors = {n16};
+        } else if (y == 1) {
+          const uint8_t cb = n8;
+          const int cx = cb >> 6, cy = (cb >> 3) & 7, cz = cb & 7;
+          in.mnemonic = "CB_" + Hex(cb, 2);
+          in.cycles = in.taken = gb::kOpcodeTiming[gb::kCbTimingBase + cb].cycles;
+          std::string mask = Hex(1u << cy, 2);
+          if (cx == 0) {
+            code = Modify(cz, "Shift<" + std::to_string(cy) + ">", &in.kind);
+          } else if (cx == 1) {
+            code = "Bit(m, " + mask + ", " + Source(cz) + ");";
+          } else {
+            std::string f = cx == 2 ? "static_cast<uint8_t>(~" + mask + ") & "
+                                    : mask + " | ";
+            if (cz == 6) {
+              in.kind = Kind::kWrite;
+              code = "{ uint16_t hl = Pair(m->h, m->l); Write(m, hl, " + f +
+                     "Read(m, hl)); }";
+            } else {
+              code = std::string(kRegisters[cz]) + " = " + f +
+                     kRegisters[cz] + ";";
+            }
+          }
+        } else if (y == 6 || y == 7) {
+          in.kind = Kind::kNone; // DI, EI
+        } else {
+          in.kind = Kind::kNone; // Undefined
+          in.successors.clear();
+        }
+        break;
+      case 4:
+        if (y < 4) {
+          branch(Kind::kIf,
+                 "Push(m, " + Hex(next, 4) + "); m->pc = " + Hex(n16, 4) + ";");
+          in.successors.push_back(n16);
+        } else {
+          in.kind = Kind::kNone;
+          in.successors.clear();
+        }
+        break;
+      case 5:
+        if (q == 0) {
+          in.kind = Kind::kWrite;
+          code = p == 3 ? "Push(m, Pair(m->a, m->f));"
+                        : std::string("Push(m, ") + kPairs[p] + ");";
+        } else if (p == 0) {
+          branch(Kind::kBranch,
+                 "Push(m, " + Hex(next, 4) + "); m->pc = " + Hex(n16, 4) + ";");
+          in.successors.push_back(n16);
+        } else {
+          in.kind = Kind::kNone;
+          in.successors.clear();
+        }
+        break;
+      case 6:
+        code = Alu(y, Hex(n8, 2));
+        break;
+      case 7:
+        branch(Kind::kBranch, "Push(m, " + Hex(next, 4) + "); m->pc = " +
+                                  Hex(y * 8u, 4) + ";");
+        in.successors.push_back(static_cast<uint16_t>(y * 8));
+        break;
+    }
+  }
+  return in;
+}
+
+void Recompiler::Follow(uint16_t from, uint16_t target) {
+  if (target < gb::kBankSize) {
+    pending_.push_back({0, target});
+  } else if (target < 2 * gb::kBankSize) {
+    if (from != 0) {
+      pending_.push_back({from, target});
+    } else if (!all_banks_) {
+      pending_.push_back({1, target});
+    } else {
+      for (size_t bank = 1; bank < bank_count(); ++bank) {
+        pending_.push_back({static_cast<uint16_t>(bank), target});
+      }
+    }
+  }
+  // Anything above 0x7FFF runs from RAM: the interpreter's
+}
+
+void Recompiler::Walk() {
+  Follow(0, 0x0100);
+  for (uint16_t vector = 0; vector <= 0x60; vector += 8) Follow(0, vector);
+  while (!pending_.empty()) {
+    Location at = pending_.back();
+    pending_.pop_back();
+    if (code_.count(at)) continue;
+    Instruction in = Decode(at);
+    for (uint16_t target : in.successors) Follow(at.first, target);
+    if (in.kind != Kind::kNone) ++compiled_;
+    code_.emplace(at, std::move(in));
+  }
+}
+
+void Recompiler::Emit(std::ostream& out, uint64_t rom_hash) const {
+  out << "// Generated by gameboy-emu-recompile. Do not edit.\n"
+      << "#include \"gb/aot_runtime.h\"\n\n"
+      << "namespace {\n\n"
+      << "using namespace gb;\n"
+      << "using namespace gb::aot;\n";
+  std::ostringstream entries;
+  std::set<Location> emitted;
+  for (const auto& [start, first] : code_) {
+    if (first.kind == Kind::kNone || emitted.count(start)) continue;
+    // A run: consecutive compiled instructions, each falling through to
+    // the next. Entering at any of them switches to its case.
+    char function[32];
+    std::snprintf(function, sizeof(function), "Block_%u_%04X", start.first,
+                  start.second);
+    ++functions_;
+    out << "\nvoid " << function << "(GbAotMachine* m) {\n"
+        << "  switch (m->pc) {\n"
+        << "    default:\n"
+        << "      return;\n";
+    Location at = start;
+    while (true) {
+      const Instruction& in = code_.at(at);
+      emitted.insert(at);
+      entries << "    {" << at.first << ", " << Hex(at.second, 4) << ", &"
+              << function << "},\n";
+      const auto next = static_cast<uint16_t>(at.second + in.length);
+      out << "    case " << Hex(at.second, 4) << ": // " << in.mnemonic << "\n"
+          << "      ++m->instructions;\n";
+      if (in.kind == Kind::kBranch) {
+        out << "      " << in.code << "\n"
+            << "      m->cycles += " << int(in.cycles) << ";\n"
+            << "      return;\n";
+        break;
+      }
+      if (in.kind == Kind::kIf) {
+        out << "      if (" << in.condition << ") {\n"
+            << "        " << in.code << "\n"
+            << "        m->cycles += " << int(in.taken) << ";\n"
+            << "        return;\n"
+            << "      }\n";
+      } else if (!in.code.empty()) {
+        out << "      " << in.code << "\n";
+      }
+      out << "      m->cycles += " << int(in.cycles) << ";\n";
+      auto following = code_.find({at.first, next});
+      bool more = in.kind != Kind::kWrite && following != code_.end() &&
+                  following->second.kind != Kind::kNone &&
+                  !emitted.count(following->first);
+      if (!more) {
+        out << "      m->pc = " << Hex(next, 4) << ";\n"
+            << "      return;\n";
+        break;
+      }
+      out << "      if (m->cycles >= m->budget) {\n"
+          << "        m->pc = " << Hex(next, 4) << ";\n"
+          << "        return;\n"
+          << "      }\n"
+          << "      [[fallthrough]];\n";
+      at = following->first;
+    }
+    out << "  }\n}\n";
+  }
+  out << "\nconst GbAotEntry kEntries[] = {\n"
+      << entries.str() << "    {0, 0, nullptr},\n};\n\n"
+      << "const GbAotModule kModule = {kAotAbiVersion, 0x" << std::hex
+      << rom_hash << "ULL" << std::dec << ", "
+      << compiled_ << ", kEntries};\n\n"
+      << "} // namespace\n\n"
+      << "GB_AOT_EXPORT const gb::GbAotModule* gb_aot_module() {\n"
+      << "  return &kModule;\n"
+      << "}\n";
+}
+
+#ifndef GB_INCLUDE_DIR
+#define GB_INCLUDE_DIR "include"
+#endif
+
+void PrintUsage(const char* argv0) {
+  std::cerr << "usage: " << argv0
+            << " <rom> [-o <out.cpp>] [--all-banks]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string rom_path;
+  std::string out_path;
+  bool all_banks = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else if (arg == "--all-banks") {
+      all_banks = true;
+    } else if (!arg.empty() && arg[0] != '-' && rom_path.empty()) {
+      rom_path = arg;
+    } else {
+      PrintUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (rom_path.empty()) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  std::ifstream in(rom_path, std::ios::binary);
+  if (!in) {
+    std::cerr << "could not read " << rom_path << std::endl;
+    return 2;
+  }
+  std::vector<uint8_t> rom((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+  uint64_t rom_hash = gb::RomHash(rom);
+  if (out_path.empty()) out_path = gb::AotPlugin::FileName(rom_hash) + ".cpp";
+
+  Recompiler recompiler(std::move(rom), all_banks);
+  recompiler.Walk();
+  std::ofstream out(out_path);
+  recompiler.Emit(out, rom_hash);
+  if (!out) {
+    std::cerr << "could not write " << out_path << std::endl;
+    return 2;
+  }
+  std::cout << recompiler.instructions() << " instructions in "
+            << recompiler.functions() << " blocks -> " << out_path << "\n"
+            << "build: c++ -std=c++20 -O2 -shared -fPIC -I" << GB_INCLUDE_DIR
+            << " " << out_path << " -o "
+            << gb::AotPlugin::FileName(rom_hash) << std::endl;
+  return 0;
+}
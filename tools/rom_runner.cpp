@@ -0,0 +1,354 @@
+// Headless test-ROM runner.
+//
+// Runs every .gb/.gbc ROM in a directory on a work-stealing thread pool
+// and prints a JUnit XML report. A ROM passes when one of its criteria
+// is met:
+//   serial:<text>  the text appears on the serial port (Blargg); the run
+//                  stops on the byte that completes it
+//   mooneye        LD B,B is hit with B,C,D,E,H,L = 3,5,8,13,21,34
+//   hash:<hex>     Emulator::StateHash() after the frame budget, a golden
+//                  value for ROMs without a verdict of their own (the
+//                  failure message prints the hash the run ended on)
+// Per-ROM criteria come from an optional manifest ("<rom> <criterion>"
+// per line, '#' comments); other ROMs use the command-line defaults.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gb/emulator.h"
+#include "gb/thread_pool.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Criteria {
+  std::string pass_text = "Passed";
+  std::string fail_text = "Failed";
+  bool serial = true;
+  bool mooneye = true;
+  std::optional<uint64_t> state_hash;
+};
+
+enum class Outcome { kPass, kFail, kTimeout, kError };
+
+struct Result {
+  std::string name;
+  Outcome outcome = Outcome::kError;
+  std::string message;
+  std::string serial;
+  double seconds = 0;
+  uint64_t frames = 0;
+};
+
+struct Options {
+  fs::path rom_dir;
+  fs::path manifest;
+  fs::path junit;
+  Criteria defaults;
+  uint64_t max_frames = 60 * 60; // One emulated minute
+  int timeout_ms = 30000;
+  size_t jobs = 0;
+};
+
+// CPU Steps between wall-clock checks, so a timeout also catches a ROM
+// that is slow inside a single frame
+constexpr uint64_t kStepsPerCheck = 4096;
+
+bool ReadFile(const fs::path& path, std::vector<uint8_t>* data) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  data->assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Parse "serial:<text>", "mooneye" or "hash:<hex>" into criteria that
+// only check that one signal
+bool ParseCriterion(const std::string& spec, Criteria* criteria) {
+  Criteria parsed;
+  parsed.fail_text = criteria->fail_text;
+  parsed.serial = false;
+  parsed.mooneye = false;
+  if (spec.rfind("serial:", 0) == 0) {
+    parsed.serial = true;
+    parsed.pass_text = spec.substr(7);
+  } else if (spec == "mooneye") {
+    parsed.mooneye = true;
+  } else if (spec.rfind("hash:", 0) == 0) {
+    parsed.state_hash = std::strtoull(spec.c_str() + 5, nullptr, 16);
+  } else {
+    return false;
+  }
+  *criteria = parsed;
+  return true;
+}
+
+bool LoadManifest(const fs::path& path,
+                  std::map<std::string, Criteria>* manifest) {
+  std::ifstream in(path);
+  if (!in) return false;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    std::string rom, spec;
+    fields >> rom;
+    std::getline(fields >> std::ws, spec);
+    Criteria criteria;
+    if (!ParseCriterion(spec, &criteria)) {
+      std::cerr << "manifest: bad criterion for " << rom << ": " << spec
+                << std::endl;
+      return false;
+    }
+    (*manifest)[rom] = criteria;
+  }
+  return true;
+}
+
+Result RunRom(const fs::path& path, const Criteria& criteria,
+              const Options& options) {
+  Result result;
+  result.name = path.filename().string();
+  auto start = Clock::now();
+  auto deadline = start + std::chrono::milliseconds(options.timeout_ms);
+
+  std::vector<uint8_t> rom;
+  if (!ReadFile(path, &rom) || rom.empty()) {
+    result.message = "could not read ROM";
+    return result;
+  }
+  auto emu = std::make_unique<gb::Emulator>();
+  emu->LoadROM(rom);
+  // Read the Mooneye signature at the breakpoint, before anything after
+  // it can change the registers
+  emu->set_stop_on_breakpoint(criteria.mooneye);
+
+  result.outcome = Outcome::kTimeout;
+  result.message = "no result before the frame/time budget ran out";
+  // Watch the serial port byte by byte and stop the emulator the moment
+  // the verdict has been printed
+  emu->mmu().serial().set_sink([&](uint8_t byte) {
+    result.serial.push_back(static_cast<char>(byte));
+    if (!criteria.serial) return;
+    if (result.serial.find(criteria.pass_text) != std::string::npos) {
+      result.outcome = Outcome::kPass;
+      result.message.clear();
+      emu->Stop();
+    } else if (result.serial.find(criteria.fail_text) != std::string::npos) {
+      result.outcome = Outcome::kFail;
+      result.message = "serial output reported failure";
+      emu->Stop();
+    }
+  });
+  while (emu->frame_count() < options.max_frames) {
+    emu->RunFrameFor(kStepsPerCheck);
+    if (emu->stopped()) break;
+    if (criteria.mooneye && emu->cpu().breakpoint()) {
+      const gb::CpuState& cpu = emu->cpu();
+      bool pass = cpu.b() == 3 && cpu.c() == 5 && cpu.d() == 8 &&
+                  cpu.e() == 13 && cpu.h() == 21 && cpu.l() == 34;
+      result.outcome = pass ? Outcome::kPass : Outcome::kFail;
+      result.message = pass ? "" : "LD B,B hit with failure signature";
+      break;
+    }
+    if (Clock::now() > deadline) {
+      result.message = "wall-clock timeout";
+      break;
+    }
+  }
+  if (result.outcome == Outcome::kTimeout && criteria.state_hash &&
+      emu->frame_count() >= options.max_frames) {
+    uint64_t hash = emu->StateHash();
+    if (hash == *criteria.state_hash) {
+      result.outcome = Outcome::kPass;
+      result.message.clear();
+    } else {
+      std::ostringstream msg;
+      msg << "state hash " << std::hex << hash << " != "
+          << *criteria.state_hash;
+      result.outcome = Outcome::kFail;
+      result.message = msg.str();
+    }
+  }
+
+  result.frames = emu->frame_count();
+  result.seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return result;
+}
+
+std::string XmlEscape(const std::string& text) {
+  std::string out;
+  for (char c : text) {
+    switch (c) {
+      case '&': out += "&amp;"; break;
+      case '<': out += "&lt;"; break;
+      case '>': out += "&gt;"; break;
+      case '"': out += "&quot;"; break;
+      default:
+        // Test ROMs print arbitrary bytes; keep the XML well formed
+        if (static_cast<unsigned char>(c) < 0x20 && c != '\n' && c != '\t') {
+          out += '?';
+        } else {
+          out += c;
+        }
+    }
+  }
+  return out;
+}
+
+void WriteJUnit(std::ostream& out, const std::vector<Result>& results,
+                double seconds) {
+  size_t failures = 0, errors = 0;
+  for (const Result& r : results) {
+    if (r.outcome == Outcome::kFail || r.outcome == Outcome::kTimeout) {
+      ++failures;
+    } else if (r.outcome == Outcome::kError) {
+      ++errors;
+    }
+  }
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  out << "<testsuites>\n";
+  out << "  <testsuite name=\"gameboy-roms\" tests=\"" << results.size()
+      << "\" failures=\"" << failures << "\" errors=\"" << errors
+      << "\" time=\"" << seconds << "\">\n";
+  for (const Result& r : results) {
+    out << "    <testcase classname=\"roms\" name=\"" << XmlEscape(r.name)
+        << "\" time=\"" << r.seconds << "\">\n";
+    if (r.outcome == Outcome::kFail || r.outcome == Outcome::kTimeout) {
+      out << "      <failure message=\"" << XmlEscape(r.message) << "\"/>\n";
+    } else if (r.outcome == Outcome::kError) {
+      out << "      <error message=\"" << XmlEscape(r.message) << "\"/>\n";
+    }
+    if (!r.serial.empty()) {
+      out << "      <system-out>" << XmlEscape(r.serial) << "</system-out>\n";
+    }
+    out << "    </testcase>\n";
+  }
+  out << "  </testsuite>\n";
+  out << "</testsuites>\n";
+}
+
+void PrintUsage(const char* argv0) {
+  std::cerr << "usage: " << argv0 << " <rom-dir> [options]\n"
+            << "  --manifest FILE     per-ROM criteria (<rom> <criterion>)\n"
+            << "  --criterion SPEC    default: serial:<text>|mooneye|hash:<hex>\n"
+            << "  --fail-text TEXT    serial failure marker (default Failed)\n"
+            << "  --frames N          emulated frame budget per ROM\n"
+            << "  --timeout-ms N      wall-clock budget per ROM\n"
+            << "  --jobs N            worker threads (default: all cores)\n"
+            << "  --junit FILE        write the report to FILE, not stdout\n";
+}
+
+bool ParseArgs(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char* {
+      return i + 1 < argc ? argv[++i] : nullptr;
+    };
+    const char* v = nullptr;
+    if (arg == "--manifest" && (v = value())) {
+      options->manifest = v;
+    } else if (arg == "--criterion" && (v = value())) {
+      if (!ParseCriterion(v, &options->defaults)) return false;
+    } else if (arg == "--fail-text" && (v = value())) {
+      options->defaults.fail_text = v;
+    } else if (arg == "--frames" && (v = value())) {
+      options->max_frames = std::strtoull(v, nullptr, 10);
+    } else if (arg == "--timeout-ms" && (v = value())) {
+      options->timeout_ms = std::atoi(v);
+    } else if (arg == "--jobs" && (v = value())) {
+      options->jobs = std::strtoul(v, nullptr, 10);
+    } else if (arg == "--junit" && (v = value())) {
+      options->junit = v;
+    } else if (!arg.empty() && arg[0] != '-' && options->rom_dir.empty()) {
+      options->rom_dir = arg;
+    } else {
+      return false;
+    }
+  }
+  return !options->rom_dir.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+
+  std::map<std::string, Criteria> manifest;
+  if (!options.manifest.empty() && !LoadManifest(options.manifest, &manifest)) {
+    std::cerr << "could not load manifest " << options.manifest << std::endl;
+    return 2;
+  }
+
+  std::vector<fs::path> roms;
+  std::error_code ec;
+  for (const auto& entry : fs::recursive_directory_iterator(options.rom_dir, ec)) {
+    std::string ext = entry.path().extension().string();
+    if (entry.is_regular_file() && (ext == ".gb" || ext == ".gbc")) {
+      roms.push_back(entry.path());
+    }
+  }
+  if (ec) {
+    std::cerr << "could not scan " << options.rom_dir << ": " << ec.message()
+              << std::endl;
+    return 2;
+  }
+  std::sort(roms.begin(), roms.end());
+
+  auto start = Clock::now();
+  std::vector<Result> results(roms.size());
+  std::atomic<size_t> done{0};
+  {
+    gb::ThreadPool pool(options.jobs);
+    for (size_t i = 0; i < roms.size(); ++i) {
+      pool.Submit([&, i] {
+        auto it = manifest.find(roms[i].filename().string());
+        const Criteria& criteria =
+            it != manifest.end() ? it->second : options.defaults;
+        results[i] = RunRom(roms[i], criteria, options);
+        // Format the progress line first so threads do not interleave
+        std::ostringstream line;
+        line << "[" << ++done << "/" << roms.size() << "] "
+             << (results[i].outcome == Outcome::kPass ? "PASS " : "FAIL ")
+             << results[i].name << "\n";
+        std::cerr << line.str();
+      });
+    }
+    pool.Wait();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  if (options.junit.empty()) {
+    WriteJUnit(std::cout, results, seconds);
+  } else {
+    std::ofstream out(options.junit);
+    WriteJUnit(out, results, seconds);
+  }
+
+  size_t passed = std::count_if(results.begin(), results.end(),
+                                [](const Result& r) {
+                                  return r.outcome == Outcome::kPass;
+                                });
+  std::cerr << passed << "/" << results.size() << " ROMs passed in "
+            << seconds << "s" << std::endl;
+  return passed == results.size() ? 0 : 1;
+}
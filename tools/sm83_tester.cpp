@@ -0,0 +1,416 @@
+// Differential tester for the SM83 core against single-step test vectors.
+//
+// Reads every *.json file in a directory (one file per opcode, "xx.json"
+// and "cb xx.json" as in the public SM83 test suites), runs each case on a
+// BasicCpu<FlatBus> and compares registers, IME, memory and the M-cycle
+// count with the expected final state. Files are spread over a
+// work-stealing thread pool, so the full ~500k-case suite takes seconds.
+//
+// Each case looks like
+//   {"name": "...",
+//    "initial": {"pc":..,"sp":..,"a":..,"b":..,"c":..,"d":..,"e":..,
+//                "f":..,"h":..,"l":..,"ime":..,"ram":[[addr,value],...]},
+//    "final":   {same fields},
+//    "cycles":  [one entry per M-cycle]}
+// By default the opcode sits at the initial PC. With --prefetched it sits
+// at PC-1 and has already been fetched, and the final PC includes the
+// overlapped fetch of the next opcode.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gb/cpu.h"
+#include "gb/flat_bus.h"
+#include "gb/thread_pool.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+// Just enough JSON for the test vectors: no escapes beyond \" and \\,
+// numbers kept as doubles
+struct Json {
+  enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+  Type type = Type::kNull;
+  double number = 0;
+  std::string string;
+  std::vector<Json> items;
+  std::vector<std::pair<std::string, Json>> members;
+
+  const Json* Find(const char* key) const {
+    for (const auto& [name, value] : members) {
+      if (name == key) return &value;
+    }
+    return nullptr;
+  }
+  int64_t Int(const char* key, int64_t fallback = 0) const {
+    const Json* value = Find(key);
+    return value ? static_cast<int64_t>(value->number) : fallback;
+  }
+};
+
+class JsonParser {
+ public:
+  JsonParser(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+  bool Parse(Json* out) {
+    Value(out);
+    SkipSpace();
+    return ok_ && p_ == end_;
+  }
+
+ private:
+  void SkipSpace() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' ||
+                         *p_ == '\t')) {
+      ++p_;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipSpace();
+    if (p_ < end_ && *p_ == c) {
+      ++p_;
+      return true;
+    }
+    return false;
+  }
+
+  bool Literal(const char* word) {
+    size_t n = std::char_traits<char>::length(word);
+    if (static_cast<size_t>(end_ - p_) < n || std::string(p_, n) != word) {
+      return false;
+    }
+    p_ += n;
+    return true;
+  }
+
+  void String(std::string* out) {
+    // Opening quote already consumed
+    while (p_ < end_ && *p_ != '"') {
+      if (*p_ == '\\' && p_ + 1 < end_) ++p_;
+      out->push_back(*p_++);
+    }
+    if (p_ == end_) ok_ = false;
+    ++p_;
+  }
+
+  void Value(Json* out) {
+    SkipSpace();
+    if (!ok_ || p_ == end_) {
+      ok_ = false;
+      return;
+    }
+    char c = *p_;
+    if (c == '{') {
+      ++p_;
+      out->type = Json::Type::kObject;
+      if (Consume('}')) return;
+      do {
+        if (!Consume('"')) {
+          ok_ = false;
+          return;
+        }
+        out->members.emplace_back();
+        String(&out->members.back().first);
+        if (!Consume(':')) {
+          ok_ = false;
+          return;
+        }
+        Value(&out->members.back().second);
+      } while (ok_ && Consume(','));
+      if (!Consume('}')) ok_ = false;
+    } else if (c == '[') {
+      ++p_;
+      out->type = Json::Type::kArray;
+      if (Consume(']')) return;
+      do {
+        out->items.emplace_back();
+        Value(&out->items.back());
+      } while (ok_ && Consume(','));
+      if (!Consume(']')) ok_ = false;
+    } else if (c == '"') {
+      ++p_;
+      out->type = Json::Type::kString;
+      String(&out->string);
+    } else if (Literal("null")) {
+      out->type = Json::Type::kNull;
+    } else if (Literal("true")) {
+      out->type = Json::Type::kBool;
+      out->number = 1;
+    } else if (Literal("false")) {
+      out->type = Json::Type::kBool;
+    } else {
+      char* next = nullptr;
+      out->type = Json::Type::kNumber;
+      out->number = std::strtod(p_, &next);
+      if (next == p_) ok_ = false;
+      p_ = next;
+    }
+  }
+
+  const char* p_;
+  const char* end_;
+  bool ok_ = true;
+};
+
+struct MachineState {
+  gb::Registers regs{};
+  bool ime = false;
+  std::vector<std::pair<uint16_t, uint8_t>> ram;
+};
+
+MachineState ParseState(const Json& json) {
+  MachineState state;
+  auto byte = [&](const char* key) {
+    return static_cast<uint8_t>(json.Int(key));
+  };
+  state.regs = gb::Registers{byte("a"), byte("f"), byte("b"), byte("c"),
+                             byte("d"), byte("e"), byte("h"), byte("l"),
+                             static_cast<uint16_t>(json.Int("sp")),
+                             static_cast<uint16_t>(json.Int("pc"))};
+  state.ime = json.Int("ime") != 0;
+  if (const Json* ram = json.Find("ram")) {
+    for (const Json& cell : ram->items) {
+      if (cell.items.size() < 2) continue;
+      state.ram.emplace_back(static_cast<uint16_t>(cell.items[0].number),
+                             static_cast<uint8_t>(cell.items[1].number));
+    }
+  }
+  return state;
+}
+
+struct Options {
+  fs::path vector_dir;
+  size_t jobs = 0;
+  bool prefetched = false;
+  bool check_timing = true;
+  size_t max_reports = 1; // Failing cases printed per file
+};
+
+struct FileResult {
+  std::string name;
+  size_t cases = 0;
+  size_t failed = 0;        // Wrong registers, IME or memory
+  size_t timing_failed = 0; // Right result, wrong cycle count
+  std::string report;
+  bool error = false;
+};
+
+std::string Hex(unsigned value, int width) {
+  std::ostringstream out;
+  out << std::hex;
+  out.width(width);
+  out.fill('0');
+  out << value;
+  return out.str();
+}
+
+// Describe every difference between the CPU/bus and the expected state;
+// empty when they match
+std::string Compare(const gb::BasicCpu<gb::FlatBus>& cpu,
+                    const gb::FlatBus& bus, const MachineState& want,
+                    uint16_t pc_adjust) {
+  std::ostringstream diff;
+  gb::Registers got = cpu.registers();
+  got.pc = static_cast<uint16_t>(got.pc + pc_adjust);
+  auto check = [&](const char* name, unsigned have, unsigned expect,
+                   int width) {
+    if (have != expect) {
+      diff << " " << name << "=" << Hex(have, width) << " (want "
+           << Hex(expect, width) << ")";
+    }
+  };
+  check("a", got.a, want.regs.a, 2);
+  check("f", got.f, want.regs.f, 2);
+  check("b", got.b, want.regs.b, 2);
+  check("c", got.c, want.regs.c, 2);
+  check("d", got.d, want.regs.d, 2);
+  check("e", got.e, want.regs.e, 2);
+  check("h", got.h, want.regs.h, 2);
+  check("l", got.l, want.regs.l, 2);
+  check("sp", got.sp, want.regs.sp, 4);
+  check("pc", got.pc, want.regs.pc, 4);
+  check("ime", cpu.ime(), want.ime, 1);
+  for (const auto& [address, value] : want.ram) {
+    if (bus.Read(address) != value) {
+      diff << " [" << Hex(address, 4) << "]=" << Hex(bus.Read(address), 2)
+           << " (want " << Hex(value, 2) << ")";
+    }
+  }
+  return diff.str();
+}
+
+FileResult RunFile(const fs::path& path, const Options& options) {
+  FileResult result;
+  result.name = path.filename().string();
+
+  std::ifstream in(path, std::ios::binary);
+  std::string text((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  Json cases;
+  if (!in.good() && !in.eof()) {
+    result.error = true;
+  } else if (!JsonParser(text.data(), text.data() + text.size())
+                  .Parse(&cases) ||
+             cases.type != Json::Type::kArray) {
+    result.error = true;
+  }
+  if (result.error) {
+    result.report = "  could not parse " + result.name + "\n";
+    return result;
+  }
+
+  auto bus = std::make_unique<gb::FlatBus>();
+  gb::BasicCpu<gb::FlatBus> cpu(*bus);
+  // The prefetched layout counts the overlapped fetch of the next opcode
+  // in the final PC
+  const uint16_t pc_adjust = options.prefetched ? 1 : 0;
+  std::ostringstream report;
+  size_t reported = 0;
+  for (const Json& test : cases.items) {
+    const Json* initial_json = test.Find("initial");
+    const Json* final_json = test.Find("final");
+    if (!initial_json || !final_json) continue;
+    MachineState initial = ParseState(*initial_json);
+    MachineState want = ParseState(*final_json);
+    ++result.cases;
+
+    cpu.Reset();
+    gb::Registers regs = initial.regs;
+    regs.pc = static_cast<uint16_t>(regs.pc - pc_adjust);
+    cpu.set_registers(regs);
+    cpu.set_ime(initial.ime);
+    for (const auto& [address, value] : initial.ram) {
+      bus->Write(address, value);
+    }
+
+    uint64_t start = cpu.cycles();
+    cpu.StepInstruction();
+    uint64_t cycles = cpu.cycles() - start;
+
+    std::string diff = Compare(cpu, *bus, want, pc_adjust);
+    const Json* expected_cycles = test.Find("cycles");
+    uint64_t want_cycles =
+        expected_cycles ? 4 * expected_cycles->items.size() : cycles;
+    bool timing_ok = cycles == want_cycles;
+    if (!diff.empty()) {
+      ++result.failed;
+    } else if (!timing_ok) {
+      ++result.timing_failed;
+    }
+    bool fails = !diff.empty() || (options.check_timing && !timing_ok);
+    if (fails && reported < options.max_reports) {
+      ++reported;
+      const Json* name = test.Find("name");
+      report << "  " << (name ? name->string : "?") << ":" << diff;
+      if (!timing_ok) {
+        report << " cycles=" << cycles << " (want " << want_cycles << ")";
+      }
+      report << "\n";
+    }
+
+    // Leave the bus zeroed for the next case
+    for (const auto& cell : initial.ram) bus->Write(cell.first, 0);
+    for (const auto& cell : want.ram) bus->Write(cell.first, 0);
+  }
+  result.report = report.str();
+  return result;
+}
+
+void PrintUsage(const char* argv0) {
+  std::cerr << "usage: " << argv0 << " <vector-dir> [options]\n"
+            << "  --jobs N          worker threads (default: all cores)\n"
+            << "  --prefetched      opcode at PC-1, already fetched\n"
+            << "  --ignore-timing   do not fail on cycle count mismatches\n"
+            << "  --report N        failing cases to print per file\n";
+}
+
+bool ParseArgs(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char* {
+      return i + 1 < argc ? argv[++i] : nullptr;
+    };
+    const char* v = nullptr;
+    if (arg == "--jobs" && (v = value())) {
+      options->jobs = std::strtoul(v, nullptr, 10);
+    } else if (arg == "--prefetched") {
+      options->prefetched = true;
+    } else if (arg == "--ignore-timing") {
+      options->check_timing = false;
+    } else if (arg == "--report" && (v = value())) {
+      options->max_reports = std::strtoul(v, nullptr, 10);
+    } else if (!arg.empty() && arg[0] != '-' && options->vector_dir.empty()) {
+      options->vector_dir = arg;
+    } else {
+      return false;
+    }
+  }
+  return !options->vector_dir.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+
+  std::vector<fs::path> files;
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator(options.vector_dir, ec)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".json") {
+      files.push_back(entry.path());
+    }
+  }
+  if (ec || files.empty()) {
+    std::cerr << "no test vectors in " << options.vector_dir << std::endl;
+    return 2;
+  }
+  std::sort(files.begin(), files.end());
+
+  auto start = Clock::now();
+  std::vector<FileResult> results(files.size());
+  {
+    gb::ThreadPool pool(options.jobs);
+    for (size_t i = 0; i < files.size(); ++i) {
+      pool.Submit([&, i] { results[i] = RunFile(files[i], options); });
+    }
+    pool.Wait();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  size_t cases = 0, failed = 0, timing_failed = 0, bad_files = 0;
+  for (const FileResult& r : results) {
+    cases += r.cases;
+    failed += r.failed;
+    timing_failed += r.timing_failed;
+    bool fails = r.error || r.failed ||
+                 (options.check_timing && r.timing_failed);
+    if (!fails) continue;
+    ++bad_files;
+    std::cout << "FAIL " << r.name << ": " << r.failed << "/" << r.cases
+              << " wrong, " << r.timing_failed << " mistimed\n"
+              << r.report;
+  }
+  std::cout << cases << " cases in " << files.size() << " files, "
+            << failed << " wrong, " << timing_failed << " mistimed, "
+            << bad_files << " failing files (" << seconds << "s)"
+            << std::endl;
+  return bad_files == 0 ? 0 : 1;
+}